@@ -0,0 +1,26 @@
+#!/bin/bash
+
+# Fires repeated multitouch input triggers, to be mapped
+# to source callbacks in the Input Mapping window.
+
+max=0
+if (( $# > 0 )); then
+    if (( $1 > 0 && $1 < 16 )); then
+        max=$1
+    fi
+fi
+
+sleep 2
+
+while :
+do
+   echo -n "."
+   # burst of presses on the same inputs
+   for i in $(seq 0 9); do
+       for t in $(seq 0 $max); do
+            oscsend localhost 7000 /vimix/multitouch/$t ff "0.$((RANDOM%9999))" "0.$((RANDOM%9999))"
+       done
+   done
+   # let inputs release
+   sleep 0.2
+done
@@ -0,0 +1,81 @@
+#version 330 core
+
+out vec4 FragColor;
+
+// from General Shader
+uniform vec3 iResolution;           // viewport image resolution (in pixels)
+
+// Compositing Shader : up to 8 layers, from back to front
+uniform int   iLayers;              // number of layers
+uniform mat4  iInverse[8];          // viewport to surface coordinates
+uniform mat4  iTexture[8];          // image transformation
+uniform vec4  iColor[8];            // uniform color
+uniform float iPremultiply[8];
+
+// input channels (texture id) and masks
+// NB: arrays of samplers can only be indexed by constants
+uniform sampler2D iChannel0;
+uniform sampler2D iChannel1;
+uniform sampler2D iChannel2;
+uniform sampler2D iChannel3;
+uniform sampler2D iChannel4;
+uniform sampler2D iChannel5;
+uniform sampler2D iChannel6;
+uniform sampler2D iChannel7;
+uniform sampler2D iMask0;
+uniform sampler2D iMask1;
+uniform sampler2D iMask2;
+uniform sampler2D iMask3;
+uniform sampler2D iMask4;
+uniform sampler2D iMask5;
+uniform sampler2D iMask6;
+uniform sampler2D iMask7;
+
+// same as image shader, blended over dst with pre-multiplied alpha
+vec4 layer(int i, sampler2D image, sampler2D mask, vec4 dst)
+{
+    // coordinates of the fragment in the surface
+    vec2 ndc = 2.0 * gl_FragCoord.xy / iResolution.xy - 1.0;
+    vec4 pos = iInverse[i] * vec4(ndc, 0.0, 1.0);
+    if ( abs(pos.x) > 1.0 || abs(pos.y) > 1.0 )
+        return dst;
+
+    // UV of the surface mesh
+    vec2 vertexUV = vec2(pos.x + 1.0, 1.0 - pos.y) * 0.5;
+
+    // adjust UV
+    vec4 texcoord = iTexture[i] * vec4(vertexUV.x, vertexUV.y, 0.0, 1.0);
+
+    // color is a mix of texture and uniform colors
+    // NB: no mipmap in frame buffers; level 0 is safe in non-uniform flow
+    vec4 textureColor = textureLod(image, texcoord.xy, 0.0);
+    vec3 RGB = textureColor.rgb * iColor[i].rgb;
+
+    // read mask intensity as average of RGB
+    float maskIntensity = dot(textureLod(mask, vertexUV, 0.0).rgb, vec3(1.0/3.0));
+
+    // alpha is a mix of texture, uniform and mask alpha
+    float A = clamp(textureColor.a * iColor[i].a * maskIntensity, 0.0, 1.0);
+
+    // RGB with Alpha pre-multiplied, clamped as when written in frame buffer
+    vec4 src = clamp( vec4(RGB * mix(1.0 / max(A, 0.001), A, iPremultiply[i]), A), 0.0, 1.0);
+
+    // blending opacity
+    return clamp( src + (1.0 - A) * dst, 0.0, 1.0);
+}
+
+void main()
+{
+    vec4 C = vec4(0.0);
+
+    if (iLayers > 0) C = layer(0, iChannel0, iMask0, C);
+    if (iLayers > 1) C = layer(1, iChannel1, iMask1, C);
+    if (iLayers > 2) C = layer(2, iChannel2, iMask2, C);
+    if (iLayers > 3) C = layer(3, iChannel3, iMask3, C);
+    if (iLayers > 4) C = layer(4, iChannel4, iMask4, C);
+    if (iLayers > 5) C = layer(5, iChannel5, iMask5, C);
+    if (iLayers > 6) C = layer(6, iChannel6, iMask6, C);
+    if (iLayers > 7) C = layer(7, iChannel7, iMask7, C);
+
+    FragColor = C;
+}
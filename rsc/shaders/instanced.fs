@@ -0,0 +1,22 @@
+#version 330 core
+
+out vec4 FragColor;
+
+in vec4 vertexColor;
+in vec2 vertexUV;
+
+uniform vec3 iResolution;           // viewport image resolution (in pixels)
+uniform bool iTextured;             // instances are textured
+
+uniform sampler2D iChannel0;        // input channel (texture id).
+
+void main()
+{
+    // color is a mix of vertex and instance colors, and texture if any
+    vec4 c = vertexColor;
+    if (iTextured)
+        c *= texture(iChannel0, vertexUV);
+
+    // output RGB with Alpha pre-multiplied
+    FragColor = vec4(c.rgb * c.a, c.a);
+}
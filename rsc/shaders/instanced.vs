@@ -0,0 +1,24 @@
+#version 330 core
+
+layout (location = 0) in vec3 position;
+layout (location = 1) in vec4 color;
+layout (location = 2) in vec2 texCoord;
+
+// per instance attributes
+layout (location = 3) in mat4 instanceModelview;
+layout (location = 7) in vec4 instanceColor;
+
+out vec4 vertexColor;
+out vec2 vertexUV;
+
+uniform mat4 projection;
+
+void main()
+{
+    vec4 pos = instanceModelview * vec4(position, 1.0);
+
+    // output
+    gl_Position = projection * pos;
+    vertexColor = color * instanceColor;
+    vertexUV    = texCoord;
+}
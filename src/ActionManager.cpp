@@ -33,6 +33,7 @@
 #include "Toolkit/BaseToolkit.h"
 #include "Interpolator.h"
 #include "Toolkit/SystemToolkit.h"
+#include "Journal.h"
 
 #include "ActionManager.h"
 
@@ -177,6 +178,10 @@ void Action::storeSession(Session *se, std::string label, bool thumbnail)
                         &Action::manager().history_doc_
                         );
 
+    // append changes to the journal
+    Journal::manager().append( Action::manager().history_doc_.FirstChildElement(
+                                   HISTORY_NODE(Action::manager().history_step_).c_str() ) );
+
     Action::manager().history_access_.unlock();
     
 #ifdef ACTION_DEBUG
@@ -289,6 +294,9 @@ void Action::restore(uint target)
 
         // actually restore
         Mixer::manager().restore(sessionNode);
+
+        // append changes to the journal
+        Journal::manager().append(sessionNode);
     }
 
     history_access_.unlock();
@@ -19,10 +19,13 @@
 
 #include <thread>
 #include <algorithm>
+#include <atomic>
+#include <cmath>
 
 #include <gst/pbutils/gstdiscoverer.h>
 #include <gst/pbutils/pbutils.h>
 #include <gst/gst.h>
+#include <gst/app/gstappsrc.h>
 
 #include "Settings.h"
 #include "Log.h"
@@ -33,7 +36,26 @@
 //#define AUDIO_DEBUG
 #endif
 
-Audio::Audio(): monitor_(nullptr), monitor_initialized_(false)
+// format of samples in the mixing bus
+#define AUDIO_MIXING_CHANNELS 2
+#define AUDIO_MIXING_CAPS "audio/x-raw,format=F32LE,layout=interleaved,rate=48000,channels=2"
+// inter audio channel to tap the mixing bus from another pipeline
+#define AUDIO_MIXING_TAP "vimix_audio_mixing"
+// decay of the peak level meter at each buffer
+#define AUDIO_LEVEL_DECAY 0.9f
+
+struct AudioChannel {
+    GstElement *src;
+    GstPad *pad;
+    // appsink feeding the channel (only compared, never dereferenced)
+    GstAppSink *sink;
+    std::atomic<float> volume;
+    std::atomic<float> level;
+    std::atomic<float> gain;
+    AudioChannel() : src(nullptr), pad(nullptr), sink(nullptr), volume(1.f), level(0.f), gain(1.f) { }
+};
+
+Audio::Audio(): monitor_(nullptr), monitor_initialized_(false), mixing_(nullptr), mixer_(nullptr)
 {
     std::thread(launchMonitoring, this).detach();
 }
@@ -366,3 +388,266 @@ void Audio::remove(GstDevice *device)
     // unlock access
     access_.unlock();
 }
+
+
+bool Audio::openMixing()
+{
+    // single mixer to the default output, and a tap for recording
+    std::string description = "audiomixer name=mixer ! audioconvert ! audioresample ! tee name=tap ";
+    description += "tap. ! queue ! autoaudiosink ";
+    GstElementFactory *inter = gst_element_factory_find ("interaudiosink");
+    if (inter) {
+        description += "tap. ! queue leaky=downstream ! interaudiosink channel=" AUDIO_MIXING_TAP;
+        gst_object_unref (inter);
+    }
+
+    GError *error = NULL;
+    mixing_ = gst_parse_launch (description.c_str(), &error);
+    if (error != NULL) {
+        Log::Warning("Audio mixing bus could not be created: %s", error->message);
+        g_clear_error (&error);
+        if (mixing_)
+            gst_object_unref (mixing_);
+        mixing_ = nullptr;
+        return false;
+    }
+    mixer_ = gst_bin_get_by_name (GST_BIN (mixing_), "mixer");
+
+    // report errors of the mixing bus
+    GstBus *bus = gst_element_get_bus (mixing_);
+    gst_bus_set_sync_handler (bus, callback_mixing_bus, NULL, NULL);
+    gst_object_unref (bus);
+
+    // the mixer waits for the inputs within the latency of a video frame
+    g_object_set (G_OBJECT (mixer_), "latency", (guint64) (40 * GST_MSECOND), NULL);
+
+    if ( gst_element_set_state (mixing_, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE ) {
+        Log::Warning("Audio mixing bus could not be started.");
+        gst_element_set_state (mixing_, GST_STATE_NULL);
+        gst_object_unref (mixer_);
+        gst_object_unref (mixing_);
+        mixer_ = nullptr;
+        mixing_ = nullptr;
+        return false;
+    }
+
+    Log::Info("Audio mixing bus started.");
+    return true;
+}
+
+GstBusSyncReply Audio::callback_mixing_bus (GstBus *, GstMessage *msg, gpointer)
+{
+    // only handle error messages
+    if (GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ERROR) {
+        GError *error;
+        gst_message_parse_error(msg, &error, NULL);
+        Log::Warning("Audio mixing bus : %s", error->message);
+        g_error_free(error);
+    }
+
+    // drop all messages to avoid filling up the stack
+    gst_message_unref (msg);
+    return GST_BUS_DROP;
+}
+
+void Audio::terminate()
+{
+    std::lock_guard<std::mutex> lock(mixing_access_);
+
+    if ( mixing_ == nullptr )
+        return;
+
+    // release inputs of the mixer
+    for (auto c = channels_.begin(); c != channels_.end(); ++c)
+        gst_object_unref (c->second->pad);
+    channels_.clear();
+
+    // stop and free the mixing bus
+    gst_element_set_state (mixing_, GST_STATE_NULL);
+    gst_object_unref (mixer_);
+    gst_object_unref (mixing_);
+    mixer_ = nullptr;
+    mixing_ = nullptr;
+}
+
+GstElement *Audio::createChannel(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mixing_access_);
+
+    if ( mixing_ == nullptr && !openMixing() )
+        return nullptr;
+
+    // sink for the pipeline of the media player, converting samples to the mixing format
+    GError *error = NULL;
+    GstElement *sink = gst_parse_bin_from_description ("audioconvert ! audioresample ! "
+                                                       "capsfilter caps=" AUDIO_MIXING_CAPS " ! "
+                                                       "appsink name=mixingsink", TRUE, &error);
+    if (error != NULL) {
+        Log::Warning("Audio mixing channel could not be created: %s", error->message);
+        g_clear_error (&error);
+        if (sink)
+            gst_object_unref (sink);
+        return nullptr;
+    }
+
+    // replace previous channel with same id
+    auto c = channels_.find(id);
+    std::shared_ptr<AudioChannel> channel = c != channels_.end() ? c->second : std::make_shared<AudioChannel>();
+
+    // live input of the mixer, timestamped on arrival
+    if (channel->src == nullptr) {
+        channel->src = gst_element_factory_make ("appsrc", NULL);
+        GstCaps *caps = gst_caps_from_string (AUDIO_MIXING_CAPS);
+        g_object_set (G_OBJECT (channel->src), "caps", caps, "is-live", TRUE,
+                     "format", GST_FORMAT_TIME, "do-timestamp", TRUE, "block", FALSE,
+                     "max-bytes", (guint64) (48000 * AUDIO_MIXING_CHANNELS * sizeof(float) / 5), NULL);
+        gst_caps_unref (caps);
+        gst_bin_add (GST_BIN (mixing_), channel->src);
+
+        channel->pad = gst_element_request_pad_simple (mixer_, "sink_%u");
+        GstPad *srcpad = gst_element_get_static_pad (channel->src, "src");
+        gst_pad_link (srcpad, channel->pad);
+        gst_object_unref (srcpad);
+        gst_element_sync_state_with_parent (channel->src);
+        channels_[id] = channel;
+    }
+
+    // samples of the media player are bridged to the mixer by the appsink
+    // (a previous appsink of the same media player stops feeding the channel)
+    GstElement *appsink = gst_bin_get_by_name (GST_BIN (sink), "mixingsink");
+    channel->sink = GST_APP_SINK (appsink);
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.new_sample = callback_mixing_sample;
+    gst_app_sink_set_callbacks (GST_APP_SINK (appsink), &callbacks, (gpointer) (guintptr) id, NULL);
+    gst_app_sink_set_emit_signals (GST_APP_SINK (appsink), false);
+    gst_base_sink_set_sync (GST_BASE_SINK (appsink), true);
+    gst_object_unref (appsink);
+
+    return sink;
+}
+
+void Audio::removeChannel(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mixing_access_);
+
+    auto c = channels_.find(id);
+    if ( c == channels_.end() )
+        return;
+
+    std::shared_ptr<AudioChannel> channel = c->second;
+    channels_.erase(c);
+
+    // disconnect from mixer and stop
+    GstPad *srcpad = gst_element_get_static_pad (channel->src, "src");
+    gst_pad_unlink (srcpad, channel->pad);
+    gst_object_unref (srcpad);
+    gst_element_release_request_pad (mixer_, channel->pad);
+    gst_object_unref (channel->pad);
+    gst_element_set_state (channel->src, GST_STATE_NULL);
+    gst_bin_remove (GST_BIN (mixing_), channel->src);
+}
+
+void Audio::setChannelVolume(uint64_t id, float v)
+{
+    std::lock_guard<std::mutex> lock(mixing_access_);
+
+    auto c = channels_.find(id);
+    if ( c != channels_.end() )
+        c->second->volume = CLAMP(v, 0.f, 1.f);
+}
+
+float Audio::channelVolume(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mixing_access_);
+
+    auto c = channels_.find(id);
+    return c != channels_.end() ? c->second->volume.load() : 1.f;
+}
+
+float Audio::channelLevel(uint64_t id)
+{
+    std::lock_guard<std::mutex> lock(mixing_access_);
+
+    auto c = channels_.find(id);
+    return c != channels_.end() ? c->second->level.load() : 0.f;
+}
+
+GstClock *Audio::mixingClock()
+{
+    std::lock_guard<std::mutex> lock(mixing_access_);
+
+    if ( mixing_ == nullptr )
+        return nullptr;
+
+    return gst_pipeline_get_clock (GST_PIPELINE (mixing_));
+}
+
+std::string Audio::mixingPipeline() const
+{
+    return "interaudiosrc channel=" AUDIO_MIXING_TAP;
+}
+
+GstFlowReturn Audio::callback_mixing_sample (GstAppSink *sink, gpointer p)
+{
+    GstSample *sample = gst_app_sink_pull_sample (sink);
+    if (sample == NULL)
+        return GST_FLOW_ERROR;
+
+    GstBuffer *buf = gst_sample_get_buffer (sample);
+    if (buf)
+        manager().mix( (uint64_t) (guintptr) p, sink, buf );
+
+    gst_sample_unref (sample);
+    return GST_FLOW_OK;
+}
+
+void Audio::mix(uint64_t id, GstAppSink *sink, GstBuffer *buf)
+{
+    // only look up the channel under lock: samples are processed and pushed outside
+    std::shared_ptr<AudioChannel> channel;
+    GstElement *src = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mixing_access_);
+
+        // channel may have been removed or created again while the pipeline terminates
+        auto c = channels_.find(id);
+        if ( c == channels_.end() || c->second->sink != sink )
+            return;
+        channel = c->second;
+        src = GST_ELEMENT (gst_object_ref (channel->src));
+    }
+
+    // writable copy of the samples
+    GstBuffer *out = gst_buffer_copy_deep (buf);
+    GstMapInfo map;
+    if ( gst_buffer_map (out, &map, GST_MAP_READWRITE) ) {
+        float *samples = (float *) map.data;
+        size_t frames = map.size / (sizeof(float) * AUDIO_MIXING_CHANNELS);
+
+        // linear ramp of gain from previous to target volume, sample by sample
+        float target = channel->volume;
+        float gain = channel->gain.load();
+        float step = frames > 0 ? (target - gain) / (float) frames : 0.f;
+        float peak = 0.f;
+        for (size_t f = 0; f < frames; ++f) {
+            gain += step;
+            for (size_t k = 0; k < AUDIO_MIXING_CHANNELS; ++k) {
+                float &s = samples[f * AUDIO_MIXING_CHANNELS + k];
+                s *= gain;
+                peak = std::max(peak, std::fabs(s));
+            }
+        }
+        channel->gain = target;
+
+        // peak meter with decay
+        channel->level = std::min( std::max(peak, channel->level * AUDIO_LEVEL_DECAY), 1.f);
+
+        gst_buffer_unmap (out, &map);
+    }
+
+    // timestamps are given by the live source of the mixer
+    GST_BUFFER_PTS (out) = GST_CLOCK_TIME_NONE;
+    GST_BUFFER_DTS (out) = GST_CLOCK_TIME_NONE;
+    gst_app_src_push_buffer (GST_APP_SRC (src), out);
+    gst_object_unref (src);
+}
@@ -5,8 +5,16 @@
 #include <mutex>
 #include <condition_variable>
 #include <vector>
+#include <map>
+#include <memory>
 
 #include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+
+// name of the internal mixing bus, in the list of audio devices for recording
+#define AUDIO_MIXING_NAME "Vimix audio mixing"
+
+struct AudioChannel;
 
 struct AudioHandle {
     std::string name;
@@ -31,6 +39,7 @@ public:
     }
 
     void initialize();
+    void terminate();
 
     int numDevices ();
     std::string name (int index);
@@ -42,6 +51,24 @@ public:
 
     static gboolean callback_audio_monitor (GstBus *, GstMessage *, gpointer);
 
+    /**
+     * Internal audio mixing bus
+     * Media players feed their audio into a channel of a single
+     * audiomixer pipeline, with one output device and one clock.
+     * */
+    // create a channel and return the sink element to use in its pipeline (nullptr on failure)
+    GstElement *createChannel (uint64_t id);
+    void removeChannel (uint64_t id);
+    // volume of a channel is ramped to the new value over the next buffer
+    void setChannelVolume (uint64_t id, float v);
+    float channelVolume (uint64_t id);
+    // peak level of the last samples of a channel, in [0 1]
+    float channelLevel (uint64_t id);
+    // clock of the mixing bus (to be unref after use)
+    GstClock *mixingClock ();
+    // pipeline element to record the output of the mixing bus
+    std::string mixingPipeline () const;
+
 private:
 
     static void launchMonitoring(Audio *d);
@@ -57,6 +84,15 @@ private:
     std::mutex access_;
     std::vector< AudioHandle > handles_;
 
+    bool openMixing();
+    void mix(uint64_t id, GstAppSink *sink, GstBuffer *buf);
+    static GstFlowReturn callback_mixing_sample (GstAppSink *, gpointer);
+    static GstBusSyncReply callback_mixing_bus (GstBus *, GstMessage *, gpointer);
+    GstElement *mixing_;
+    GstElement *mixer_;
+    std::mutex mixing_access_;
+    std::map< uint64_t, std::shared_ptr<AudioChannel> > channels_;
+
 };
 
 #endif // AUDIO_H
@@ -0,0 +1,332 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include <cmath>
+#include <chrono>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <thread>
+
+#include <glad/glad.h>
+#include <glib.h>
+
+#include "defines.h"
+#include "Log.h"
+#include "Session.h"
+#include "Scene/Scene.h"
+#include "Source/PatternSource.h"
+#include "Source/ShaderSource.h"
+#include "Source/CloneSource.h"
+#include "Profiler.h"
+#include "FrameSlots.h"
+
+#include "Benchmark.h"
+
+// maximum time to wait for sources to be ready
+#define BENCHMARK_TIMEOUT 10.0
+// frames rendered before measuring
+#define BENCHMARK_WARMUP 30
+// decoration nodes per source in synthetic scenes
+#define BENCHMARK_SCENE_NODES 32
+
+std::vector<Benchmark::Configuration> Benchmark::suite()
+{
+    std::vector<Configuration> configurations;
+    const float dt = 1000.f / 60.f;
+
+    configurations.push_back( { 1, glm::ivec2(1280, 720), 300, dt } );
+    configurations.push_back( { 4, glm::ivec2(1280, 720), 300, dt } );
+    configurations.push_back( { 4, glm::ivec2(1920, 1080), 300, dt } );
+    configurations.push_back( { 8, glm::ivec2(1920, 1080), 300, dt } );
+    configurations.push_back( { 4, glm::ivec2(3840, 2160), 120, dt } );
+
+    return configurations;
+}
+
+bool Benchmark::parse(const std::string &description, std::vector<Configuration> &configurations)
+{
+    std::istringstream stream(description);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        Configuration c = { 0, glm::ivec2(0), 300, 1000.f / 60.f };
+        int n = sscanf(item.c_str(), "%d:%dx%d:%d", &c.sources, &c.resolution.x, &c.resolution.y, &c.frames);
+        if (n < 3 || c.sources < 1 || c.resolution.x < 2 || c.resolution.y < 2 || c.frames < 1)
+            return false;
+        configurations.push_back(c);
+    }
+    return !configurations.empty();
+}
+
+static Session *create_session(const Benchmark::Configuration &c)
+{
+    Session *session = new Session;
+    session->setResolution( glm::vec3(c.resolution.x, c.resolution.y, 0.f) );
+
+    std::vector<Source *> sources;
+    for (int i = 0; i < c.sources; ++i) {
+
+        PatternSource *p = new PatternSource;
+        p->setPattern(i % Pattern::count(), c.resolution);
+        p->setName("Pattern " + std::to_string(i + 1));
+        sources.push_back(p);
+
+        ShaderSource *s = new ShaderSource;
+        s->setResolution( glm::vec3(c.resolution.x, c.resolution.y, 0.f) );
+        s->setName("Shader " + std::to_string(i + 1));
+        sources.push_back(s);
+
+        CloneSource *k = p->clone();
+        k->setName("Clone " + std::to_string(i + 1));
+        sources.push_back(k);
+
+        CloneSource *f = s->clone();
+        f->setFilter(FrameBufferFilter::FILTER_BLUR);
+        f->setName("Filter " + std::to_string(i + 1));
+        sources.push_back(f);
+    }
+
+    // place all sources in the mixing circle to be active and visible
+    for (size_t i = 0; i < sources.size(); ++i) {
+        float a = 2.f * M_PI * float(i) / float(sources.size());
+        sources[i]->group(View::MIXING)->translation_ = glm::vec3(0.5f * cos(a), 0.5f * sin(a), 0.f);
+        sources[i]->touch();
+        session->addSource(sources[i]);
+    }
+
+    return session;
+}
+
+// mean time in milisecond of the update of a synthetic scene graph,
+// built like the views of a session with 'groups' sources; if animated,
+// every source group moves at each frame
+static double update_scene(int groups, int frames, float dt, bool animated)
+{
+    Scene scene;
+    std::vector<Group *> sources;
+    for (int i = 0; i < groups; ++i) {
+        Group *g = new Group;
+        for (int j = 0; j < BENCHMARK_SCENE_NODES; ++j) {
+            Group *n = new Group;
+            n->translation_ = glm::vec3(0.f, 0.f, 0.01f * float(j));
+            n->rotation_.z = 0.1f * float(j);
+            g->attach(n);
+        }
+        g->translation_ = glm::vec3(0.01f * float(i), 0.f, 0.f);
+        g->scale_ = glm::vec3(0.5f);
+        scene.ws()->attach(g);
+        sources.push_back(g);
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        if (animated) {
+            for (auto g = sources.begin(); g != sources.end(); ++g)
+                (*g)->rotation_.z = 0.01f * float(f);
+        }
+        scene.update(dt);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return elapsed.count() / double(frames);
+}
+
+// mean time in milisecond to create a source (with all its decorations)
+static double create_sources(int count)
+{
+    std::vector<Source *> sources;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; ++i)
+        sources.push_back( new PatternSource );
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    for (auto s = sources.begin(); s != sources.end(); ++s)
+        delete *s;
+
+    return elapsed.count() / double(count);
+}
+
+static double percentile(const std::vector<double> &sorted, double p);
+
+// latency in milisecond between push of a frame by a producer thread
+// and its pop by the consumer, both running as fast as possible
+static std::string stress_frame_slots(int count)
+{
+    FrameSlots slots;
+
+    // producer stamps frames with the monotonic time, and ends with EOS
+    std::thread producer([&slots, count]() {
+        GstBuffer *buf = gst_buffer_new_allocate(NULL, 1920 * 1080 * 4, NULL);
+        for (int i = 0; i < count; ++i) {
+            buf->pts = g_get_monotonic_time() * GST_USECOND;
+            slots.push(buf, FrameSlots::SAMPLE);
+        }
+        slots.push(NULL, FrameSlots::EOS);
+        gst_buffer_unref(buf);
+    });
+
+    std::vector<double> latencies;
+    FrameSlots::Frame frame;
+    while ( true ) {
+        if ( slots.pop(frame) ) {
+            if (frame.status == FrameSlots::EOS)
+                break;
+            latencies.push_back( double(g_get_monotonic_time() * GST_USECOND - frame.position) / double(GST_MSECOND) );
+        }
+    }
+    producer.join();
+
+    double mean = 0.0;
+    for (auto l = latencies.begin(); l != latencies.end(); ++l)
+        mean += *l;
+    mean /= double(std::max(latencies.size(), (size_t) 1));
+    std::sort(latencies.begin(), latencies.end());
+
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3);
+    report << "{ \"pushed\": " << count << ", \"popped\": " << latencies.size();
+    report << ", \"latency\": { \"mean\": " << mean << ", \"p99\": " << percentile(latencies, 0.99);
+    report << ", \"max\": " << (latencies.empty() ? 0.0 : latencies.back()) << " } }";
+    return report.str();
+}
+
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t i = (size_t) std::ceil(p * double(sorted.size())) ;
+    return sorted[ std::min(std::max(i, (size_t) 1), sorted.size()) - 1 ];
+}
+
+static std::string json_string(const std::string &str)
+{
+    std::string out = "\"";
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+std::string Benchmark::run(const std::vector<Configuration> &configurations)
+{
+    std::ostringstream report;
+    report << std::fixed << std::setprecision(3);
+    report << "{\n  \"application\": " << json_string(APP_NAME);
+#ifdef VIMIX_VERSION_MAJOR
+    report << ",\n  \"version\": \"" << VIMIX_VERSION_MAJOR << "." << VIMIX_VERSION_MINOR << "." << VIMIX_VERSION_PATCH << "\"";
+#endif
+    const char *renderer = (const char *) glGetString(GL_RENDERER);
+    report << ",\n  \"renderer\": " << json_string(renderer ? renderer : "unknown");
+    report << ",\n  \"configurations\": [";
+
+    // per-stage breakdown given by the profiler
+    bool profiling = Profiler::manager().enabled();
+    Profiler::manager().setEnabled(true);
+
+    for (auto c = configurations.begin(); c != configurations.end(); ++c) {
+
+        Session *session = create_session(*c);
+        Profiler::manager().reset();
+
+        // wait for all sources to be ready (e.g. gstreamer pipelines of patterns)
+        GTimer *timer = g_timer_new ();
+        while ( !session->ready() && g_timer_elapsed(timer, NULL) < BENCHMARK_TIMEOUT ) {
+            session->update(c->dt);
+            g_usleep(1000);
+        }
+        g_timer_destroy(timer);
+        if (!session->ready())
+            Log::Warning("Benchmark sources not ready after %.0f seconds.", BENCHMARK_TIMEOUT);
+
+        // render frames and measure
+        std::vector<double> times;
+        for (int f = 0; f < BENCHMARK_WARMUP + c->frames; ++f) {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            Profiler::manager().beginFrame();
+            {
+                ProfileZone zone("Session update");
+                session->update(c->dt);
+            }
+            // include completion of rendering in the frame time
+            glFinish();
+            Profiler::manager().endFrame();
+            std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            if (f >= BENCHMARK_WARMUP)
+                times.push_back(elapsed.count());
+        }
+
+        double mean = 0.0;
+        for (auto t = times.begin(); t != times.end(); ++t)
+            mean += *t;
+        mean /= double(times.size());
+        std::sort(times.begin(), times.end());
+
+        report << (c == configurations.begin() ? "\n" : ",\n");
+        report << "    {\n      \"sources\": " << c->sources * 4;
+        report << ",\n      \"resolution\": [" << c->resolution.x << ", " << c->resolution.y << "]";
+        report << ",\n      \"frames\": " << c->frames;
+        report << ",\n      \"dt\": " << c->dt;
+        report << ",\n      \"ready\": " << (session->ready() ? "true" : "false");
+        report << ",\n      \"frame_time\": { \"mean\": " << mean
+               << ", \"p95\": " << percentile(times, 0.95)
+               << ", \"p99\": " << percentile(times, 0.99)
+               << ", \"max\": " << times.back() << " }";
+
+        // stages are running averages of the last frames, in milisecond
+        report << ",\n      \"stages\": [";
+        std::vector<Profiler::Statistics> stats = Profiler::manager().statistics();
+        for (auto s = stats.begin(); s != stats.end(); ++s) {
+            report << (s == stats.begin() ? "\n" : ",\n");
+            report << "        { \"name\": " << json_string(s->name);
+            if (!s->label.empty())
+                report << ", \"label\": " << json_string(s->label);
+            report << ", \"depth\": " << s->depth << ", \"cpu\": " << s->cpu;
+            if (s->gpu >= 0.0)
+                report << ", \"gpu\": " << s->gpu;
+            report << " }";
+        }
+        report << "\n      ]\n    }";
+
+        delete session;
+    }
+
+    Profiler::manager().setEnabled(profiling);
+
+    // update of large synthetic scene graphs, static or animated
+    report << "\n  ],\n  \"scene_graph\": [";
+    const int groups[] = { 100, 1000, 10000 };
+    for (size_t i = 0; i < sizeof(groups) / sizeof(int); ++i) {
+        const float dt = 1000.f / 60.f;
+        report << (i == 0 ? "\n" : ",\n");
+        report << "    { \"nodes\": " << groups[i] * (BENCHMARK_SCENE_NODES + 1);
+        report << ", \"static\": " << update_scene(groups[i], 300, dt, false);
+        report << ", \"animated\": " << update_scene(groups[i], 300, dt, true) << " }";
+    }
+
+    // creation of sources with their decorations
+    report << "\n  ],\n  \"source_creation\": { \"sources\": 50, \"mean\": " << create_sources(50) << " }";
+
+    // frames passed between streaming and rendering threads
+    report << ",\n  \"frame_slots\": " << stress_frame_slots(100000);
+
+    report << "\n}\n";
+    return report.str();
+}
@@ -0,0 +1,39 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+/**
+ * Benchmark renders synthetic sessions with a fixed number of frames
+ * and a fixed time step, and reports frame times and the per-stage
+ * breakdown of the Profiler in JSON. The report ends with the mean
+ * update time of large synthetic scene graphs (static and animated),
+ * the mean time to create a source, and the latency of frames passed
+ * between a producer and a consumer thread.
+ *
+ * Requires an initialized Rendering manager; the main window is not shown.
+ * Software rendering can be forced with LIBGL_ALWAYS_SOFTWARE=1 (Mesa llvmpipe).
+ */
+namespace Benchmark
+{
+    struct Configuration {
+        int sources;            // number of sources of each kind
+        glm::ivec2 resolution;  // session and sources resolution
+        int frames;             // number of frames measured
+        float dt;               // time step in milisecond
+    };
+
+    // default suite of configurations
+    std::vector<Configuration> suite();
+
+    // parse a list of configurations 'N:WxH[:F]' separated by commas
+    // e.g. '8:1920x1080,16:1280x720:600'
+    bool parse(const std::string &description, std::vector<Configuration> &configurations);
+
+    // run the configurations and return the report in JSON
+    std::string run(const std::vector<Configuration> &configurations);
+}
+
+#endif // BENCHMARK_H
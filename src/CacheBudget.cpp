@@ -0,0 +1,51 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "Settings.h"
+
+#include "CacheBudget.h"
+
+CacheBudget::CacheBudget() : usage_(0)
+{
+}
+
+uint64_t CacheBudget::budget () const
+{
+    return (uint64_t) Settings::application.render.clip_cache_budget * 1048576;
+}
+
+bool CacheBudget::reserve (uint64_t size, uint64_t *available)
+{
+    uint64_t b = budget();
+
+    uint64_t used = usage_.fetch_add(size);
+    if ( used + size > b ) {
+        usage_ -= size;
+        if (available)
+            *available = used < b ? b - used : 0;
+        return false;
+    }
+
+    return true;
+}
+
+void CacheBudget::release (uint64_t size)
+{
+    usage_ -= size;
+}
@@ -0,0 +1,46 @@
+#ifndef CACHEBUDGET_H
+#define CACHEBUDGET_H
+
+#include <atomic>
+#include <cstdint>
+
+///
+/// \brief The CacheBudget manager shares the memory allowed
+/// for caching decoded frames (Settings render.clip_cache_budget)
+/// among the clips of media players and the image sequences.
+///
+/// Caches must reserve their size before allocating their frames
+/// and release it once freed (from any thread).
+///
+class CacheBudget
+{
+    // Private Constructor
+    CacheBudget();
+    CacheBudget(CacheBudget const& copy) = delete;
+    CacheBudget& operator=(CacheBudget const& copy) = delete;
+
+public:
+
+    static CacheBudget& manager ()
+    {
+        // The only instance
+        static CacheBudget _instance;
+        return _instance;
+    }
+
+    // admission of 'size' bytes in budget; if refused, gives the bytes still available
+    bool reserve (uint64_t size, uint64_t *available = nullptr);
+    // give back 'size' bytes previously reserved
+    void release (uint64_t size);
+
+    // memory reserved by all caches, in bytes
+    inline uint64_t usage () const { return usage_; }
+    // memory allowed for all caches, in bytes
+    uint64_t budget () const;
+
+private:
+
+    std::atomic<uint64_t> usage_;
+};
+
+#endif // CACHEBUDGET_H
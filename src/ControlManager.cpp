@@ -51,6 +51,7 @@
 #include "Streamer.h"
 #include "VideoBroadcast.h"
 #include "FrameGrabbing.h"
+#include "Profiler.h"
 
 #include "ControlManager.h"
 
@@ -120,6 +121,11 @@ void Control::RequestListener::ProcessMessage( const osc::ReceivedMessage& m,
             {
                 Control::manager().receiveMultitouchAttribute(attribute, m.ArgumentStream());
             }
+            // Profiler target: measure and export timing of rendering
+            else if ( target.compare(OSC_PROFILER) == 0 )
+            {
+                Control::manager().receiveProfilerAttribute(attribute, m.ArgumentStream());
+            }
             // Session target: concerns attributes of the session
             else if ( target.compare(OSC_SESSION) == 0 )
             {
@@ -1330,6 +1336,11 @@ bool Control::receiveSessionAttribute(const std::string &attribute,
                 tv->play(true);
             }
         }
+        else if ( attribute.compare(OSC_SESSION_CUE) == 0) {
+            const char *filename;
+            arguments >> filename >> osc::EndMessage;
+            Mixer::manager().cue(filename);
+        }
         else if ( attribute.compare(OSC_SESSION_SAVE) == 0) {
             Mixer::manager().save();
         }
@@ -1414,6 +1425,46 @@ void Control::receiveMultitouchAttribute(const std::string &attribute,
 }
 
 
+void Control::receiveProfilerAttribute(const std::string &attribute,
+                                       osc::ReceivedMessageArgumentStream arguments)
+{
+    try {
+        /// e.g. '/vimix/profiler/enable'
+        if ( attribute.compare(OSC_PROFILER_ENABLE) == 0) {
+            arguments >> osc::EndMessage;
+            Profiler::manager().setEnabled(true);
+        }
+        /// e.g. '/vimix/profiler/disable'
+        else if ( attribute.compare(OSC_PROFILER_DISABLE) == 0) {
+            arguments >> osc::EndMessage;
+            Profiler::manager().setEnabled(false);
+        }
+        /// e.g. '/vimix/profiler/export' or '/vimix/profiler/export s "/tmp/trace.json"'
+        else if ( attribute.compare(OSC_PROFILER_EXPORT) == 0) {
+            std::string filename;
+            if ( !arguments.Eos()) {
+                const char *str;
+                arguments >> str;
+                filename = str;
+            }
+            arguments >> osc::EndMessage;
+            Profiler::manager().requestExport(filename);
+        }
+        else
+            Log::Info(CONTROL_OSC_MSG "Unknown attribute '%s' for target %s.", attribute.c_str(), OSC_PROFILER);
+    }
+    catch (osc::MissingArgumentException &e) {
+        Log::Info(CONTROL_OSC_MSG "Missing argument for attribute '%s' for target %s.", attribute.c_str(), OSC_PROFILER);
+    }
+    catch (osc::ExcessArgumentException &e) {
+        Log::Info(CONTROL_OSC_MSG "Too many arguments for attribute '%s' for target %s.", attribute.c_str(), OSC_PROFILER);
+    }
+    catch (osc::WrongArgumentTypeException &e) {
+        Log::Info(CONTROL_OSC_MSG "Invalid argument for attribute '%s' for target %s.", attribute.c_str(), OSC_PROFILER);
+    }
+}
+
+
 void Control::receiveStreamAttribute(const std::string &attribute,
                                      osc::ReceivedMessageArgumentStream arguments,
                                      const std::string &sender)
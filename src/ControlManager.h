@@ -85,12 +85,18 @@
 #define OSC_SESSION            "/session"
 #define OSC_SESSION_VERSION    "/version"
 #define OSC_SESSION_OPEN       "/open"
+#define OSC_SESSION_CUE        "/cue"
 #define OSC_SESSION_SAVE       "/save"
 #define OSC_SESSION_CLOSE      "/close"
 
 #define OSC_STREAM             "/peertopeer"
 #define OSC_MULTITOUCH         "/multitouch"
 
+#define OSC_PROFILER           "/profiler"
+#define OSC_PROFILER_ENABLE    "/enable"
+#define OSC_PROFILER_DISABLE   "/disable"
+#define OSC_PROFILER_EXPORT    "/export"
+
 #define INPUT_UNDEFINED        0
 #define INPUT_KEYBOARD_FIRST   1
 #define INPUT_KEYBOARD_COUNT   25
@@ -172,6 +178,8 @@ protected:
                             osc::ReceivedMessageArgumentStream arguments);
     void receiveMultitouchAttribute(const std::string &attribute,
                                     osc::ReceivedMessageArgumentStream arguments);
+    void receiveProfilerAttribute(const std::string &attribute,
+                                  osc::ReceivedMessageArgumentStream arguments);
     void sendSourceAttibutes(const IpEndpointName& remoteEndpoint,
                                     osc::ReceivedMessageArgumentStream arguments,
                                     std::string target, Source *s = nullptr);
@@ -34,6 +34,7 @@
 #include "Source/Source.h"
 
 #include "Mixer.h"
+#include "Profiler.h"
 
 #include "ImageFilter.h"
 
@@ -348,7 +349,8 @@ void ImageFilteringShader::copy(ImageFilteringShader const& S)
 ///                                 ////
 ////////////////////////////////////////
 
-ImageFilter::ImageFilter (): FrameBufferFilter(), buffers_({nullptr, nullptr})
+ImageFilter::ImageFilter (): FrameBufferFilter(), buffers_({nullptr, nullptr}),
+    input_texture_(0), input_resolution_(glm::vec3(0.f))
 {
     // surface and shader for first pass
     shaders_.first  = new ImageFilteringShader;
@@ -436,14 +438,27 @@ glm::vec3 ImageFilter::resolution () const
     return glm::vec3(1,1,0);
 }
 
+bool ImageFilter::inputChanged (FrameBuffer *input) const
+{
+    return input_ != input || input_texture_ != input->texture() || input_resolution_ != input->resolution();
+}
+
+void ImageFilter::setInput (FrameBuffer *input)
+{
+    input_ = input;
+    input_texture_ = input_->texture();
+    input_resolution_ = input_->resolution();
+}
+
 void ImageFilter::draw (FrameBuffer *input)
 {
+    ProfileZone zone("Filter");
     bool forced = false;
 
     // if input changed (typically on first draw)
-    if (input_ != input || buffers_.first == nullptr || buffers_.second == nullptr) {
+    if (inputChanged(input) || buffers_.first == nullptr || buffers_.second == nullptr) {
         // keep reference to input framebuffer
-        input_ = input;
+        setInput(input);
         // create first-pass surface and shader, taking as texture the input framebuffer
         surfaces_.first->setTextureIndex( input_->texture() );
         shaders_.first->secondary_texture = input_->texture();
@@ -773,9 +788,9 @@ void ResampleFilter::draw (FrameBuffer *input)
         setFactor( RESAMPLE_DOUBLE );
 
     // if input changed (typically on first draw)
-    if (input_ != input) {
+    if (inputChanged(input)) {
         // keep reference to input framebuffer
-        input_ = input;
+        setInput(input);
 
         // create first-pass surface and shader, taking as texture the input framebuffer
         surfaces_.first->setTextureIndex( input_->texture() );
@@ -915,9 +930,9 @@ void BlurFilter::draw (FrameBuffer *input)
         setMethod( BLUR_GAUSSIAN );
 
     // if input changed (typically on first draw)
-    if (input_ != input || buffers_.first == nullptr || buffers_.second == nullptr) {
+    if (inputChanged(input) || buffers_.first == nullptr || buffers_.second == nullptr) {
         // keep reference to input framebuffer
-        input_ = input;
+        setInput(input);
 
         // create zero-pass surface taking as texture the input framebuffer
         mipmap_surface_->setTextureIndex( input_->texture() );
@@ -173,6 +173,12 @@ protected:
     std::pair< FrameBuffer *, FrameBuffer * > buffers_;
     std::pair< ImageFilteringShader *, ImageFilteringShader *> shaders_;
     void updateParameters();
+
+    // detect change of input framebuffer, e.g. resized by level of detail
+    uint input_texture_;
+    glm::vec3 input_resolution_;
+    bool inputChanged (FrameBuffer *input) const;
+    void setInput (FrameBuffer *input);
 };
 
 
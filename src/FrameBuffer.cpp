@@ -23,6 +23,7 @@
 #include "Resource.h"
 #include "Settings.h"
 #include "Log.h"
+#include "Shader.h"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -249,6 +250,10 @@ void FrameBuffer::resize(glm::vec3 res)
 
 void FrameBuffer::begin(bool clear)
 {
+    // pending draws (e.g. instanced meshes) go to the previous target
+    if (Shader::before_use)
+        Shader::before_use();
+
     if (!framebufferid_)
         init();
 
@@ -262,6 +267,9 @@ void FrameBuffer::begin(bool clear)
 
 void FrameBuffer::end()
 {    
+    if (Shader::before_use)
+        Shader::before_use();
+
     // if multisampling frame buffer
     if (flags_ & FrameBuffer_multisampling) {
         // blit the multisample FBO into unisample FBO to generate 2D texture
@@ -65,6 +65,9 @@ protected:
     // only FrameGrabbing manager can add frame
     virtual void addFrame(GstBuffer *buffer, GstCaps *read_caps, GstCaps *write_caps);
     virtual void addFrame(guint texture_id, GstCaps *read_caps, GstCaps *write_caps) {}
+    // grabbers reading the pixels in place, from the mapped PBO memory (no buffer allocated)
+    virtual bool mapped() const { return false; }
+    virtual void addFrame(const unsigned char *pixels, GstCaps *read_caps, GstCaps *write_caps) {}
 
     // only addFrame method shall call those
     virtual std::string init(GstCaps *read_caps, GstCaps *write_caps) = 0;
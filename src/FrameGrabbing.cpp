@@ -35,7 +35,7 @@
 
 
 FrameGrabbing::FrameGrabbing(): pbo_index_(0), pbo_next_index_(0), read_size_(0),
-    write_width_(0), write_height_(0), use_alpha_(0), read_caps_(NULL)
+    write_width_(0), write_height_(0), use_alpha_(0), last_buffer_(NULL), last_changed_(true), read_caps_(NULL)
 {
     pbo_[0] = 0;
     pbo_[1] = 0;
@@ -47,6 +47,8 @@ FrameGrabbing::~FrameGrabbing()
     clearAll();
 
     // cleanup
+    if (last_buffer_)
+        gst_buffer_unref (last_buffer_);
     if (read_caps_)
         gst_caps_unref (read_caps_);
 
@@ -151,7 +153,7 @@ void FrameGrabbing::clearAll()
 }
 
 
-void FrameGrabbing::grabFrame(FrameBuffer *frame_buffer, guint64 dt_millisec)
+void FrameGrabbing::grabFrame(FrameBuffer *frame_buffer, guint64 dt_millisec, bool changed)
 {
     // invalid frame buffer
     if (frame_buffer == nullptr)
@@ -191,6 +193,11 @@ void FrameGrabbing::grabFrame(FrameBuffer *frame_buffer, guint64 dt_millisec)
         pbo_index_ = 0;
         pbo_next_index_ = 0;
 
+        // forget last frame
+        if (last_buffer_)
+            gst_buffer_unref (last_buffer_);
+        last_buffer_ = NULL;
+
         // new caps
         if (read_caps_)
             gst_caps_unref (read_caps_);
@@ -220,47 +227,86 @@ void FrameGrabbing::grabFrame(FrameBuffer *frame_buffer, guint64 dt_millisec)
         fgType(FrameGrabber::GRABBER_GPU)
     );
 
+    // separate CPU grabbers reading pixels in place from the mapped PBO
+    std::list<FrameGrabber *> mapped_grabbers_;
+    bool mapped_waiting = false;
+    for (auto it = cpu_grabbers_.begin(); it != cpu_grabbers_.end(); ) {
+        if ( (*it)->mapped() ) {
+            // a mapped grabber is initialized by its first frame
+            mapped_waiting |= !(*it)->initialized_;
+            mapped_grabbers_.push_back(*it);
+            it = cpu_grabbers_.erase(it);
+        }
+        else
+            ++it;
+    }
+
     // feed CPU grabbers with frame_buffer texture index
-    if (!cpu_grabbers_.empty()) {
+    if (!cpu_grabbers_.empty() || !mapped_grabbers_.empty()) {
 
         GstBuffer *buffer = nullptr;
 
-        // set buffer target for writing in a new frame
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[pbo_index_]);
+        // Frame unchanged since the one read in previous PBO, which was given last:
+        // no need to read the frame buffer, repeat the last frame
+        // (NB: copy shares the memory and allows new timestamps)
+        // Mapped grabbers keep their last frame: nothing to give them, unless waiting for their first.
+        if ( !changed && !last_changed_ && !mapped_waiting && (last_buffer_ != NULL || cpu_grabbers_.empty()) ) {
+            if (!cpu_grabbers_.empty())
+                buffer = gst_buffer_copy(last_buffer_);
+        }
+        else {
+            // set buffer target for writing in a new frame
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[pbo_index_]);
 
-        // get frame (this takes into account projection area)
-        frame_buffer->readPixels();
+            // get frame (this takes into account projection area)
+            frame_buffer->readPixels();
 
-        // update case ; alternating indices
-        if ( pbo_next_index_ != pbo_index_ ) {
+            // update case ; alternating indices
+            if ( pbo_next_index_ != pbo_index_ ) {
 
-            // set buffer target for saving the frame
-            glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[pbo_next_index_]);
+                // set buffer target for saving the frame
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[pbo_next_index_]);
 
-            // new buffer
-            buffer = gst_buffer_new_and_alloc (read_size_);
+                // map PBO pixels into a memory READ pointer
+                unsigned char* ptr = (unsigned char*) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
 
-            // map gst buffer into a memory  WRITE target
-            GstMapInfo map;
-            gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+                if (NULL != ptr) {
+                    // give pixels in place to mapped grabbers
+                    for (auto it = mapped_grabbers_.begin(); it != mapped_grabbers_.end(); ++it)
+                        (*it)->addFrame(ptr, read_caps_, write_caps_);
 
-            // map PBO pixels into a memory READ pointer
-            unsigned char* ptr = (unsigned char*) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+                    if (!cpu_grabbers_.empty()) {
+                        // new buffer
+                        buffer = gst_buffer_new_and_alloc (read_size_);
 
-            // transfer pixels from PBO memory to buffer memory
-            if (NULL != ptr)
-                memmove(map.data, ptr, read_size_);
+                        // map gst buffer into a memory  WRITE target
+                        GstMapInfo map;
+                        gst_buffer_map (buffer, &map, GST_MAP_WRITE);
 
-            // un-map
-            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
-            gst_buffer_unmap (buffer, &map);
-        }
+                        // transfer pixels from PBO memory to buffer memory
+                        memmove(map.data, ptr, read_size_);
 
-        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+                        gst_buffer_unmap (buffer, &map);
+                    }
+                }
 
-        // alternate indices
-        pbo_next_index_ = pbo_index_;
-        pbo_index_ = (pbo_index_ + 1) % 2;
+                // un-map
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            // alternate indices
+            pbo_next_index_ = pbo_index_;
+            pbo_index_ = (pbo_index_ + 1) % 2;
+
+            // keep last frame given
+            // (or forget it if not read for CPU grabbers: it is outdated)
+            if (last_buffer_)
+                gst_buffer_unref (last_buffer_);
+            last_buffer_ = buffer != nullptr ? gst_buffer_ref (buffer) : NULL;
+        }
+        last_changed_ = changed;
 
         // a frame was successfully grabbed
         if ( buffer != nullptr && gst_buffer_get_size(buffer) > 0) {
@@ -296,6 +342,31 @@ void FrameGrabbing::grabFrame(FrameBuffer *frame_buffer, guint64 dt_millisec)
             // unref / free the frame
             gst_buffer_unref(buffer);
         }
+
+        // remove finished mapped grabbers
+        std::list<FrameGrabber *>::iterator iter = mapped_grabbers_.begin();
+        while (iter != mapped_grabbers_.end())
+        {
+            FrameGrabber *rec = *iter;
+
+            uint64_t max_duration = grabbers_duration_.count(rec) ? grabbers_duration_[rec] : 0;
+            if (max_duration > 0 && rec->duration() >= max_duration - rec->frameDuration() * 2)
+                rec->stop();
+
+            if (rec->finished()) {
+                // terminate and remove from main grabbers list
+                rec->terminate();
+                grabbers_.remove(rec);
+                grabbers_duration_.erase(rec);
+                // remove from local list and iterate
+                iter = mapped_grabbers_.erase(iter);
+                if (rec->type() == FrameGrabber::GRABBER_P2P)
+                    Streaming::manager().removeStream(dynamic_cast<VideoStreamer*>(rec));
+                delete rec;
+            }
+            else
+                ++iter;
+        }
     }
 
     // feed GPU grabbers with frame_buffer texture index
@@ -126,10 +126,13 @@ protected:
      * @brief Capture current frame and distribute to all active grabbers
      * @param frame_buffer The FrameBuffer containing the rendered frame
      *
+     * @param changed False if the frame is the same as the previous one
+     *
      * Called by Session after each render. Uses PBOs for efficient GPU readback.
+     * An unchanged frame is not read back: the last frame is repeated.
      * Only accessible to friend class Mixer.
      */
-    void grabFrame(FrameBuffer *frame_buffer, guint64 dt_millisec);
+    void grabFrame(FrameBuffer *frame_buffer, guint64 dt_millisec, bool changed = true);
 
 private:
     std::list<FrameGrabber *> grabbers_;
@@ -144,6 +147,8 @@ private:
     guint write_width_;
     guint write_height_;
     bool  use_alpha_;
+    GstBuffer *last_buffer_;
+    bool  last_changed_;
     GstCaps *read_caps_;
     GstCaps *write_caps_;
 };
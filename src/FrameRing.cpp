@@ -0,0 +1,299 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include <cstring>
+
+#if defined(LINUX)
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "FrameRing.h"
+
+#define FRAMERING_MAGIC 0x564d5852  // 'VMXR'
+// pixels of slots start after the header, on a page boundary
+#define FRAMERING_OFFSET 4096
+
+// shared among processes at the beginning of the memory
+struct FrameRing::Header {
+    uint32_t magic;
+    uint32_t width;
+    uint32_t height;
+    uint32_t channels;
+    uint64_t slot_size;
+    // sequence number of the latest frame published (0 if none)
+    std::atomic<uint32_t> sequence;
+    // producer has stopped
+    std::atomic<uint32_t> closed;
+    // sequence number of the frame in each slot (0 while writing)
+    std::atomic<uint32_t> slot[FRAMERING_SLOTS];
+};
+
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free,
+              "FrameRing requires lock-free atomics in shared memory");
+
+FrameRing::FrameRing() : header_(nullptr), slots_(nullptr), size_(0),
+    width_(0), height_(0), channels_(0), fd_(-1), socket_(-1)
+{
+}
+
+bool FrameRing::available()
+{
+#if defined(LINUX)
+    return true;
+#else
+    return false;
+#endif
+}
+
+FrameRing *FrameRing::create(const std::string &path, uint32_t width, uint32_t height, uint32_t channels)
+{
+#if defined(LINUX)
+    if ( width < 1 || height < 1 || channels < 1 || path.size() >= sizeof(sockaddr_un::sun_path) )
+        return nullptr;
+
+    // anonymous shared memory, large enough for header and slots
+    int fd = memfd_create("vimix-frames", MFD_CLOEXEC);
+    if ( fd < 0 )
+        return nullptr;
+    size_t slot_size = (size_t) width * height * channels;
+    if ( ftruncate(fd, FRAMERING_OFFSET + FRAMERING_SLOTS * slot_size) != 0 ) {
+        ::close(fd);
+        return nullptr;
+    }
+
+    FrameRing *ring = new FrameRing;
+    if ( !ring->map(fd, true) ) {
+        delete ring;
+        return nullptr;
+    }
+
+    // initialize header (memory is zero-filled)
+    ring->header_->width = ring->width_ = width;
+    ring->header_->height = ring->height_ = height;
+    ring->header_->channels = ring->channels_ = channels;
+    ring->header_->slot_size = slot_size;
+    ring->header_->magic = FRAMERING_MAGIC;
+
+    // local socket to give the file descriptor to consumers
+    ring->socket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    unlink(path.c_str());
+    if ( ring->socket_ < 0 || bind(ring->socket_, (sockaddr *) &addr, sizeof(addr)) != 0
+         || listen(ring->socket_, 8) != 0 ) {
+        delete ring;
+        return nullptr;
+    }
+    ring->path_ = path;
+    ring->server_ = std::thread(FrameRing::serve, ring);
+
+    return ring;
+#else
+    return nullptr;
+#endif
+}
+
+void FrameRing::serve(FrameRing *ring)
+{
+#if defined(LINUX)
+    // give file descriptor to each consumer connecting
+    // (ends when the socket is shut down)
+    int c = -1;
+    while ( (c = accept(ring->socket_, NULL, NULL)) >= 0 ) {
+        char byte = 0;
+        iovec io = { &byte, 1 };
+        char control[CMSG_SPACE(sizeof(int))];
+        memset(control, 0, sizeof(control));
+        msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &io;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(cmsg), &ring->fd_, sizeof(int));
+        sendmsg(c, &msg, MSG_NOSIGNAL);
+        ::close(c);
+    }
+#endif
+}
+
+FrameRing *FrameRing::connect(const std::string &path)
+{
+#if defined(LINUX)
+    if ( path.size() >= sizeof(sockaddr_un::sun_path) )
+        return nullptr;
+
+    int s = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if ( s < 0 )
+        return nullptr;
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if ( ::connect(s, (sockaddr *) &addr, sizeof(addr)) != 0 ) {
+        ::close(s);
+        return nullptr;
+    }
+
+    // receive file descriptor of the shared memory
+    char byte = 0;
+    iovec io = { &byte, 1 };
+    char control[CMSG_SPACE(sizeof(int))];
+    msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &io;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    int fd = -1;
+    if ( recvmsg(s, &msg, MSG_CMSG_CLOEXEC) > 0 ) {
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        if ( cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS )
+            memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+    }
+    ::close(s);
+    if ( fd < 0 )
+        return nullptr;
+
+    FrameRing *ring = new FrameRing;
+    if ( !ring->map(fd, false) ) {
+        delete ring;
+        return nullptr;
+    }
+
+    return ring;
+#else
+    return nullptr;
+#endif
+}
+
+bool FrameRing::map(int fd, bool producer)
+{
+#if defined(LINUX)
+    fd_ = fd;
+
+    struct stat st;
+    if ( fstat(fd_, &st) != 0 || st.st_size <= FRAMERING_OFFSET )
+        return false;
+    size_ = st.st_size;
+
+    void *m = mmap(NULL, size_, producer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+    if ( m == MAP_FAILED )
+        return false;
+    header_ = static_cast<Header *>(m);
+    slots_ = static_cast<unsigned char *>(m) + FRAMERING_OFFSET;
+
+    // consumer: validate header
+    if ( !producer ) {
+        if ( header_->magic != FRAMERING_MAGIC ||
+             FRAMERING_OFFSET + FRAMERING_SLOTS * header_->slot_size > size_ )
+            return false;
+        width_ = header_->width;
+        height_ = header_->height;
+        channels_ = header_->channels;
+    }
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+FrameRing::~FrameRing()
+{
+#if defined(LINUX)
+    // producer: stop serving consumers
+    if ( socket_ >= 0 ) {
+        close();
+        shutdown(socket_, SHUT_RDWR);
+        if ( server_.joinable() )
+            server_.join();
+        ::close(socket_);
+        unlink(path_.c_str());
+    }
+
+    // NB: the memory is freed when unmapped by all processes
+    if ( header_ )
+        munmap(header_, size_);
+    if ( fd_ >= 0 )
+        ::close(fd_);
+#endif
+}
+
+unsigned char *FrameRing::next()
+{
+    uint32_t n = header_->sequence.load(std::memory_order_relaxed) + 1;
+    uint32_t i = n % FRAMERING_SLOTS;
+
+    // invalidate slot before writing
+    header_->slot[i].store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    return slots_ + i * header_->slot_size;
+}
+
+void FrameRing::publish()
+{
+    uint32_t n = header_->sequence.load(std::memory_order_relaxed) + 1;
+
+    header_->slot[n % FRAMERING_SLOTS].store(n, std::memory_order_release);
+    header_->sequence.store(n, std::memory_order_release);
+}
+
+void FrameRing::close()
+{
+    if ( header_ )
+        header_->closed.store(1, std::memory_order_release);
+}
+
+const unsigned char *FrameRing::latest(uint32_t &sequence) const
+{
+    uint32_t n = header_->sequence.load(std::memory_order_acquire);
+    if ( n == 0 || n == sequence )
+        return nullptr;
+
+    // slot is being overwritten
+    uint32_t i = n % FRAMERING_SLOTS;
+    if ( header_->slot[i].load(std::memory_order_acquire) != n )
+        return nullptr;
+
+    sequence = n;
+    return slots_ + i * header_->slot_size;
+}
+
+bool FrameRing::valid(uint32_t sequence) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return header_->slot[sequence % FRAMERING_SLOTS].load(std::memory_order_relaxed) == sequence;
+}
+
+bool FrameRing::closed() const
+{
+    return header_->closed.load(std::memory_order_acquire) > 0;
+}
@@ -0,0 +1,81 @@
+#ifndef FRAMERING_H
+#define FRAMERING_H
+
+#include <string>
+#include <atomic>
+#include <thread>
+#include <cstdint>
+
+// number of frames in the ring
+#define FRAMERING_SLOTS 3
+
+///
+/// \brief The FrameRing shares frames between vimix instances on the same host
+/// in a ring of slots of shared memory (memfd, Linux only).
+///
+/// The producer writes pixels directly in the next slot and publishes it by
+/// incrementing the sequence number of the ring. The consumer reads the latest
+/// slot published, directly from the shared memory. No copy is made in between.
+///
+/// The file descriptor of the shared memory is given to the consumer through
+/// a local socket (at the path given to create and connect).
+///
+/// Each slot holds the sequence number of its frame, which is invalidated
+/// while writing: the consumer can test that a slot was not overwritten
+/// during reading.
+///
+class FrameRing
+{
+public:
+
+    // create the ring of frames, and accept consumers on the socket at path
+    static FrameRing *create(const std::string &path, uint32_t width, uint32_t height, uint32_t channels);
+    // connect to the ring of frames shared on the socket at path (nullptr if not available)
+    static FrameRing *connect(const std::string &path);
+    // shared memory is supported on this system
+    static bool available();
+
+    ~FrameRing();
+
+    inline uint32_t width() const { return width_; }
+    inline uint32_t height() const { return height_; }
+    inline uint32_t channels() const { return channels_; }
+    inline size_t frameSize() const { return (size_t) width_ * height_ * channels_; }
+
+    // producer: pointer to the slot to write the next frame
+    unsigned char *next();
+    // producer: publish the frame written in the slot given by next()
+    void publish();
+    // producer: inform consumers that no more frames will be published
+    void close();
+
+    // consumer: pointer to the latest frame if newer than sequence (nullptr otherwise),
+    // and the sequence number of this frame
+    const unsigned char *latest(uint32_t &sequence) const;
+    // consumer: true if the frame of this sequence was not overwritten
+    bool valid(uint32_t sequence) const;
+    // consumer: the producer closed the ring
+    bool closed() const;
+
+private:
+
+    FrameRing();
+    bool map(int fd, bool producer);
+    static void serve(FrameRing *ring);
+
+    struct Header;
+    Header *header_;
+    unsigned char *slots_;
+    size_t size_;
+    uint32_t width_;
+    uint32_t height_;
+    uint32_t channels_;
+    int fd_;
+
+    // socket of producer
+    std::string path_;
+    int socket_;
+    std::thread server_;
+};
+
+#endif // FRAMERING_H
@@ -0,0 +1,104 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "FrameSlots.h"
+
+FrameSlots::FrameSlots() : sample_(nullptr), preroll_(nullptr), eos_(false),
+    eos_position_(GST_CLOCK_TIME_NONE), current_(nullptr)
+{
+
+}
+
+FrameSlots::~FrameSlots()
+{
+    clear();
+}
+
+void FrameSlots::push(GstBuffer *buf, Status status, GstClockTime position)
+{
+    if (status == EOS) {
+        // the samples before end of stream will not be presented
+        GstBuffer *previous = sample_.exchange(nullptr);
+        if (previous)
+            gst_buffer_unref(previous);
+        // position is published with the EOS flag
+        eos_position_.store(position, std::memory_order_relaxed);
+        eos_.store(true, std::memory_order_release);
+    }
+    else if (buf != nullptr) {
+        GstBuffer *copy = gst_buffer_copy(buf);
+        GstBuffer *previous = nullptr;
+        if (status == PREROLL) {
+            // the samples before pre-roll will not be presented
+            previous = sample_.exchange(nullptr);
+            if (previous)
+                gst_buffer_unref(previous);
+            previous = preroll_.exchange(copy);
+        }
+        else
+            previous = sample_.exchange(copy);
+        // drop unread frame
+        if (previous)
+            gst_buffer_unref(previous);
+    }
+}
+
+bool FrameSlots::pop(Frame &frame)
+{
+    GstBuffer *buf = nullptr;
+    frame.status = INVALID;
+
+    if (eos_.exchange(false, std::memory_order_acquire)) {
+        frame.status = EOS;
+        frame.position = eos_position_.load(std::memory_order_relaxed);
+    }
+    else if ( (buf = preroll_.exchange(nullptr)) != nullptr )
+        frame.status = PREROLL;
+    else if ( (buf = sample_.exchange(nullptr)) != nullptr )
+        frame.status = SAMPLE;
+
+    if (frame.status == INVALID)
+        return false;
+
+    // previous buffer is not used anymore by the consumer
+    if (current_)
+        gst_buffer_unref(current_);
+    current_ = buf;
+
+    frame.buffer = buf;
+    if (buf)
+        frame.position = buf->pts;
+
+    return true;
+}
+
+void FrameSlots::clear()
+{
+    GstBuffer *buf = sample_.exchange(nullptr);
+    if (buf)
+        gst_buffer_unref(buf);
+    buf = preroll_.exchange(nullptr);
+    if (buf)
+        gst_buffer_unref(buf);
+    eos_ = false;
+
+    if (current_)
+        gst_buffer_unref(current_);
+    current_ = nullptr;
+}
@@ -0,0 +1,60 @@
+#ifndef FRAMESLOTS_H
+#define FRAMESLOTS_H
+
+#include <atomic>
+#include <gst/gst.h>
+
+///
+/// \brief The FrameSlots pass decoded frames from the streaming thread
+/// of gstreamer (producer) to the rendering thread (consumer) without lock.
+///
+/// Only the latest sample matters for display: the producer exchanges
+/// its copy of the buffer with the one in the sample slot (an unread
+/// sample is dropped), and the consumer takes it out of the slot.
+/// Pre-roll and end-of-stream have their own slots so that they are
+/// never missed by the consumer.
+///
+/// Push and pop are wait-free (a single atomic exchange each).
+///
+class FrameSlots
+{
+public:
+    typedef enum  {
+        SAMPLE = 0,
+        PREROLL = 1,
+        EOS = 2,
+        INVALID = 3
+    } Status;
+
+    struct Frame {
+        GstBuffer *buffer;
+        Status status;
+        GstClockTime position;
+    };
+
+    FrameSlots();
+    ~FrameSlots();
+
+    // producer: push a copy of a SAMPLE or PREROLL buffer,
+    // or an EOS (without buffer) at the given position
+    void push(GstBuffer *buf, Status status, GstClockTime position = GST_CLOCK_TIME_NONE);
+
+    // consumer: get the next frame to present (EOS first, then pre-roll, then sample)
+    // returns false if nothing new was pushed. The buffer of the frame is valid
+    // until the next pop or clear.
+    bool pop(Frame &frame);
+
+    // release all frames (producer and consumer stopped)
+    void clear();
+
+private:
+    std::atomic<GstBuffer *> sample_;
+    std::atomic<GstBuffer *> preroll_;
+    std::atomic<bool> eos_;
+    std::atomic<GstClockTime> eos_position_;
+
+    // buffer given to consumer
+    GstBuffer *current_;
+};
+
+#endif // FRAMESLOTS_H
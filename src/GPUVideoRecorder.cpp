@@ -135,14 +135,18 @@ std::string GPUVideoRecorder::buildPipeline(Profile profile, GstCaps *write_caps
         !Settings::application.record.audio_device.empty()) {
         // ensure the Audio manager has the device specified in settings
         int current_audio = Audio::manager().index(Settings::application.record.audio_device);
-        if (current_audio > -1) {
+        // or tap the output of the audio mixing bus
+        bool mixing = Settings::application.audio_mixing &&
+                Settings::application.record.audio_device.compare(AUDIO_MIXING_NAME) == 0;
+        if (current_audio > -1 || mixing) {
+            std::string audio = mixing ? Audio::manager().mixingPipeline() : Audio::manager().pipeline(current_audio);
             pipeline += "mux. ";
-            pipeline += Audio::manager().pipeline(current_audio);
+            pipeline += audio;
             pipeline += " ! audio/x-raw ! audioconvert ! audioresample ! ";
             pipeline += "identity name=audiosync ! ";
             pipeline += "avenc_aac ! aacparse ! queue ! ";
 
-            Log::Info("GPU Video Recording : audio (%s)", Audio::manager().pipeline(current_audio).c_str());
+            Log::Info("GPU Video Recording : audio (%s)", audio.c_str());
         }
     }
 
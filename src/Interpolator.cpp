@@ -23,117 +23,79 @@
 #include "defines.h"
 #include "Source/Source.h"
 #include "ImageProcessingShader.h"
-#include "Scene/UpdateCallback.h"
 
 #include "Interpolator.h"
 
+// groups of views interpolated
+static const View::Mode interpolated_views[] = { View::MIXING, View::GEOMETRY, View::LAYER, View::TEXTURE };
+#define INTERPOLATED_VIEWS 4
+// number of floats for the attributes of a source:
+// translation, scale, rotation and crop of each group, and image processing
+#define INTERPOLATED_GROUP (3 + 3 + 3 + 4)
+#define INTERPOLATED_PROCESSING (6 + 4 + 4)
+#define INTERPOLATED_ATTRIBUTES (INTERPOLATED_VIEWS * INTERPOLATED_GROUP + INTERPOLATED_PROCESSING)
 
-SourceInterpolator::SourceInterpolator(Source *subject, const SourceCore &target) :
-    subject_(subject), from_(static_cast<SourceCore>(*subject)), to_(target), current_cursor_(0.f)
+static void pack(const SourceCore &core, float *v)
 {
+    for (int i = 0; i < INTERPOLATED_VIEWS; ++i) {
+        const Group *g = core.group(interpolated_views[i]);
+        for (int c = 0; c < 3; ++c) {
+            *v++ = g->translation_[c];
+            *v++ = g->scale_[c];
+            *v++ = g->rotation_[c];
+        }
+        for (int c = 0; c < 4; ++c)
+            *v++ = g->crop_[c];
+    }
 
-
-}
-
-
-void SourceInterpolator::interpolateGroup(View::Mode m)
-{
-    current_state_.group(m)->translation_ =
-            (1.f - current_cursor_) * from_.group(m)->translation_
-            + current_cursor_ * to_.group(m)->translation_;
-    current_state_.group(m)->scale_ =
-            (1.f - current_cursor_) * from_.group(m)->scale_
-            + current_cursor_ * to_.group(m)->scale_;
-    current_state_.group(m)->rotation_ =
-            (1.f - current_cursor_) * from_.group(m)->rotation_
-            + current_cursor_ * to_.group(m)->rotation_;
-    current_state_.group(m)->crop_ =
-            (1.f - current_cursor_) * from_.group(m)->crop_
-            + current_cursor_ * to_.group(m)->crop_;
-
-    CopyCallback *anim = new CopyCallback( current_state_.group(m) );
-    subject_->group(m)->update_callbacks_.clear();
-    subject_->group(m)->update_callbacks_.push_back(anim);
-}
-
-void SourceInterpolator::interpolateImageProcessing()
-{
-    current_state_.processingShader()->brightness =
-            (1.f - current_cursor_) * from_.processingShader()->brightness
-            + current_cursor_ * to_.processingShader()->brightness;
-
-    current_state_.processingShader()->contrast =
-            (1.f - current_cursor_) * from_.processingShader()->contrast
-            + current_cursor_ * to_.processingShader()->contrast;
-
-    current_state_.processingShader()->saturation =
-            (1.f - current_cursor_) * from_.processingShader()->saturation
-            + current_cursor_ * to_.processingShader()->saturation;
-
-    current_state_.processingShader()->hueshift =
-            (1.f - current_cursor_) * from_.processingShader()->hueshift
-            + current_cursor_ * to_.processingShader()->hueshift;
-
-    current_state_.processingShader()->threshold =
-            (1.f - current_cursor_) * from_.processingShader()->threshold
-            + current_cursor_ * to_.processingShader()->threshold;
-
-    current_state_.processingShader()->nbColors =
-            (1.f - current_cursor_) * from_.processingShader()->nbColors
-            + current_cursor_ * to_.processingShader()->nbColors;
-
-    current_state_.processingShader()->gamma =
-            (1.f - current_cursor_) * from_.processingShader()->gamma
-            + current_cursor_ * to_.processingShader()->gamma;
-
-    current_state_.processingShader()->levels =
-            (1.f - current_cursor_) * from_.processingShader()->levels
-            + current_cursor_ * to_.processingShader()->levels;
-
-    subject_->processingShader()->copy( *current_state_.processingShader() );
-
-// not interpolated : invert , filterid
-}
-
-float SourceInterpolator::current() const
-{
-    return current_cursor_;
+    const ImageProcessingShader *s = core.processingShader();
+    *v++ = s->brightness;
+    *v++ = s->contrast;
+    *v++ = s->saturation;
+    *v++ = s->hueshift;
+    *v++ = s->threshold;
+    *v++ = (float) s->nbColors;
+    for (int c = 0; c < 4; ++c) {
+        *v++ = s->gamma[c];
+        *v++ = s->levels[c];
+    }
 }
 
-void SourceInterpolator::apply(float percent)
+static void unpack(const float *v, Source *source)
 {
-    percent = CLAMP( percent, 0.f, 1.f);
-
-    if ( subject_ && ABS_DIFF(current_cursor_, percent) > EPSILON)
-    {
-        current_cursor_ = percent;
-
-        if (current_cursor_ < EPSILON) {
-            current_cursor_ = 0.f;
-            current_state_ = from_;
-            subject_->copy(current_state_);
-        }
-        else if (current_cursor_ > 1.f - EPSILON) {
-            current_cursor_ = 1.f;
-            current_state_ = to_;
-            subject_->copy(current_state_);
-        }
-        else {
-            interpolateGroup(View::MIXING);
-            interpolateGroup(View::GEOMETRY);
-            interpolateGroup(View::LAYER);
-            interpolateGroup(View::TEXTURE);
-            interpolateImageProcessing();
-//            Log::Info("SourceInterpolator::update %f", cursor);
+    for (int i = 0; i < INTERPOLATED_VIEWS; ++i) {
+        Group *g = source->group(interpolated_views[i]);
+        // interpolation overrides ongoing animations
+        if (!g->update_callbacks_.empty())
+            g->clearCallbacks();
+        for (int c = 0; c < 3; ++c) {
+            g->translation_[c] = *v++;
+            g->scale_[c] = *v++;
+            g->rotation_[c] = *v++;
         }
+        for (int c = 0; c < 4; ++c)
+            g->crop_[c] = *v++;
+    }
 
-        subject_->touch();
+    // not interpolated : invert , filterid
+    ImageProcessingShader *s = source->processingShader();
+    s->brightness = *v++;
+    s->contrast = *v++;
+    s->saturation = *v++;
+    s->hueshift = *v++;
+    s->threshold = *v++;
+    s->nbColors = (int) *v++;
+    for (int c = 0; c < 4; ++c) {
+        s->gamma[c] = *v++;
+        s->levels[c] = *v++;
     }
 }
 
-Interpolator::Interpolator()
+Interpolator::Interpolator(size_t snapshots) : snapshots_(MAXI(snapshots, (size_t) 1))
 {
-
+    // current state has all the weight
+    weights_.assign(snapshots_ + 1, 0.f);
+    weights_[0] = 1.f;
 }
 
 Interpolator::~Interpolator()
@@ -143,34 +105,106 @@ Interpolator::~Interpolator()
 
 void Interpolator::clear()
 {
-    for (auto i = interpolators_.begin(); i != interpolators_.end(); ) {
-        delete *i;
-        i = interpolators_.erase(i);
-    }
+    for (auto s = states_.begin(); s != states_.end(); ++s)
+        delete *s;
+    states_.clear();
+    sources_.clear();
+    attributes_.clear();
+    blend_.clear();
 }
 
-
 void Interpolator::add (Source *s, const SourceCore &target)
 {
-    SourceInterpolator *i = new SourceInterpolator(s, target);
-    interpolators_.push_back(i);
+    add(s, std::vector<const SourceCore *>(1, &target));
 }
 
+void Interpolator::add (Source *s, const std::vector<const SourceCore *> &targets)
+{
+    if (s == nullptr)
+        return;
+
+    sources_.push_back(s);
+
+    // states of the source: current and in each snapshot
+    size_t first = attributes_.size();
+    attributes_.resize(first + (snapshots_ + 1) * INTERPOLATED_ATTRIBUTES);
+    for (size_t k = 0; k < snapshots_ + 1; ++k) {
+        const SourceCore *state = static_cast<const SourceCore *>(s);
+        if ( k > 0 && k - 1 < targets.size() && targets[k - 1] != nullptr )
+            state = targets[k - 1];
+        states_.push_back( new SourceCore(*state) );
+        pack(*state, attributes_.data() + first + k * INTERPOLATED_ATTRIBUTES);
+    }
+
+    blend_.resize(sources_.size() * INTERPOLATED_ATTRIBUTES);
+}
 
 float Interpolator::current() const
 {
-    float ret = 0.f;
-    if (interpolators_.size() > 0)
-        ret = interpolators_.front()->current();
-
-    return ret;
+    return weights_[1];
 }
 
 void Interpolator::apply(float percent)
 {
-    for (auto i = interpolators_.begin(); i != interpolators_.end(); ++i)
-        (*i)->apply( percent );
+    percent = CLAMP( percent, 0.f, 1.f);
 
+    if ( ABS_DIFF(weights_[1], percent) > EPSILON ) {
+        weights_.assign(snapshots_ + 1, 0.f);
+        weights_[0] = 1.f - percent;
+        weights_[1] = percent;
+        evaluate();
+    }
 }
 
+void Interpolator::apply(const std::vector<float> &weights)
+{
+    // weights of snapshots, and remaining weight for current state
+    bool changed = false;
+    float remain = 1.f;
+    for (size_t k = 1; k < snapshots_ + 1; ++k) {
+        float w = k - 1 < weights.size() ? CLAMP(weights[k - 1], 0.f, 1.f) : 0.f;
+        changed |= ABS_DIFF(weights_[k], w) > EPSILON;
+        weights_[k] = w;
+        remain -= w;
+    }
+    weights_[0] = MAXI(remain, 0.f);
+
+    if (changed)
+        evaluate();
+}
+
+void Interpolator::evaluate()
+{
+    // a state has all the weight: copy it entirely
+    for (size_t k = 0; k < snapshots_ + 1; ++k) {
+        if ( weights_[k] > 1.f - EPSILON ) {
+            for (size_t i = 0; i < sources_.size(); ++i) {
+                sources_[i]->copy( *states_[i * (snapshots_ + 1) + k] );
+                sources_[i]->touch();
+            }
+            return;
+        }
+    }
+
+    // weighted sum of the attributes of each state, normalized
+    float total = 0.f;
+    for (size_t k = 0; k < snapshots_ + 1; ++k)
+        total += weights_[k];
+    if ( total < EPSILON )
+        return;
+
+    for (size_t i = 0; i < sources_.size(); ++i) {
+        float *b = blend_.data() + i * INTERPOLATED_ATTRIBUTES;
+        const float *v = attributes_.data() + i * (snapshots_ + 1) * INTERPOLATED_ATTRIBUTES;
+        for (int a = 0; a < INTERPOLATED_ATTRIBUTES; ++a)
+            b[a] = 0.f;
+        for (size_t k = 0; k < snapshots_ + 1; ++k, v += INTERPOLATED_ATTRIBUTES) {
+            const float w = weights_[k] / total;
+            for (int a = 0; a < INTERPOLATED_ATTRIBUTES; ++a)
+                b[a] += w * v[a];
+        }
 
+        unpack(b, sources_[i]);
+        sources_[i]->touch();
+    }
+}
@@ -1,44 +1,52 @@
 #ifndef INTERPOLATOR_H
 #define INTERPOLATOR_H
 
+#include <vector>
+
 #include "Source/Source.h"
 #include "Source/SourceList.h"
 
-class SourceInterpolator
-{
-public:
-    SourceInterpolator(Source *subject, const SourceCore &target);
-
-    void apply (float percent);
-    float current() const;
-
-protected:
-    Source *subject_;
-
-    SourceCore from_;
-    SourceCore to_;
-    SourceCore current_state_;
-    float current_cursor_;
-
-    void interpolateGroup (View::Mode m);
-    void interpolateImageProcessing ();
-};
-
+///
+/// \brief The Interpolator blends the current state of sources with
+/// their state in one or several snapshots.
+///
+/// The interpolable attributes of all sources (transforms and crop
+/// of groups in views, image processing parameters) are packed in
+/// a contiguous array for each state, and blended with weights
+/// without allocation when applied.
+///
 class Interpolator
 {
 public:
-    Interpolator();
+    // interpolate between the current state and a number of snapshots
+    Interpolator(size_t snapshots = 1);
     ~Interpolator();
 
     void clear ();
+    // add a source with its state in the snapshot
     void add (Source *s, const SourceCore &target );
+    // add a source with its state in each snapshot (nullptr for unchanged)
+    void add (Source *s, const std::vector<const SourceCore *> &targets );
 
+    // blend with the snapshot at percent
     void apply (float percent);
+    // blend with weights of snapshots (the current state has the remaining weight)
+    void apply (const std::vector<float> &weights);
+    // weight of the (first) snapshot
     float current() const;
 
 protected:
-    std::list<SourceInterpolator *> interpolators_;
-
+    size_t snapshots_;
+    std::vector<Source *> sources_;
+    // full states of sources, for each snapshot (first is initial state)
+    std::vector<SourceCore *> states_;
+    // packed attributes of sources, for each snapshot
+    std::vector<float> attributes_;
+    // blended attributes
+    std::vector<float> blend_;
+    std::vector<float> weights_;
+
+    void evaluate ();
 };
 
 #endif // INTERPOLATOR_H
@@ -0,0 +1,435 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include <string>
+#include <thread>
+#include <fstream>
+#include <cstdio>
+#include <functional>
+#include <deque>
+
+#include "defines.h"
+#include "Log.h"
+#include "Settings.h"
+#include "Toolkit/SystemToolkit.h"
+#include "Toolkit/BaseToolkit.h"
+#include "Toolkit/tinyxml2Toolkit.h"
+
+#include "Journal.h"
+
+using namespace tinyxml2;
+
+// hash of the compact XML text of an element
+static size_t hashElement(const XMLElement *e)
+{
+    XMLPrinter p(0, true);
+    e->Accept(&p);
+    return std::hash<std::string>()(p.CStr());
+}
+
+// write a line at the end of a file
+static bool appendLine(const std::string &filename, const std::string &line, const char *mode = "a")
+{
+    FILE *file = fopen(filename.c_str(), mode);
+    if (file == NULL)
+        return false;
+    fputs(line.c_str(), file);
+    fputc('\n', file);
+    fclose(file);
+    return true;
+}
+
+static std::string headerLine(const std::string &base, const std::string &session)
+{
+    XMLDocument doc;
+    XMLElement *header = doc.NewElement("Journal");
+    header->SetAttribute("base", base.c_str());
+    header->SetAttribute("session", session.c_str());
+    header->SetAttribute("date", SystemToolkit::date_time_string().c_str());
+    doc.InsertEndChild(header);
+
+    XMLPrinter p(0, true);
+    doc.Print(&p);
+    return p.CStr();
+}
+
+// the base is a file compacted by the journal (and not the file of the session)
+static bool compactedBase(const std::string &base)
+{
+    return base.rfind(SystemToolkit::full_filename(SystemToolkit::settings_path(), "journal_"), 0) == 0
+            && SystemToolkit::has_extension(base, "mix");
+}
+
+Journal::Journal(): header_(false), steps_(0), generation_(0), records_(0), started_(0), attributes_(0), compacting_(false)
+{
+    filename_ = SystemToolkit::full_filename(SystemToolkit::settings_path(),
+                                             "journal_" + std::to_string(Settings::application.instance_id) + ".xml");
+
+    // a journal was left by an interrupted execution: keep it aside for recovery
+    if (SystemToolkit::file_exists(filename_)) {
+        std::string previous = filename_ + ".previous";
+        SystemToolkit::remove_file(previous);
+        if (rename(filename_.c_str(), previous.c_str()) == 0) {
+            // worth recovering only if it has a base or some sources
+            std::string base;
+            XMLDocument doc;
+            if ( replay(previous, &doc, 0, &base) ) {
+                const XMLElement *sessionNode = doc.FirstChildElement("Session");
+                if ( !base.empty() || (sessionNode && sessionNode->FirstChildElement("Source")) )
+                    previous_ = previous;
+            }
+        }
+    }
+}
+
+void Journal::reset(const std::string &filename)
+{
+    base_ = filename;
+    session_ = filename;
+    steps_ = 0;
+    ++generation_;
+
+    // write header at next append
+    header_ = false;
+    SystemToolkit::remove_file(filename_);
+}
+
+void Journal::start(const std::string &filename)
+{
+    std::lock_guard<std::mutex> lock(access_);
+
+    // remove file compacted for previous session
+    if (compactedBase(base_))
+        SystemToolkit::remove_file(base_);
+
+    // next records are relative to the file
+    reset(filename);
+    sources_.clear();
+    attributes_ = 0;
+    started_ = records_;
+}
+
+uint64_t Journal::mark()
+{
+    std::lock_guard<std::mutex> lock(access_);
+    return records_;
+}
+
+void Journal::rebase(const std::string &filename, uint64_t mark)
+{
+    std::lock_guard<std::mutex> lock(access_);
+
+    // journal was started for another session meanwhile
+    if (mark < started_)
+        return;
+
+    // records appended while saving are not in the saved file: keep them
+    // (they are the last lines of the journal, after the header)
+    std::deque<std::string> kept;
+    size_t count = (size_t) MIN(records_ - mark, (uint64_t) steps_);
+    if (count > 0) {
+        std::ifstream file(filename_);
+        std::string line;
+        while ( std::getline(file, line) ) {
+            kept.push_back(line);
+            if (kept.size() > count)
+                kept.pop_front();
+        }
+        file.close();
+    }
+
+    if (compactedBase(base_))
+        SystemToolkit::remove_file(base_);
+
+    // the saved file and the records kept are identical to
+    // the last records: keep their hash
+    reset(filename);
+
+    if (!kept.empty()) {
+        header_ = appendLine(filename_, headerLine(base_, session_), "w");
+        for (auto l = kept.begin(); header_ && l != kept.end(); ++l)
+            header_ = appendLine(filename_, *l);
+        if (!header_)
+            Log::Warning("Failed to write journal '%s'.", filename_.c_str());
+        steps_ = kept.size();
+    }
+}
+
+void Journal::close()
+{
+    std::lock_guard<std::mutex> lock(access_);
+
+    if (compactedBase(base_))
+        SystemToolkit::remove_file(base_);
+
+    reset("");
+    sources_.clear();
+    attributes_ = 0;
+}
+
+void Journal::append(const XMLElement *step)
+{
+    if (step == nullptr || !Settings::application.session_journal)
+        return;
+
+    std::lock_guard<std::mutex> lock(access_);
+
+    // record of changes
+    XMLDocument doc;
+    XMLElement *record = doc.NewElement("Step");
+    doc.InsertEndChild(record);
+    if (step->Attribute("label"))
+        record->SetAttribute("label", step->Attribute("label"));
+
+    // only sources that changed since last record
+    std::map<uint64_t, size_t> sources;
+    for (const XMLElement *s = step->FirstChildElement("Source"); s; s = s->NextSiblingElement("Source")) {
+        uint64_t id = 0;
+        s->QueryUnsigned64Attribute("id", &id);
+        size_t h = hashElement(s);
+        sources[id] = h;
+        auto previous = sources_.find(id);
+        if (previous == sources_.end() || previous->second != h)
+            record->InsertEndChild( s->DeepClone(&doc) );
+    }
+
+    // sources that were removed
+    for (auto previous = sources_.begin(); previous != sources_.end(); ++previous) {
+        if (sources.find(previous->first) == sources.end()) {
+            XMLElement *removed = doc.NewElement("Removed");
+            removed->SetAttribute("id", previous->first);
+            record->InsertEndChild(removed);
+        }
+    }
+    sources_.swap(sources);
+
+    // session attributes and input callbacks
+    float threshold = 0.f;
+    step->QueryFloatAttribute("activationThreshold", &threshold);
+    const XMLElement *inputs = step->FirstChildElement("InputCallbacks");
+    size_t attributes = std::hash<float>()(threshold);
+    if (inputs)
+        attributes ^= hashElement(inputs);
+    if (attributes != attributes_) {
+        record->SetAttribute("activationThreshold", threshold);
+        if (inputs)
+            record->InsertEndChild( inputs->DeepClone(&doc) );
+        attributes_ = attributes;
+    }
+
+    // nothing changed
+    if (record->NoChildren() && !record->Attribute("activationThreshold"))
+        return;
+
+    // header of journal, with the base to apply records to
+    if (!header_)
+        header_ = appendLine(filename_, headerLine(base_, session_), "w");
+
+    // append compact record
+    XMLPrinter p(0, true);
+    doc.Print(&p);
+    if (!appendLine(filename_, p.CStr())) {
+        Log::Warning("Failed to write journal '%s'.", filename_.c_str());
+        return;
+    }
+    ++records_;
+
+    // compact in background when the journal gets long
+    if (++steps_ > JOURNAL_COMPACT_STEPS && !compacting_) {
+        compacting_ = true;
+        std::thread(Journal::compact, this).detach();
+    }
+}
+
+void Journal::compact(Journal *j)
+{
+    // number of lines to compact (header and steps)
+    j->access_.lock();
+    uint generation = j->generation_;
+    std::string journal = j->filename_;
+    std::string session = j->session_;
+    size_t lines = j->steps_ + 1;
+    j->access_.unlock();
+
+    // replay records on base, without blocking append of new records
+    XMLDocument doc;
+    std::string compacted = SystemToolkit::full_filename(SystemToolkit::settings_path(),
+                                                         "journal_" + std::to_string(BaseToolkit::uniqueId()) + ".mix");
+    if ( !replay(journal, &doc, lines) || !XMLSaveDoc(&doc, compacted) ) {
+        Log::Info("Journal could not be compacted.");
+        SystemToolkit::remove_file(compacted);
+        j->compacting_ = false;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(j->access_);
+
+    // journal was restarted meanwhile
+    if (generation != j->generation_) {
+        SystemToolkit::remove_file(compacted);
+        j->compacting_ = false;
+        return;
+    }
+
+    // new journal on compacted base, with records appended meanwhile
+    std::string temp = journal + ".tmp";
+    std::ifstream file(journal);
+    std::string line;
+    size_t n = 0;
+    bool ok = appendLine(temp, headerLine(compacted, session), "w");
+    while ( ok && std::getline(file, line) ) {
+        if (++n > lines)
+            ok = appendLine(temp, line);
+    }
+    file.close();
+
+    if ( ok && rename(temp.c_str(), journal.c_str()) == 0 ) {
+        if (compactedBase(j->base_))
+            SystemToolkit::remove_file(j->base_);
+        j->base_ = compacted;
+        j->steps_ = n > lines ? n - lines : 0;
+    }
+    else {
+        SystemToolkit::remove_file(temp);
+        SystemToolkit::remove_file(compacted);
+    }
+
+    j->compacting_ = false;
+}
+
+bool Journal::replay(const std::string &journal, XMLDocument *doc, size_t maxlines,
+                     std::string *base, std::string *session)
+{
+    std::ifstream file(journal);
+    std::string line;
+    if ( !file.is_open() || !std::getline(file, line) )
+        return false;
+
+    // read header
+    XMLDocument header;
+    if ( header.Parse(line.c_str()) != XML_SUCCESS || header.FirstChildElement("Journal") == nullptr )
+        return false;
+    const char *b = header.FirstChildElement("Journal")->Attribute("base");
+    const char *s = header.FirstChildElement("Journal")->Attribute("session");
+    std::string basefile = b ? b : "";
+    if (base)
+        *base = basefile;
+    if (session)
+        *session = s ? s : "";
+
+    // start from the base file, or an empty session
+    doc->Clear();
+    if ( !basefile.empty() && XMLResultError(doc->LoadFile(basefile.c_str()), false) )
+        doc->Clear();
+    if ( doc->FirstChildElement(APP_NAME) == nullptr ) {
+        doc->Clear();
+        XMLElement *rootnode = doc->NewElement(APP_NAME);
+        rootnode->SetAttribute("major", XML_VERSION_MAJOR);
+        rootnode->SetAttribute("minor", XML_VERSION_MINOR);
+        doc->InsertEndChild(rootnode);
+    }
+    XMLElement *sessionNode = doc->FirstChildElement("Session");
+    if (sessionNode == nullptr) {
+        sessionNode = doc->NewElement("Session");
+        doc->InsertEndChild(sessionNode);
+    }
+
+    // apply records in order
+    for (size_t n = 1; (maxlines < 1 || n < maxlines) && std::getline(file, line); ++n) {
+
+        // NB: last line may be incomplete if interrupted while writing
+        XMLDocument record;
+        if ( record.Parse(line.c_str()) != XML_SUCCESS )
+            continue;
+        const XMLElement *step = record.FirstChildElement("Step");
+        if (step == nullptr)
+            continue;
+
+        float threshold = 0.f;
+        if ( step->QueryFloatAttribute("activationThreshold", &threshold) == XML_SUCCESS )
+            sessionNode->SetAttribute("activationThreshold", threshold);
+
+        for (const XMLElement *e = step->FirstChildElement(); e; e = e->NextSiblingElement()) {
+            const std::string name = e->Name();
+
+            // replace or remove source with same id
+            if ( name.compare("Source") == 0 || name.compare("Removed") == 0 ) {
+                uint64_t id = 0;
+                e->QueryUnsigned64Attribute("id", &id);
+                XMLElement *existing = sessionNode->FirstChildElement("Source");
+                for (; existing; existing = existing->NextSiblingElement("Source")) {
+                    uint64_t i = 0;
+                    existing->QueryUnsigned64Attribute("id", &i);
+                    if (i == id)
+                        break;
+                }
+                if ( name.compare("Source") == 0 ) {
+                    XMLNode *source = e->DeepClone(doc);
+                    if (existing)
+                        sessionNode->InsertAfterChild(existing, source);
+                    else
+                        sessionNode->InsertEndChild(source);
+                }
+                if (existing)
+                    sessionNode->DeleteChild(existing);
+            }
+            // replace input callbacks
+            else if ( name.compare("InputCallbacks") == 0 ) {
+                XMLElement *existing = sessionNode->FirstChildElement("InputCallbacks");
+                if (existing)
+                    sessionNode->DeleteChild(existing);
+                sessionNode->InsertEndChild( e->DeepClone(doc) );
+            }
+        }
+    }
+
+    return true;
+}
+
+std::string Journal::recover()
+{
+    std::string filename;
+    if (previous_.empty())
+        return filename;
+
+    std::string base, session;
+    XMLDocument doc;
+    if ( replay(previous_, &doc, 0, &base, &session) ) {
+        // save recovered session next to the original file
+        if (session.empty())
+            filename = SystemToolkit::filename_sequential(SystemToolkit::home_path(), "recovered", "mix");
+        else
+            filename = SystemToolkit::filename_sequential(SystemToolkit::path_filename(session),
+                                                          SystemToolkit::base_filename(session) + "_recovered", "mix");
+        if ( XMLSaveDoc(&doc, filename) )
+            Log::Warning("vimix was not closed properly; session recovered in %s", filename.c_str());
+        else {
+            Log::Warning("Failed to recover session from journal.");
+            filename.clear();
+        }
+    }
+
+    // done with this journal
+    if (compactedBase(base))
+        SystemToolkit::remove_file(base);
+    SystemToolkit::remove_file(previous_);
+    previous_.clear();
+
+    return filename;
+}
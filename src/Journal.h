@@ -0,0 +1,79 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <string>
+#include <map>
+#include <mutex>
+#include <atomic>
+
+#include <tinyxml2.h>
+
+// number of steps appended before compacting the journal
+#define JOURNAL_COMPACT_STEPS 50
+
+///
+/// \brief The Journal is a write-ahead log of the changes of the session.
+///
+/// Each step of the history (Action manager) appends a compact record with
+/// only the sources that changed since the previous step. The journal is
+/// regularly compacted in background into a session file (.mix format),
+/// which becomes the base for the next records.
+///
+/// A clean exit deletes the journal. If vimix was interrupted, the journal
+/// left is replayed on its base to recover the session.
+///
+class Journal
+{
+    // Private Constructor
+    Journal();
+    Journal(Journal const& copy) = delete;
+    Journal& operator=(Journal const& copy) = delete;
+
+public:
+
+    static Journal& manager ()
+    {
+        // The only instance
+        static Journal _instance;
+        return _instance;
+    }
+
+    // start the journal of a session (filename can be empty for a new session)
+    void start  (const std::string &filename);
+    // count of records appended, to mark when the session starts saving
+    uint64_t mark ();
+    // the session saved in filename from the records up to mark is the base for the next records
+    void rebase (const std::string &filename, uint64_t mark);
+    // append the changes in a step of history
+    void append (const tinyxml2::XMLElement *step);
+    // delete the journal (on clean exit)
+    void close  ();
+
+    // a journal was left by an interrupted execution
+    inline bool recoverable () const { return !previous_.empty(); }
+    // replay journal left by interrupted execution and return the filename of the recovered session
+    std::string recover ();
+
+private:
+
+    std::string filename_;
+    std::string previous_;
+    std::string base_;
+    std::string session_;
+    bool header_;
+    uint steps_;
+    uint generation_;
+    uint64_t records_;
+    uint64_t started_;
+    std::map<uint64_t, size_t> sources_;
+    size_t attributes_;
+    std::mutex access_;
+    std::atomic<bool> compacting_;
+
+    void reset (const std::string &filename);
+    static void compact (Journal *j);
+    static bool replay (const std::string &journal, tinyxml2::XMLDocument *doc, size_t maxlines = 0,
+                        std::string *base = nullptr, std::string *session = nullptr);
+};
+
+#endif // JOURNAL_H
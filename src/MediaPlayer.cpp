@@ -17,6 +17,8 @@
  * along with this program. If not, see <https://www.gnu.org/licenses/>.
 **/
 
+#include <algorithm>
+
 #include <gst/gst.h>
 
 //  Desktop OpenGL function loader
@@ -32,6 +34,8 @@
 #include "Toolkit/GstToolkit.h"
 #include "Metronome.h"
 #include "Settings.h"
+#include "Audio.h"
+#include "CacheBudget.h"
 
 #include "MediaPlayer.h"
 
@@ -50,6 +54,14 @@
 
 std::list<GstElement*> MediaPlayer::registered_;
 
+// release all buffers of a frame cache
+static void unref_frames(std::map<GstClockTime, GstBuffer *> &frames)
+{
+    for (auto it = frames.begin(); it != frames.end(); ++it)
+        gst_buffer_unref(it->second);
+    frames.clear();
+}
+
 MediaPlayer::MediaPlayer()
 {
     // create unique id
@@ -59,8 +71,15 @@ MediaPlayer::MediaPlayer()
     pipeline_ = nullptr;
     opened_ = false;
     enabled_ = true;
+    suspended_ = false;
+    suspended_position_ = GST_CLOCK_TIME_NONE;
+    proxy_ = false;
+    proxy_width_ = 0;
+    proxy_height_ = 0;
+    texture_resize_ = false;
     desired_state_ = GST_STATE_PAUSED;
     audio_enabled_ = false;
+    audio_mixing_ = false;
 
     failed_ = false;
     pending_ = false;
@@ -78,10 +97,6 @@ MediaPlayer::MediaPlayer()
     loop_status_ = LoopStatus::LOOP_STATUS_DEFAULT;
     fading_mode_ = FadingMode::FADING_COLOR;
 
-    // start index in frame_ stack
-    write_index_ = 0;
-    last_index_ = 0;
-
     // no PBO by default
     pbo_[0] = pbo_[1] = 0;
     pbo_size_ = 0;
@@ -95,6 +110,11 @@ MediaPlayer::MediaPlayer()
 
     // OpenGL texture
     textureindex_ = 0;
+    texture_updates_ = 0;
+
+    // timer for presentation of frames from cache
+    clip_cache_ = false;
+    cache_timer_ = g_timer_new ();
 }
 
 MediaPlayer::~MediaPlayer()
@@ -114,6 +134,8 @@ MediaPlayer::~MediaPlayer()
         textureindex_ = 0;
     }
 
+    g_timer_destroy (cache_timer_);
+
 #ifdef MEDIA_PLAYER_DEBUG
     g_printerr("MediaPlayer %s deleted\n", std::to_string(id_).c_str());
 #endif
@@ -471,6 +493,7 @@ MediaEvaluation MediaPlayer::UriEvaluator(const std::string &uri, std::shared_pt
     eval.frame_count        = probe_data.frame_count;
     eval.keyframe_count     = probe_data.keyframe_count;
     eval.keyframe_pts       = std::move(probe_data.keyframe_pts);
+    std::sort(eval.keyframe_pts.begin(), eval.keyframe_pts.end());
     eval.pts_first          = probe_data.pts_first;
     eval.pts_last           = probe_data.pts_last;
     eval.has_bframes        = probe_data.has_bframes;
@@ -501,6 +524,10 @@ void MediaPlayer::open (const std::string & filename, const std::string &uri)
     // set path
     filename_ = BaseToolkit::transliterate( filename );
 
+    // forget proxy of previous media
+    proxy_ = false;
+    proxy_uri_.clear();
+
     // set uri to open
     if (uri.empty())
         uri_ = GstToolkit::filename_to_uri( filename );
@@ -513,6 +540,8 @@ void MediaPlayer::open (const std::string & filename, const std::string &uri)
     // close before re-openning
     if (isOpen())
         close();
+    suspended_ = false;
+    suspended_position_ = GST_CLOCK_TIME_NONE;
 
     // start URI discovering thread:
     discoverer_ = std::async( MediaPlayer::UriDiscoverer, uri_);
@@ -638,6 +667,21 @@ void MediaPlayer::execute_open()
     }
     g_object_set( G_OBJECT (pipeline_), "flags", flags, NULL);
 
+    // feed audio into a channel of the mixing bus, synchronized to its clock
+    audio_mixing_ = false;
+    if (media_.hasaudio && audio_enabled_ && Settings::application.audio_mixing) {
+        GstElement *audio_sink = Audio::manager().createChannel(id_);
+        if (audio_sink) {
+            g_object_set( G_OBJECT (pipeline_), "audio-sink", audio_sink, NULL);
+            GstClock *clock = Audio::manager().mixingClock();
+            if (clock) {
+                gst_pipeline_use_clock(GST_PIPELINE(pipeline_), clock);
+                gst_object_unref(clock);
+            }
+            audio_mixing_ = true;
+        }
+    }
+
     // hack to compensate for lack of PTS in gif animations
     if (media_.codec_name.compare("image/gst-libav-gif") == 0) {
         media_.codec_name = "GIF";
@@ -872,6 +916,10 @@ void MediaPlayer::execute_open()
         description += "imagefreeze ! ";
     }
 
+    // proxy might be few pixels different than expected
+    if (proxy_)
+        description += "videoscale ! ";
+
     // set app sink
     description += "queue ! appsink name=sink";
 
@@ -1061,28 +1109,32 @@ void MediaPlayer::close()
         return;
     }
 
+    // reset playback speed
+    rate_ = 1.0;
+    rate_change_ = RATE_CHANGE_NONE;
+
+    execute_release();
+}
+
+void MediaPlayer::execute_release()
+{
     // un-ready the media player
     opened_ = false;
     failed_ = false;
     pending_ = false;
     seeking_ = false;
     force_update_ = false;
-    rate_ = 1.0;
-    rate_change_ = RATE_CHANGE_NONE;
     position_ = GST_CLOCK_TIME_NONE;
 
     // cleanup eventual remaining frame memory
-    for(guint i = 0; i < N_VFRAME; i++) {
-        frame_[i].access.lock();
-        if (frame_[i].buffer) {
-            gst_buffer_unref(frame_[i].buffer);
-            frame_[i].buffer = NULL;
-        }
-        frame_[i].status = INVALID;
-        frame_[i].access.unlock();
-    }
-    write_index_ = 0;
-    last_index_ = 0;
+    frames_.clear();
+
+    // cleanup frames cached for backward play
+    reverse_.active = false;
+    reverse_clear();
+
+    // cleanup frames cached in memory
+    clip_release();
 
     // clean up GST
     if (pipeline_ != nullptr) {
@@ -1093,6 +1145,12 @@ void MediaPlayer::close()
         bus_ = nullptr;
     }
 
+    // release channel in audio mixing bus
+    if (audio_mixing_) {
+        Audio::manager().removeChannel(id_);
+        audio_mixing_ = false;
+    }
+
     // cleanup picture buffer
     if (pbo_[0]) {
         glDeleteBuffers(2, pbo_);
@@ -1104,17 +1162,18 @@ void MediaPlayer::close()
 
 guint MediaPlayer::width() const
 {
-    return media_.width;
+    // NB: when decoding the proxy, media_ has the dimensions of the proxy
+    return proxy_ ? proxy_width_ : media_.width;
 }
 
 guint MediaPlayer::height() const
 {
-    return media_.height;
+    return proxy_ ? proxy_height_ : media_.height;
 }
 
 float MediaPlayer::aspectRatio() const
 {
-    return static_cast<float>(media_.par_width) / static_cast<float>(media_.height);
+    return static_cast<float>(media_.par_width) / static_cast<float>(height());
 }
 
 GstClockTime MediaPlayer::position()
@@ -1143,7 +1202,7 @@ void MediaPlayer::enable(bool on)
 
         // unpause only if enabled
         if (enabled_)
-            requested_state = desired_state_;
+            requested_state = pipeline_state();
 
         //  apply state change
         GstStateChangeReturn ret = gst_element_set_state (pipeline_, requested_state);
@@ -1160,6 +1219,82 @@ bool MediaPlayer::isEnabled() const
     return enabled_;
 }
 
+void MediaPlayer::suspend(bool on)
+{
+    if ( suspended_ == on || failed_ )
+        return;
+
+    if (on) {
+        // can suspend only an opened media
+        if ( !opened_ || pipeline_ == nullptr )
+            return;
+        // remember position to restore
+        suspended_position_ = position();
+        suspended_ = true;
+        // terminate pipeline (the texture keeps the last frame)
+        execute_release();
+    }
+    else {
+        suspended_ = false;
+        execute_reopen(suspended_position_);
+    }
+}
+
+void MediaPlayer::execute_reopen(GstClockTime position)
+{
+    // re-create pipeline
+    execute_open();
+    // remain paused if disabled
+    if ( opened_ && !enabled_ )
+        gst_element_set_state (pipeline_, GST_STATE_PAUSED);
+
+    // position, speed and direction are restored in update, after preroll
+    suspended_position_ = position;
+    if ( suspended_position_ == GST_CLOCK_TIME_NONE && rate_ != 1.0 )
+        suspended_position_ = timeline_.first();
+
+    // cache frames in memory again (loading is started in update)
+    clip_.refused = false;
+}
+
+void MediaPlayer::setProxy(const std::string &filename, guint height)
+{
+    // proxy can be set only once media was discovered, and only for videos
+    if ( !opened_ || proxy_ || media_.isimage || height < 2 )
+        return;
+
+    proxy_uri_ = GstToolkit::filename_to_uri( filename );
+
+    // same dimensions as the Transcoder: even, with square pixels
+    proxy_height_ = height & ~1u;
+    proxy_width_ = ((guint) ((double) media_.par_width * height / media_.height + 0.5)) & ~1u;
+}
+
+void MediaPlayer::useProxy(bool on)
+{
+    if ( proxy_ == on || proxy_uri_.empty() || failed_ || suspended_ || !opened_ || pipeline_ == nullptr )
+        return;
+
+    // remember position to restore
+    GstClockTime pos = position();
+    execute_release();
+
+    // swap uri and dimensions of full resolution and proxy media
+    // (media_ keeps the uri and dimensions of the decoded stream)
+    proxy_ = on;
+    std::swap(uri_, proxy_uri_);
+    std::swap(media_.width, proxy_width_);
+    std::swap(media_.height, proxy_height_);
+
+    // re-create the texture at next frame (keeping previous frame meanwhile)
+    texture_resize_ = true;
+
+    // re-create pipeline
+    execute_reopen(pos);
+
+    Log::Info("MediaPlayer %s decoding %s.", std::to_string(id_).c_str(), proxy_ ? "proxy" : "full resolution");
+}
+
 bool MediaPlayer::isImage() const
 {
     return media_.isimage;
@@ -1229,7 +1364,7 @@ void MediaPlayer::execute_play_command(bool on)
     }
 
     // all ready, apply state change immediately
-    GstStateChangeReturn ret = gst_element_set_state (pipeline_, desired_state_);
+    GstStateChangeReturn ret = gst_element_set_state (pipeline_, pipeline_state());
     if (ret == GST_STATE_CHANGE_FAILURE) {
         Log::Warning("MediaPlayer %s Failed to play", std::to_string(id_).c_str());
         failed_ = true;
@@ -1242,8 +1377,11 @@ void MediaPlayer::execute_play_command(bool on)
 #endif
 
     // Revert loop status to default when playing
-    if (on)
+    if (on) {
         loop_status_ = LoopStatus::LOOP_STATUS_DEFAULT;
+        // restart presentation time of frames from cache
+        g_timer_start(cache_timer_);
+    }
 }
 
 void MediaPlayer::play(bool on)
@@ -1339,6 +1477,12 @@ void MediaPlayer::step(uint milisecond)
     if ( ( rate_ < 0.0 && position_ <= timeline_.next(0)  )
          || ( rate_ > 0.0 && position_ >= timeline_.previous(timeline_.last()) ) )
         rewind();
+    // next frame from memory
+    else if (clip_.active)
+        clip_step();
+    // previous frame from cache
+    else if (reverse_.active)
+        reverse_present(1);
     else {
         // step event
         if (milisecond < media_.dt)
@@ -1409,6 +1553,13 @@ void MediaPlayer::jump(uint milisecond)
     if (!enabled_ || !isPlaying())
         return;
 
+    // jump in memory
+    if (clip_.active) {
+        GstClockTime d = CLAMP(milisecond, 1, 1000) * GST_MSECOND;
+        clip_seek( rate_ > 0.0 ? clip_.position + d : ( clip_.position > d ? clip_.position - d : 0 ) );
+        return;
+    }
+
     gst_element_send_event (pipeline_, gst_event_new_step (GST_FORMAT_TIME,
                                                            CLAMP(milisecond, 1, 1000) * GST_MSECOND,
                                                            ABS(rate_),
@@ -1416,21 +1567,21 @@ void MediaPlayer::jump(uint milisecond)
 
 }
 
-void MediaPlayer::init_texture(guint index)
+void MediaPlayer::init_texture(GstBuffer *buf)
 {
     glActiveTexture(GL_TEXTURE0);
     glGenTextures(1, &textureindex_);
     glBindTexture(GL_TEXTURE_2D, textureindex_);
     glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, media_.width, media_.height);
 
-    // fill texture frame with frame at given index
-    if (frame_[index].buffer) {
+    // fill texture frame with frame
+    if (buf) {
 
 #ifdef USE_GST_OPENGL_SYNC_HANDLER
         // Try GLMemory fast path first
         bool gl_memory_used = false;
         if ( use_gl_memory_ ) {
-            GstMemory *mem = gst_buffer_peek_memory(frame_[index].buffer, 0);
+            GstMemory *mem = gst_buffer_peek_memory(buf, 0);
 
             if (mem && gst_is_gl_memory(mem)) {
                 GstGLMemory *gl_mem = (GstGLMemory*) mem;
@@ -1464,10 +1615,10 @@ void MediaPlayer::init_texture(guint index)
 #endif
         {
             GstMapInfo map;
-            gst_buffer_map(frame_[index].buffer, &map, GST_MAP_READ);
+            gst_buffer_map(buf, &map, GST_MAP_READ);
             glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, media_.width, media_.height,
                             GL_RGBA, GL_UNSIGNED_BYTE, map.data);
-            gst_buffer_unmap (frame_[index].buffer, &map);
+            gst_buffer_unmap (buf, &map);
         }
     }
 
@@ -1509,21 +1660,31 @@ void MediaPlayer::init_texture(guint index)
 }
 
 
-void MediaPlayer::fill_texture(guint index)
+void MediaPlayer::fill_texture(GstBuffer *buf)
 {
+    ++texture_updates_;
+
+    // dimensions changed (proxy) ?
+    if (texture_resize_ && buf) {
+        if (textureindex_)
+            glDeleteTextures(1, &textureindex_);
+        textureindex_ = 0;
+        texture_resize_ = false;
+    }
+
     // is this the first frame ?
     if (textureindex_ < 1)
     {
         // initialize texture on first run
-        // (this also fills the texture with frame at index)
-        init_texture(index);
+        // (this also fills the texture with frame)
+        init_texture(buf);
     }
-    else if (!isImage() && frame_[index].buffer) {
+    else if (!isImage() && buf) {
 
 #ifdef USE_GST_OPENGL_SYNC_HANDLER
         // Try GLMemory fast path first (zero-copy GPU texture)
         if (use_gl_memory_) {
-            GstMemory *mem = gst_buffer_peek_memory(frame_[index].buffer, 0);
+            GstMemory *mem = gst_buffer_peek_memory(buf, 0);
 
             if (mem && gst_is_gl_memory(mem)) {
                 // FAST PATH: Direct GL texture extraction from GStreamer
@@ -1563,7 +1724,7 @@ void MediaPlayer::fill_texture(guint index)
         // FALLBACK: CPU path (standard PBO or direct upload)
         // Use GST mapping to access pointer to RGBA data
         GstMapInfo map;
-        gst_buffer_map(frame_[index].buffer, &map, GST_MAP_READ);
+        gst_buffer_map(buf, &map, GST_MAP_READ);
 
         // bind texture for writing
         glBindTexture(GL_TEXTURE_2D, textureindex_);
@@ -1610,7 +1771,7 @@ void MediaPlayer::fill_texture(guint index)
         glBindTexture(GL_TEXTURE_2D, 0);
 
         // unmap buffer to let it free
-        gst_buffer_unmap (frame_[index].buffer, &map);
+        gst_buffer_unmap (buf, &map);
 
     }
 }
@@ -1647,6 +1808,16 @@ void MediaPlayer::update()
         return;
     }
 
+    // restore position after resume, as soon as prerolled (non-blocking test)
+    if ( suspended_position_ != GST_CLOCK_TIME_NONE && !suspended_ ) {
+        if ( gst_element_get_state (pipeline_, NULL, NULL, 0) == GST_STATE_CHANGE_SUCCESS ) {
+            execute_seek_command(suspended_position_);
+            suspended_position_ = GST_CLOCK_TIME_NONE;
+            // show frame at position even if disabled
+            force_update_ = true;
+        }
+    }
+
     // collect evaluation result when ready (non-blocking)
     if (evaluator_.valid()) {
         if (evaluator_.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
@@ -1663,6 +1834,9 @@ void MediaPlayer::update()
                     // adjust timeline to media frames range 
                     timeline_.setFirst(evaluation_.pts_first);
                     timeline_.setLast(evaluation_.pts_last);
+                    // already playing backward: switch to cache
+                    if (rate_ < 0.0 && reverseCacheAvailable())
+                        execute_seek_command();
                 }
             } 
              
@@ -1673,54 +1847,84 @@ void MediaPlayer::update()
     if ( (!enabled_ && !force_update_) || (singleFrame() && textureindex_>0 ) )
         return;
 
-    // local variables before trying to update
-    guint read_index = 0;
-    bool need_loop = false;
+    // timing of the timeline changed: cache frames of the new sections
+    if ( clip_cache_ && (clip_.active || clip_.refused || clip_loader_.valid())
+         && clip_.revision != timeline_.revision() ) {
+        setClipCache(false);
+        setClipCache(true);
+    }
+
+    // clip cache loaded
+    if (clip_loader_.valid()) {
+        if (clip_loader_.wait_for(std::chrono::milliseconds(0)) == std::future_status::ready) {
+            ClipFrames clip = clip_loader_.get();
+            if (clip.log.empty() && !clip.frames.empty()) {
+                // replace backward play from cache
+                if (reverse_.active)
+                    reverse_stop();
+                // present frames from memory, and pause decoding
+                clip_.frames = std::move(clip.frames);
+                clip_.active = true;
+                clip_seek(position_);
+                gst_element_set_state (pipeline_, pipeline_state());
+                Log::Info("MediaPlayer %s Cached %lu frames in memory (%lu MB)", std::to_string(id_).c_str(),
+                          clip_.frames.size(), clip.size / 1048576);
+            }
+            else {
+                Log::Warning("MediaPlayer %s Cannot cache frames in memory: %s", std::to_string(id_).c_str(), clip.log.c_str());
+                unref_frames(clip.frames);
+                clip_.refused = true;
+                CacheBudget::manager().release(clip_.reserved);
+                clip_.reserved = 0;
+            }
+        }
+    }
+    // load clip cache
+    else if (clip_cache_ && !clip_.active && !clip_.refused)
+        clip_load();
 
-    // locked access to current index
-    index_lock_.lock();
-    // get the last frame filled from fill_frame()
-    read_index = last_index_;
-    // unlock access to index change
-    index_lock_.unlock();
+    // present frames from memory
+    if (clip_.active) {
+        if (enabled_)
+            clip_update();
+    }
+    // backward play from cache
+    else if (reverse_.active) {
+        // fallback to gstreamer if cache is no longer available
+        if ( !reverseCacheAvailable() )
+            execute_seek_command();
+        // present frames from cache
+        else if (enabled_)
+            reverse_update();
+    }
 
-    // lock frame while reading it
-    frame_[read_index].access.lock();
+    bool need_loop = false;
 
-    // do not fill a frame twice
-    if (frame_[read_index].status != INVALID ) {
+    // get the last frame filled from fill_frame(), if any
+    FrameSlots::Frame frame;
+    if ( frames_.pop(frame) ) {
 
         // is this an End-of-Stream frame ?
-        if (frame_[read_index].status == EOS )
+        if (frame.status == FrameSlots::EOS )
         {
-            // will execute seek command below (after unlock)
+            // will execute seek command below
             need_loop = true;
         }
         // otherwise just fill non-empty SAMPLE or PREROLL
-        else if (frame_[read_index].is_new)
+        else
         {
-            // fill the texture with the frame at reading index
-            fill_texture(read_index);
+            // fill the texture with the frame
+            fill_texture(frame.buffer);
 
             // double update for pre-roll frame and dual PBO (ensure frame is displayed now)
-            if ( (frame_[read_index].status == PREROLL || seeking_ ) && pbo_size_ > 0)
-                fill_texture(read_index);
-
-            // // free frame
-            // frame_[read_index].unmap();
-            frame_[read_index].is_new = false;
+            if ( (frame.status == FrameSlots::PREROLL || seeking_ ) && pbo_size_ > 0)
+                fill_texture(frame.buffer);
         }
 
         // we just displayed a vframe : set position time to frame PTS
-        position_ = frame_[read_index].position;
-
-        // avoid reading it again
-        frame_[read_index].status = INVALID;
+        position_ = frame.position;
     }
 
-    // unkock frame after reading it
-    frame_[read_index].access.unlock();
-
     // if already seeking (asynch)
     if (seeking_) {
         // fail counter
@@ -1823,6 +2027,21 @@ void MediaPlayer::execute_seek_command(GstClockTime target, bool force)
     if ( !opened_ || pipeline_ == nullptr || !media_.seekable )
         return;
 
+    // all frames in memory
+    if ( clip_.active ) {
+        clip_seek(target);
+        return;
+    }
+
+    // backward play from cache of frames decoded forward
+    if ( rate_ < 0.0 && reverseCacheAvailable() ) {
+        reverse_seek(target);
+        return;
+    }
+    // otherwise leave backward play from cache
+    else if ( reverse_.active )
+        reverse_stop();
+
     // ignore request to current position
     if ( ABS_DIFF(target, position_) < timeline_.step())
         return;
@@ -1896,6 +2115,15 @@ void MediaPlayer::setPlaySpeed(double s)
     if (pipeline_ == nullptr || !media_.seekable)
         return;
 
+    // frames from cache are presented at the new rate
+    if ( clip_.active || ( reverse_.active && rate_ < 0.0 ) )
+        return;
+    // enter or leave backward play from cache
+    if ( reverse_.active || ( rate_ < 0.0 && reverseCacheAvailable() ) ) {
+        execute_seek_command();
+        return;
+    }
+
     //
     // Apply rate change with gstreamer seek
     //
@@ -1999,7 +2227,8 @@ MediaInfo MediaPlayer::media() const
 
 std::string MediaPlayer::uri() const
 {
-    return uri_;
+    // NB: when decoding the proxy, uri_ is the uri of the proxy
+    return proxy_ ? proxy_uri_ : uri_;
 }
 
 std::string MediaPlayer::filename() const
@@ -2018,37 +2247,516 @@ double MediaPlayer::updateFrameRate() const
 }
 
 
-// CALLBACKS
+bool MediaPlayer::reverseCacheAvailable() const
+{
+    // user preference, for media with frames to decode between keyframes
+    // (not needed when all frames are in memory)
+    if ( !Settings::application.render.reverse_cache || !opened_ || media_.isimage || !media_.seekable || clip_.active )
+        return false;
+
+    // requires the complete list of keyframes from evaluation
+    if ( !evaluation_.done || !evaluation_.log.empty() || evaluation_.gop_size_max < 2
+         || evaluation_.keyframe_pts.empty() || evaluation_.keyframe_pts.size() < evaluation_.keyframe_count )
+        return false;
+
+    // audio cannot follow frames presented from cache
+    if ( media_.hasaudio && audio_enabled_ )
+        return false;
+
+#ifdef USE_GST_OPENGL_SYNC_HANDLER
+    // frames are cached in system memory
+    if ( use_gl_memory_ )
+        return false;
+#endif
+
+    return true;
+}
+
+void MediaPlayer::set_sink_sync(bool on)
+{
+    if ( pipeline_ == nullptr )
+        return;
 
-bool MediaPlayer::fill_frame(GstBuffer *buf, FrameStatus status)
+#ifdef USE_GST_PLAYBIN
+    GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline_), "appsink");
+#else
+    GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline_), "sink");
+#endif
+    if (sink) {
+        gst_base_sink_set_sync (GST_BASE_SINK(sink), on);
+        gst_object_unref (sink);
+    }
+}
+
+void MediaPlayer::reverse_seek(GstClockTime target)
 {
-    // Do NOT overwrite an unread EOS
-    if ( frame_[write_index_].status == EOS )
-        write_index_ = (write_index_ + 1) % N_VFRAME;
+    // start backward play from cache
+    if ( !reverse_.active ) {
+        // decode intervals of frames filling half of the cache
+        guint64 framesize = (guint64) media_.width * (guint64) media_.height * 4;
+        guint64 chunk = ( (guint64) REVERSE_CACHE_SIZE * 1048576 ) / ( 2 * framesize );
+        reverse_.chunk = (guint) CLAMP(chunk, 2, MAX_KEYFRAME_STORED);
+        reverse_.active = true;
 
-    // lock access to frame
-    frame_[write_index_].access.lock();
+        // frames are decoded as fast as possible, and presented in time by update()
+        set_sink_sync(false);
+        if (enabled_)
+            gst_element_set_state (pipeline_, GST_STATE_PLAYING);
 
-    // always empty frame before filling it again
-    if (frame_[write_index_].buffer) {
-        gst_buffer_unref(frame_[write_index_].buffer);
-        frame_[write_index_].buffer = NULL;
+#ifdef MEDIA_PLAYER_DEBUG
+        Log::Info("MediaPlayer %s Backward play from cache of %d frames", std::to_string(id_).c_str(), 2 * reverse_.chunk);
+#endif
     }
 
-    // accept status of frame received
-    frame_[write_index_].status = status;
+    // default to current position
+    if (target == GST_CLOCK_TIME_NONE)
+        target = position_;
+    target = CLAMP(target, timeline_.first(), timeline_.last());
 
-    // a buffer is given (not EOS)
-    if (buf != NULL) {
+    // restart from target
+    reverse_clear();
+    reverse_.access.lock();
+    reverse_.position = target + 1;
+    reverse_.lowest = target + 1;
+    reverse_.decoded = true;
+    reverse_.access.unlock();
+    reverse_.presented = false;
+    reverse_.ended = false;
+    g_timer_start(cache_timer_);
+
+    // moving to a new position, necessarily leaves any flag we were at
+    current_flag_.reset();
+
+    // immediately request frames before target
+    reverse_request();
+}
+
+void MediaPlayer::reverse_stop()
+{
+    reverse_.active = false;
+    reverse_clear();
+
+    // restore synchronized playing of the pipeline
+    set_sink_sync(true);
+    if ( pipeline_ != nullptr )
+        gst_element_set_state (pipeline_, enabled_ ? pipeline_state() : GST_STATE_PAUSED);
+}
+
+GstState MediaPlayer::pipeline_state() const
+{
+    // nothing to decode when all frames are in memory
+    if ( clip_.active )
+        return GST_STATE_PAUSED;
+
+    // backward play from cache keeps decoding while paused
+    if ( reverse_.active )
+        return GST_STATE_PLAYING;
+
+    return desired_state_;
+}
+
+void MediaPlayer::reverse_clear()
+{
+    reverse_.access.lock();
+    unref_frames(reverse_.frames);
+    reverse_.decoding.reset();
+    reverse_.access.unlock();
+}
 
-        // copy the buffer in the frame
-        frame_[write_index_].buffer = gst_buffer_copy(buf);
+void MediaPlayer::reverse_request()
+{
+    // wait for end of previous interval, or beginning reached
+    GstClockTime first = timeline_.first();
+    if ( !reverse_.decoded || reverse_.lowest <= first )
+        return;
+
+    // interval of frames before the lowest decoded
+    GstClockTime duration = reverse_.chunk * timeline_.step();
+    GstClockTime end = reverse_.lowest;
+
+    // decoding starts from the keyframe preceding the interval,
+    // and covers as many whole GOPs as fit in the cache
+    const std::vector<GstClockTime> &keyframes = evaluation_.keyframe_pts;
+    auto k = std::lower_bound(keyframes.begin(), keyframes.end(), end);
+    GstClockTime start = ( k == keyframes.begin() ) ? 0 : *(--k);
+    while ( k != keyframes.begin() && end - *std::prev(k) <= duration )
+        start = *(--k);
+
+    // GOP larger than the cache: keep only its end (its beginning is decoded again next time)
+    GstClockTime begin = end - start > duration ? end - duration : start;
+    begin = MAX(begin, first);
+
+    reverse_.access.lock();
+    reverse_.decoding = TimeInterval(begin, end);
+    reverse_.access.unlock();
+
+    // decode forward until the end of interval
+    GstEvent *seek_event = gst_event_new_seek (1.0, GST_FORMAT_TIME,
+                                               (GstSeekFlags) (GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
+                                               GST_SEEK_TYPE_SET, start, GST_SEEK_TYPE_SET, end);
+
+    // NB: flushing seek returns after the previous segment is stopped,
+    // so end of stream can only come from this new interval
+    bool sent = seek_event && gst_element_send_event(pipeline_, seek_event);
+    if ( !sent )
+        Log::Warning("MediaPlayer %s Failed to decode frames for backward play.", std::to_string(id_).c_str());
+
+    reverse_.access.lock();
+    if ( sent ) {
+        reverse_.decoded = false;
+        reverse_.lowest = begin;
+    }
+    else
+        reverse_.lowest = first;
+    reverse_.access.unlock();
+}
+
+bool MediaPlayer::reverse_present(guint n)
+{
+    bool ret = false;
 
-        // indicate to update loop that buffer is new
-        frame_[write_index_].is_new = true;
+    reverse_.access.lock();
 
-        // set presentation time stamp
-        frame_[write_index_].position = buf->pts;
+    // frames below the interval being decoded are not complete
+    GstClockTime complete = reverse_.decoded ? reverse_.lowest : reverse_.decoding.end;
+
+    // go back n frames before position
+    auto found = reverse_.frames.end();
+    auto it = reverse_.frames.lower_bound(reverse_.position);
+    for (guint i = 0; i < n && it != reverse_.frames.begin(); ++i) {
+        --it;
+        if (it->first < complete)
+            break;
+        found = it;
+    }
+
+    if ( found != reverse_.frames.end() ) {
+        // fill frame with buffer
+        ret = fill_frame(found->second, FrameSlots::SAMPLE);
+        reverse_.position = found->first;
+
+        // frames after this one will not be presented again
+        for (it = std::next(found); it != reverse_.frames.end(); ) {
+            gst_buffer_unref(it->second);
+            it = reverse_.frames.erase(it);
+        }
+    }
+
+    reverse_.access.unlock();
+
+    return ret;
+}
+
+void MediaPlayer::reverse_update()
+{
+    // decode next interval when at most one interval remains in cache
+    reverse_.access.lock();
+    size_t cached = reverse_.frames.size();
+    reverse_.access.unlock();
+    if ( cached <= reverse_.chunk )
+        reverse_request();
+
+    // count frames to present since previous one
+    guint n = 0;
+    if ( !reverse_.presented )
+        n = 1;
+    else if ( desired_state_ == GST_STATE_PLAYING && !reverse_.ended ) {
+        double period = (double) timeline_.step() / (double) GST_SECOND / ABS(rate_);
+        n = (guint) ( g_timer_elapsed(cache_timer_, NULL) / period );
+    }
+
+    if ( n > 0 ) {
+        // present frame n times before
+        if ( reverse_present(n) ) {
+            reverse_.presented = true;
+            g_timer_start(cache_timer_);
+        }
+        // all frames were presented: end of stream
+        else if ( reverse_.decoded && reverse_.lowest <= timeline_.first() && !reverse_.ended ) {
+            fill_frame(NULL, FrameSlots::EOS);
+            reverse_.ended = true;
+        }
+    }
+}
+
+void MediaPlayer::reverse_fill(GstBuffer *buf)
+{
+    if ( buf == NULL || !GST_BUFFER_PTS_IS_VALID(buf) )
+        return;
+
+    reverse_.access.lock();
+
+    // keep frames of the interval requested, only once
+    if ( reverse_.decoding.is_valid() && buf->pts >= reverse_.decoding.begin
+         && buf->pts < reverse_.decoding.end && reverse_.frames.count(buf->pts) < 1 )
+        // deep copy to release buffers of the decoder
+        reverse_.frames[buf->pts] = gst_buffer_copy_deep(buf);
+
+    reverse_.access.unlock();
+}
+
+void MediaPlayer::setClipCache(bool on)
+{
+    if ( clip_cache_ == on )
+        return;
+
+    clip_cache_ = on;
+
+    // new request for admission in budget
+    clip_.refused = false;
+
+    // return to decoding frames
+    if ( !clip_cache_ ) {
+        GstClockTime position = clip_.position;
+        clip_release();
+        if ( opened_ && pipeline_ != nullptr ) {
+            gst_element_set_state (pipeline_, enabled_ ? pipeline_state() : GST_STATE_PAUSED);
+            if (position != GST_CLOCK_TIME_NONE)
+                execute_seek_command(position, true);
+        }
+    }
+    // NB: loading is started in update()
+}
+
+void MediaPlayer::clip_load()
+{
+    if ( !opened_ || pipeline_ == nullptr || media_.isimage || !media_.seekable
+         || timeline_.step() == GST_CLOCK_TIME_NONE || timeline_.step() < 1 )
+        return;
+
+    // estimate memory needed for all frames of timeline sections
+    clip_.revision = timeline_.revision();
+    guint64 framesize = (guint64) media_.width * (guint64) media_.height * 4;
+    guint64 size = ( timeline_.sectionsDuration() / timeline_.step() + 2 ) * framesize;
+
+    // admission in global memory budget
+    uint64_t available = 0;
+    if ( !CacheBudget::manager().reserve(size, &available) ) {
+        clip_.refused = true;
+        Log::Notify("Cannot cache '%s' in memory; %lu MB needed, %lu MB available.",
+                    SystemToolkit::filename(filename_).c_str(), size / 1048576, available / 1048576);
+        return;
+    }
+    clip_.reserved = size;
+
+    // Create gstreamer pipeline decoding in system memory, like execute_open() :
+    //         "uridecodebin uri=file:///path_to_file/filename.mp4 ! videoconvert ! appsink "
+    std::string description = "uridecodebin name=decoder uri=" + uri_ + " ! ";
+    if (media_.interlaced)
+        description += "deinterlace method=2 ! ";
+    if ( !video_filter_.empty()) {
+        description += "videoconvert chroma-resampler=1 dither=0 ! ";
+        description += video_filter_ + " ! ";
+    }
+    description += "videoconvert chroma-resampler=1 dither=0 ! ";
+    if (proxy_)
+        description += "videoscale ! ";
+    description += "video/x-raw,format=RGBA,width=" + std::to_string(media_.width) +
+                   ",height=" + std::to_string(media_.height) + " ! ";
+    description += "appsink name=sink sync=false";
+
+    // load asynchronously
+    clip_loader_cancel_ = std::make_shared<std::atomic<bool>>(false);
+    clip_loader_ = std::async(MediaPlayer::ClipLoader, description, timeline_.sections(), size, clip_loader_cancel_);
+}
+
+void MediaPlayer::clip_release()
+{
+    // cancel loading
+    if (clip_loader_.valid() && clip_loader_cancel_)
+        clip_loader_cancel_->store(true);
+
+    // free memory and budget in background (waits for end of loading)
+    if (clip_loader_.valid() || !clip_.frames.empty() || clip_.reserved > 0)
+        std::thread(MediaPlayer::ClipRelease, std::move(clip_loader_), std::move(clip_.frames), clip_.reserved).detach();
+
+    clip_.frames.clear();
+    clip_.reserved = 0;
+    clip_.active = false;
+}
+
+void MediaPlayer::ClipRelease(std::future<ClipFrames> loader, FrameCache frames, guint64 reserved)
+{
+    if (loader.valid()) {
+        ClipFrames clip = loader.get();
+        unref_frames(clip.frames);
+    }
+    unref_frames(frames);
+    CacheBudget::manager().release(reserved);
+}
+
+void MediaPlayer::clip_seek(GstClockTime target)
+{
+    // default to current position
+    if (target == GST_CLOCK_TIME_NONE)
+        target = clip_.position != GST_CLOCK_TIME_NONE ? clip_.position : position_;
+    if (target == GST_CLOCK_TIME_NONE)
+        target = timeline_.first();
+
+    clip_.position = CLAMP(target, timeline_.first(), timeline_.last());
+    clip_.shown = GST_CLOCK_TIME_NONE;
+    clip_.ended = false;
+    g_timer_start(cache_timer_);
+
+    // moving to a new position, necessarily leaves any flag we were at
+    current_flag_.reset();
+}
+
+void MediaPlayer::clip_step()
+{
+    if ( clip_.frames.empty() )
+        return;
+
+    // next frame in the direction of play
+    auto it = clip_.frames.upper_bound(clip_.position);
+    if ( rate_ < 0.0 ) {
+        it = clip_.frames.lower_bound(clip_.position);
+        if ( it == clip_.frames.begin() )
+            return;
+        --it;
+    }
+    if ( it != clip_.frames.end() )
+        clip_seek(it->first);
+}
+
+void MediaPlayer::clip_update()
+{
+    if ( clip_.frames.empty() )
+        return;
+
+    // advance presentation time while playing
+    if ( desired_state_ == GST_STATE_PLAYING && !clip_.ended ) {
+        double d = g_timer_elapsed(cache_timer_, NULL) * ABS(rate_) * (double) GST_SECOND;
+        g_timer_start(cache_timer_);
+        if ( rate_ > 0.0 )
+            clip_.position += (GstClockTime) d;
+        else
+            clip_.position = clip_.position > (GstClockTime) d ? clip_.position - (GstClockTime) d : 0;
+
+        // beyond extremity of timeline: end of stream
+        if ( clip_.position > timeline_.last() || clip_.position < timeline_.first() ) {
+            clip_.position = CLAMP(clip_.position, timeline_.first(), timeline_.last());
+            clip_.ended = true;
+            fill_frame(NULL, FrameSlots::EOS);
+            return;
+        }
+    }
+
+    // frame at presentation time
+    auto it = clip_.frames.upper_bound(clip_.position);
+    if ( it != clip_.frames.begin() )
+        --it;
+
+    // present only once
+    if ( it->first != clip_.shown ) {
+        fill_frame(it->second, FrameSlots::SAMPLE);
+        clip_.shown = it->first;
+    }
+}
+
+MediaPlayer::ClipFrames MediaPlayer::ClipLoader(const std::string &description, TimeIntervalSet sections,
+                                                guint64 limit, std::shared_ptr<std::atomic<bool>> cancelled)
+{
+    ClipFrames clip;
+
+    if (sections.empty()) {
+        clip.log = "Empty timeline";
+        return clip;
+    }
+
+    // parse pipeline descriptor
+    GError *error = NULL;
+    GstElement *pipeline = gst_parse_launch (description.c_str(), &error);
+    if (error != NULL) {
+        clip.log = std::string(error->message);
+        g_clear_error (&error);
+        if (pipeline)
+            gst_object_unref(pipeline);
+        return clip;
+    }
+
+    // decoding in system memory
+    GstElement *decoder = gst_bin_get_by_name (GST_BIN (pipeline), "decoder");
+    if (decoder) {
+        g_object_set (G_OBJECT (decoder), "force-sw-decoders", true,  NULL);
+        gst_object_unref (decoder);
+    }
+    GstElement *sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+    GstBus *bus = gst_element_get_bus(pipeline);
+
+    // preroll, then decode from begin to end of timeline sections
+    gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    if ( sink == NULL
+         || gst_element_get_state(pipeline, NULL, NULL, DISCOVER_TIMOUT * GST_SECOND) == GST_STATE_CHANGE_FAILURE
+         || !gst_element_seek(pipeline, 1.0, GST_FORMAT_TIME, (GstSeekFlags) (GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE),
+                              GST_SEEK_TYPE_SET, sections.begin()->begin, GST_SEEK_TYPE_SET, sections.rbegin()->end) )
+        clip.log = "Failed to decode";
+    else
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+    // pull all frames, polling in 200 ms chunks to allow cancellation
+    const GstClockTime chunk = 200 * GST_MSECOND;
+    GstClockTime idle = 0;
+    while ( clip.log.empty() && !gst_app_sink_is_eos(GST_APP_SINK(sink)) ) {
+        if (cancelled && cancelled->load()) {
+            clip.log = "Cancelled";
+            break;
+        }
+
+        GstSample *sample = gst_app_sink_try_pull_sample(GST_APP_SINK(sink), chunk);
+        if (sample == NULL) {
+            GstMessage *msg = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR);
+            if (msg) {
+                GError *err = NULL;
+                gst_message_parse_error(msg, &err, NULL);
+                clip.log = err ? std::string(err->message) : "Pipeline error";
+                g_clear_error(&err);
+                gst_message_unref(msg);
+            }
+            else if ( (idle += chunk) > DISCOVER_TIMOUT * GST_SECOND )
+                clip.log = "Timeout";
+            continue;
+        }
+        idle = 0;
+
+        // keep frames in timeline sections, only once
+        GstBuffer *buf = gst_sample_get_buffer (sample);
+        if ( buf && GST_BUFFER_PTS_IS_VALID(buf) && clip.frames.count(buf->pts) < 1 ) {
+            for (auto s = sections.begin(); s != sections.end(); ++s) {
+                if ( s->includes(buf->pts) ) {
+                    // within memory reserved in budget
+                    clip.size += gst_buffer_get_size(buf);
+                    if (clip.size > limit)
+                        clip.log = "Exceeds memory budget";
+                    else
+                        clip.frames[buf->pts] = gst_buffer_copy_deep(buf);
+                    break;
+                }
+            }
+        }
+        gst_sample_unref(sample);
+    }
+
+    // stop pipeline synchronously
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_element_get_state(pipeline, NULL, NULL, GST_SECOND);
+    gst_object_unref(bus);
+    if (sink)
+        gst_object_unref(sink);
+    gst_object_unref(pipeline);
+
+    return clip;
+}
+
+// CALLBACKS
+
+bool MediaPlayer::fill_frame(GstBuffer *buf, FrameSlots::Status status)
+{
+    // a buffer is given (not EOS)
+    if (buf != NULL) {
+
+        // pass a copy of the buffer to update loop
+        frames_.push(buf, status);
 
         // set the start position (i.e. pts of first frame we got)
         if (timeline_.first() == GST_CLOCK_TIME_NONE) {
@@ -2060,23 +2768,8 @@ bool MediaPlayer::fill_frame(GstBuffer *buf, FrameStatus status)
 
     }
     // else; null buffer for EOS: give a position
-    else {
-        frame_[write_index_].status = EOS;
-        frame_[write_index_].position = rate_ > 0.0 ? timeline_.end() : timeline_.begin();
-    }
-
-    // unlock access to frame
-    frame_[write_index_].access.unlock();
-
-    // lock access to change current index (very quick)
-    index_lock_.lock();
-    // indicate update() that this is the last frame filled (and unlocked)
-    last_index_ = write_index_;
-    // unlock access to index change
-    index_lock_.unlock();
-
-    // for writing, we will access the next in stack
-    write_index_ = (write_index_ + 1) % N_VFRAME;
+    else
+        frames_.push(NULL, FrameSlots::EOS, rate_ > 0.0 ? timeline_.end() : timeline_.begin());
 
     // calculate actual FPS of update
     timecount_.tic();
@@ -2088,7 +2781,11 @@ void MediaPlayer::callback_end_of_stream (GstAppSink *, gpointer p)
 {
     MediaPlayer *m = static_cast<MediaPlayer *>(p);
     if (m && m->opened_) {
-        m->fill_frame(NULL, MediaPlayer::EOS);
+        // end of interval decoded for backward play from cache
+        if (m->reverse_.active)
+            m->reverse_.decoded = true;
+        else
+            m->fill_frame(NULL, FrameSlots::EOS);
     }
 }
 
@@ -2125,12 +2822,15 @@ GstFlowReturn MediaPlayer::callback_new_preroll (GstAppSink *sink, gpointer p)
             }
 #endif
 
+            // keep frame decoded for backward play from cache
+            if ( m->reverse_.active )
+                m->reverse_fill(buf);
             // fill frame from buffer
-            if ( !m->fill_frame(buf, MediaPlayer::PREROLL) )
+            else if ( !m->fill_frame(buf, FrameSlots::PREROLL) )
                 ret = GST_FLOW_ERROR;
             // loop negative rate: emulate an EOS
             else if (m->playSpeed() < 0.f && !(buf->pts > 0) ) {
-                m->fill_frame(NULL, MediaPlayer::EOS);
+                m->fill_frame(NULL, FrameSlots::EOS);
             }
         }
     }
@@ -2160,12 +2860,15 @@ GstFlowReturn MediaPlayer::callback_new_sample (GstAppSink *sink, gpointer p)
             // get buffer from sample (valid until sample is released)
             GstBuffer *buf = gst_sample_get_buffer (sample) ;
 
+            // keep frame decoded for backward play from cache
+            if ( m->reverse_.active )
+                m->reverse_fill(buf);
             // fill frame with buffer
-            if ( !m->fill_frame(buf, MediaPlayer::SAMPLE) )
+            else if ( !m->fill_frame(buf, FrameSlots::SAMPLE) )
                 ret = GST_FLOW_ERROR;
             // loop negative rate: emulate an EOS
             else if (m->playSpeed() < 0.f && !(buf->pts > 0) ) {
-                m->fill_frame(NULL, MediaPlayer::EOS);
+                m->fill_frame(NULL, FrameSlots::EOS);
             }
         }
     }
@@ -2220,6 +2923,12 @@ void MediaPlayer::setAudioEnabled(bool on)
 
 void MediaPlayer::setAudioVolume(gdouble vol)
 {
+    // volume ramp applied in the mixing bus
+    if (audio_mixing_) {
+        Audio::manager().setChannelVolume(id_, (float) vol);
+        return;
+    }
+
     if (pipeline_ && media_.hasaudio){
 
 #ifdef APPLE
@@ -2237,6 +2946,9 @@ void MediaPlayer::setAudioVolume(gdouble vol)
 
 gdouble MediaPlayer::audioVolume() const
 {
+    if (audio_mixing_)
+        return (gdouble) Audio::manager().channelVolume(id_);
+
     gdouble vol = 1.0;
     if (pipeline_ && media_.hasaudio)
         g_object_get (G_OBJECT(pipeline_), "volume", &vol, NULL);
@@ -2244,6 +2956,14 @@ gdouble MediaPlayer::audioVolume() const
     return vol;
 }
 
+float MediaPlayer::audioLevel() const
+{
+    if (audio_mixing_)
+        return Audio::manager().channelLevel(id_);
+
+    return 0.f;
+}
+
 void MediaPlayer::callback_element_setup (GstElement *pipeline, GstElement *element, MediaPlayer *mp)
 {
     if (pipeline && element && mp)
@@ -3,6 +3,7 @@
 
 #include <string>
 #include <vector>
+#include <map>
 #include <mutex>
 #include <future>
 #include <memory>
@@ -15,16 +16,17 @@
 
 #include "Timeline.h"
 #include "Metronome.h"
+#include "FrameSlots.h"
 
 // Forward declare classes referenced
 class Visitor;
 
 #define MAX_PLAY_SPEED 20.0
 #define MIN_PLAY_SPEED 0.1
-#define N_VFRAME 10
 #define DISCOVER_TIMOUT 15
 #define EVALUATE_TIMEOUT 5
 #define MAX_KEYFRAME_STORED 10000
+#define REVERSE_CACHE_SIZE 512  // MB
 
 struct MediaInfo {
 
@@ -161,6 +163,35 @@ public:
      * True if enabled
      * */
     bool isEnabled() const;
+    /**
+     * Suspend / Resume
+     * Release the decoding pipeline, keeping the last frame
+     * (re-creates the pipeline and seeks to the same position when resumed)
+     * */
+    void suspend(bool on);
+    /**
+     * True if suspended
+     * */
+    inline bool isSuspended() const { return suspended_; }
+    /**
+     * Set a proxy of the media (same content at lower resolution)
+     * NB: the proxy file is given by its filename and its height
+     * */
+    void setProxy(const std::string &filename, guint height);
+    /**
+     * True if a proxy was set
+     * */
+    inline bool hasProxy() const { return !proxy_uri_.empty(); }
+    /**
+     * Decode proxy / full resolution media
+     * (re-creates the pipeline and seeks to the same position)
+     * NB: width(), height() and uri() remain those of the full resolution media
+     * */
+    void useProxy(bool on);
+    /**
+     * True if decoding proxy
+     * */
+    inline bool usingProxy() const { return proxy_; }
     /**
      * True if its an image
      * */
@@ -308,6 +339,11 @@ public:
      * Must be called in OpenGL context
      * */
     guint texture() const;
+    /**
+     * Get the number of frames filled in the texture
+     * (changes when a new frame is displayed)
+     * */
+    inline guint64 textureUpdates() const { return texture_updates_; }
     /**
      * Get the name of the decoder used,
      * return 'software' if no hardware decoder is used
@@ -340,6 +376,12 @@ public:
     void setAudioEnabled(bool on);
     void setAudioVolume(gdouble v);
     gdouble audioVolume() const;
+    /**
+     * Audio of the media player is mixed in the Audio mixing bus
+     * and the peak level of its samples is measured (in [0 1])
+     * */
+    inline bool audioMixing() const { return audio_mixing_; }
+    float audioLevel() const;
 
     /**
      * Accept visitors
@@ -363,6 +405,20 @@ public:
      * */
     static MediaEvaluation UriEvaluator(const std::string &uri, std::shared_ptr<std::atomic<bool>> cancelled);
     MediaEvaluation evaluation() const;
+    /**
+     * True if backward play can use the cache of
+     * frames decoded forward from keyframes
+     * */
+    bool reverseCacheAvailable() const;
+    inline bool reverseCacheActive() const { return reverse_.active; }
+    /**
+     * Option to decode all frames of the timeline sections in memory
+     * for instant seek, step and play at any speed
+     * (admitted within the global clip cache budget)
+     * */
+    void setClipCache(bool on);
+    inline bool clipCache() const { return clip_cache_; }
+    inline bool clipCacheActive() const { return clip_.active; }
 
 
 private:
@@ -372,6 +428,7 @@ private:
     std::string filename_;
     std::string uri_;
     guint textureindex_;
+    guint64 texture_updates_;
 
     // general properties of media
     MediaInfo media_;
@@ -379,6 +436,7 @@ private:
     FadingMode fading_mode_;
     std::future<MediaInfo> discoverer_;
     bool audio_enabled_;
+    bool audio_mixing_;
 
     // async evaluation
     MediaEvaluation evaluation_;
@@ -399,6 +457,13 @@ private:
     bool pending_;
     bool seeking_;
     bool enabled_;
+    bool suspended_;
+    GstClockTime suspended_position_;
+    bool proxy_;
+    std::string proxy_uri_;
+    guint proxy_width_;
+    guint proxy_height_;
+    bool texture_resize_;
     bool force_software_decoding_;
     std::string decoder_name_;
     bool video_filter_available_;
@@ -427,32 +492,69 @@ private:
     };
     TimeCounter timecount_;
 
-    // frame stack
-    typedef enum  {
-        SAMPLE = 0,
-        PREROLL = 1,
-        EOS = 2,
-        INVALID = 3
-    } FrameStatus;
-
-    struct Frame {
-        GstBuffer *buffer;
-        FrameStatus status;
-        bool is_new;
-        GstClockTime position;
+    // frames passed from streaming thread to update
+    FrameSlots frames_;
+
+    // frames decoded in system memory, by presentation time
+    typedef std::map<GstClockTime, GstBuffer *> FrameCache;
+    GTimer *cache_timer_;
+
+    // backward play from frames decoded forward, GOP by GOP
+    struct ReverseCache {
+        std::atomic<bool> active;
+        std::atomic<bool> decoded;   // end of stream reached for interval
+        TimeInterval decoding;       // interval of frames requested
+        GstClockTime lowest;         // begin of frames decoded or requested
+        GstClockTime position;       // next frame presented is before
+        guint chunk;                 // max number of frames per interval
+        bool presented;              // a frame was presented since seek
+        bool ended;                  // end of stream was presented
+        FrameCache frames;
         std::mutex access;
 
-        Frame() {
-            buffer = NULL;
-            is_new = false;
-            status = INVALID;
+        ReverseCache() {
+            active = false;
+            decoded = true;
+            lowest = GST_CLOCK_TIME_NONE;
+            position = GST_CLOCK_TIME_NONE;
+            chunk = 2;
+            presented = false;
+            ended = false;
+        }
+    };
+    ReverseCache reverse_;
+
+    // all frames of the clip in memory
+    struct ClipFrames {
+        FrameCache frames;
+        guint64 size;
+        std::string log;
+        ClipFrames() : size(0) {}
+    };
+    struct ClipCache {
+        bool active;
+        bool refused;                // not admitted in budget
+        bool ended;                  // end of stream was presented
+        guint64 reserved;            // bytes reserved in budget
+        uint64_t revision;           // timeline revision cached
+        GstClockTime position;       // presentation time
+        GstClockTime shown;          // pts of frame presented
+        FrameCache frames;
+
+        ClipCache() {
+            active = false;
+            refused = false;
+            ended = false;
+            reserved = 0;
+            revision = 0;
             position = GST_CLOCK_TIME_NONE;
+            shown = GST_CLOCK_TIME_NONE;
         }
     };
-    Frame frame_[N_VFRAME];
-    guint write_index_;
-    guint last_index_;
-    std::mutex index_lock_;
+    bool clip_cache_;
+    ClipCache clip_;
+    std::future<ClipFrames> clip_loader_;
+    std::shared_ptr<std::atomic<bool>> clip_loader_cancel_;
 
     // for PBO
     guint pbo_[2];
@@ -466,14 +568,39 @@ private:
 
     // gst pipeline control
     void execute_open();
+    // release the pipeline and its frames, keeping speed, direction and clip cache option
+    void execute_release();
+    // re-create the pipeline and restore playback at position once prerolled
+    void execute_reopen(GstClockTime position);
     void execute_play_command(bool on);
     void execute_loop_command();
     void execute_seek_command(GstClockTime target = GST_CLOCK_TIME_NONE, bool force = false);
 
     // gst frame filling
-    void init_texture(guint index);
-    void fill_texture(guint index);
-    bool fill_frame(GstBuffer *buf, FrameStatus status);
+    void init_texture(GstBuffer *buf);
+    void fill_texture(GstBuffer *buf);
+    bool fill_frame(GstBuffer *buf, FrameSlots::Status status);
+
+    // backward play with cache
+    void reverse_seek(GstClockTime target);
+    void reverse_stop();
+    void reverse_clear();
+    void reverse_update();
+    void reverse_request();
+    bool reverse_present(guint n);
+    void reverse_fill(GstBuffer *buf);
+    void set_sink_sync(bool on);
+    GstState pipeline_state() const;
+
+    // clip cache
+    void clip_load();
+    void clip_release();
+    void clip_seek(GstClockTime target);
+    void clip_step();
+    void clip_update();
+    static ClipFrames ClipLoader(const std::string &description, TimeIntervalSet sections,
+                                 guint64 limit, std::shared_ptr<std::atomic<bool>> cancelled);
+    static void ClipRelease(std::future<ClipFrames> loader, FrameCache frames, guint64 reserved);
 
     // gst callbacks
     static void callback_end_of_stream (GstAppSink *, gpointer);
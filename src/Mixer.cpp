@@ -32,6 +32,7 @@
 #include <tinyxml2.h>
 
 #include "ImageShader.h"
+#include "Scene/Mesh.h"
 #include "View/DisplaysView.h"
 #include "defines.h"
 #include "Settings.h"
@@ -63,19 +64,35 @@
 #include "MixingGroup.h"
 #include "FrameGrabbing.h"
 #include "Visitor/BoundingBoxVisitor.h"
+#include "Profiler.h"
+#include "Journal.h"
+#include "Residency.h"
+#include "Proxies.h"
 
 #include "Mixer.h"
 
 #define THREADED_LOADING
 std::vector< std::future<std::string> > sessionSavers_;
+uint64_t sessionSaverJournal_ = 0;
 std::vector< std::future<Session *> > sessionLoaders_;
 std::vector< std::future<Session *> > sessionImporters_;
+std::vector< std::future<Session *> > sessionCuers_;
 std::vector< SessionSource * > sessionSourceToImport_;
 const std::chrono::milliseconds timeout_ = std::chrono::milliseconds(4);
+// maximum wait for sessions being cued when terminating
+const std::chrono::seconds cue_terminate_timeout_ = std::chrono::seconds(3);
+
+// delete a session cued but never used, once loaded
+static void delete_cued(std::future<Session *> cuer)
+{
+    Session *s = cuer.get();
+    if (s)
+        delete s;
+}
 
 
 Mixer::Mixer() : session_(new Session), back_session_(nullptr), sessionSwapRequested_(false),
-    current_view_(nullptr), busy_(false), dt_(16.f), dt__(16.f)
+    cue_session_(nullptr), cue_ready_(false), current_view_(nullptr), busy_(false), dt_(16.f), dt__(16.f), draw_calls_(0)
 {
     // unsused initial empty session
     current_source_ = session_->end();
@@ -129,6 +146,40 @@ void Mixer::update()
     }
 #endif
 
+    // if there is a session cue loader pending
+    if (!sessionCuers_.empty()) {
+        // check status of loader: did it finish ?
+        if (sessionCuers_.front().wait_for(timeout_) == std::future_status::ready ) {
+            Session *s = sessionCuers_.front().valid() ? sessionCuers_.front().get() : nullptr;
+            // done with this session loader
+            sessionCuers_.erase(sessionCuers_.begin());
+            // keep the session only if still expected
+            if ( s != nullptr && cue_session_ == nullptr && s->filename() == cue_filename_ ) {
+                cue_session_ = s;
+                cue_session_->setCued(true);
+                // sources will preroll in pause: remember which were playing
+                for (auto it = cue_session_->begin(); it != cue_session_->end(); ++it) {
+                    if ( (*it)->playable() && (*it)->playing() ) {
+                        cue_playing_.push_back( (*it)->id() );
+                        (*it)->play(false);
+                    }
+                }
+                // allocate frame buffer of session
+                cue_session_->setResolution( cue_session_->config(View::RENDERING)->scale_ );
+            }
+            else if ( s != nullptr )
+                garbage_.push_back(s);
+            else if ( s == nullptr && sessionCuers_.empty() && !cue_filename_.empty() ) {
+                Log::Warning("Failed to cue session '%s'.", cue_filename_.c_str());
+                cue_filename_.clear();
+            }
+        }
+    }
+
+    // initialize sources of cued session
+    if (cue_session_ != nullptr && !cue_ready_)
+        warmup();
+
     // if there is a session saving pending
     if (!sessionSavers_.empty()) {
         // check status of saver: did it finish ?
@@ -149,6 +200,7 @@ void Mixer::update()
                 // cosmetics saved ok
                 Rendering::manager().mainWindow().setTitle(SystemToolkit::filename(filename));
                 Settings::application.recentSessions.push(filename);
+                Journal::manager().rebase(filename, sessionSaverJournal_);
                 Log::Notify("Session '%s' saved.", filename.c_str());
             }
             busy_ = false;
@@ -213,19 +265,33 @@ void Mixer::update()
     dt__ = 0.05f * dt_ + 0.95f * dt__;
 
     // update session and associated sources
-    session_->update(dt_);
+    {
+        ProfileZone zone("Session update");
+        session_->update(dt_);
+    }
+
+    // keep sources of the session within memory budget
+    Residency::manager().update(session_, dt_);
+
+    // generate proxies of media in background
+    Proxies::manager().update();
 
     // update canvases
     Canvas::manager().update(dt_);
 
     // grab frames to recorders & streamers
     FrameBuffer *output = session_->frame();
+    bool output_changed = session_->changed() || !Settings::application.render.skip_unchanged;
     // tries to show canvas output if selected
     if (Settings::application.widget.preview_output > -1) {
         Settings::application.widget.preview_output = MIN( Canvas::manager().size()-1, Settings::application.widget.preview_output );
         output = Canvas::manager().at(Settings::application.widget.preview_output)->frame();
+        output_changed = true;
     } 
-    FrameGrabbing::manager().grabFrame(output, static_cast<guint64>(dt__));
+    {
+        ProfileZone zone("Frame grabbing");
+        FrameGrabbing::manager().grabFrame(output, static_cast<guint64>(dt__), output_changed);
+    }
 
     // manage sources which failed update
     if (session_->ready()) {
@@ -294,8 +360,14 @@ void Mixer::update()
 void Mixer::draw()
 {
     // draw the current view in the window
-    current_view_->draw();
+    ProfileZone zone("View draw");
 
+    // decorations of sources are drawn instanced
+    Shader::draw_calls = 0;
+    Mesh::beginInstancing();
+    current_view_->draw();
+    Mesh::endInstancing();
+    draw_calls_ = Shader::draw_calls;
 }
 
 // manangement of sources
@@ -1432,6 +1504,8 @@ void Mixer::saveas(const std::string& filename, bool with_version, bool with_thu
         std::string versionname;
         if (with_version)
             versionname = SystemToolkit::date_time_string();
+        // records of journal until now are in the saved file
+        sessionSaverJournal_ = Journal::manager().mark();
         // launch a thread to save the session
         // Will be captured in the future in update()
         sessionSavers_.emplace_back( std::async(std::launch::async, Session::save, filename, session_, versionname) );
@@ -1450,6 +1524,13 @@ void Mixer::load(const std::string& filename)
         setView((View::Mode) Settings::application.current_view);
     }
 
+    // recover session left by an interrupted execution
+    if (filename.empty() && Journal::manager().recoverable()) {
+        std::string recovered = Journal::manager().recover();
+        if (!recovered.empty())
+            sessionfile = recovered;
+    }
+
     // ignore invalid file name
     if (!SystemToolkit::file_exists(sessionfile)) {
         if (!sessionfile.empty())
@@ -1472,6 +1553,14 @@ void Mixer::load(const std::string& filename)
 
 void Mixer::open(const std::string& filename, bool smooth)
 {
+    // use the session cued if ready for this file
+    Session *cued_session = nullptr;
+    if ( cued(filename) )
+        cued_session = uncue(true);
+    // cancel a cue that is not ready or of another file
+    else if ( !cue_filename_.empty() )
+        uncue();
+
     if (smooth)
     {
         // create special SessionSource to be used for the smooth transition
@@ -1481,7 +1570,10 @@ void Mixer::open(const std::string& filename, bool smooth)
         if (!filename.empty())
         {
             Log::Info("\nStarting transition to session %s", filename.c_str());
-            ts->load(filename);
+            if (cued_session)
+                ts->load(cued_session, filename);
+            else
+                ts->load(filename);
             // propose a new name based on uri
             ts->setName(SystemToolkit::base_filename(filename));
         }
@@ -1493,10 +1585,98 @@ void Mixer::open(const std::string& filename, bool smooth)
         insertSource(ts, View::TRANSITION);
 
     }
+    else if (cued_session)
+        set(cued_session);
     else
         load(filename);
 }
 
+void Mixer::cue(const std::string& filename)
+{
+    // already cued or cueing
+    if ( filename == cue_filename_ )
+        return;
+
+    // cancel previous cue
+    if ( !cue_filename_.empty() )
+        uncue();
+
+    // ignore invalid file name
+    if (!SystemToolkit::file_exists(filename)) {
+        if (!filename.empty())
+            Log::Notify("Invalid filename '%s'", filename.c_str());
+        return;
+    }
+
+    // Start async thread for loading the session
+    // Will be obtained in the future in update()
+    cue_filename_ = filename;
+    sessionCuers_.emplace_back( std::async(std::launch::async, Session::load, filename, 0) );
+}
+
+bool Mixer::cued(const std::string& filename) const
+{
+    return cue_ready_ && cue_session_ != nullptr && filename == cue_filename_;
+}
+
+void Mixer::warmup()
+{
+    if ( cue_session_->frame() == nullptr )
+        return;
+
+    // update and render sources of the cued session
+    cue_session_->update(dt_);
+
+    // estimate the memory needed by the frame buffers of the cued session
+    uint64_t memory = (uint64_t) cue_session_->frame()->width() * cue_session_->frame()->height() * 4;
+    for (auto it = cue_session_->begin(); it != cue_session_->end(); ++it) {
+        if ( (*it)->frame() != nullptr )
+            memory += (uint64_t) (*it)->frame()->width() * (*it)->frame()->height() * 4;
+    }
+
+    // abort cue if above budget
+    if ( memory > (uint64_t) Settings::application.render.cue_memory_budget * 1048576 ) {
+        Log::Warning("Session '%s' exceeds the memory budget (%d MB) to be cued.",
+                     cue_filename_.c_str(), Settings::application.render.cue_memory_budget);
+        uncue();
+        return;
+    }
+
+    // all sources are ready: done
+    if ( cue_session_->ready() ) {
+        cue_ready_ = true;
+        Log::Info("Session '%s' cued (%d MB).", cue_filename_.c_str(), (int) (memory / 1048576));
+    }
+}
+
+Session *Mixer::uncue(bool restore)
+{
+    Session *s = cue_session_;
+
+    if ( s != nullptr ) {
+        // resume sources playing in session to use it
+        if (restore) {
+            s->setCued(false);
+            for (auto it = s->begin(); it != s->end(); ++it) {
+                if ( std::find(cue_playing_.begin(), cue_playing_.end(), (*it)->id()) != cue_playing_.end() )
+                    (*it)->play(true);
+            }
+        }
+        // or delete it
+        else {
+            garbage_.push_back(s);
+            s = nullptr;
+        }
+    }
+
+    cue_session_ = nullptr;
+    cue_filename_.clear();
+    cue_playing_.clear();
+    cue_ready_ = false;
+
+    return s;
+}
+
 void Mixer::import(const std::string& filename)
 {
 #ifdef THREADED_LOADING
@@ -1715,7 +1895,8 @@ void Mixer::swap()
         back_session_ = nullptr;
     }
 
-    // reset History manager
+    // restart journal and History manager
+    Journal::manager().start(session_->filename());
     Action::manager().init("Session start");
 
     // notification
@@ -1764,6 +1945,23 @@ void Mixer::terminate()
     // cancel transition
     transition_.detach();
 
+    // cancel cue
+    uncue();
+    auto deadline_cue = std::chrono::steady_clock::now() + cue_terminate_timeout_;
+    for (auto c = sessionCuers_.begin(); c != sessionCuers_.end(); ++c) {
+        if ( c->wait_until(deadline_cue) == std::future_status::ready ) {
+            Session *s = c->get();
+            if (s)
+                delete s;
+        }
+        else {
+            // abandon loading (never used, the session has no OpenGL resources)
+            Log::Info("Interrupted cue of session.");
+            std::thread(delete_cued, std::move(*c)).detach();
+        }
+    }
+    sessionCuers_.clear();
+
     // set for an empty session
     set(new Session);
 
@@ -1774,9 +1972,15 @@ void Mixer::terminate()
            || ++deadline < 10)
         update();
 
+    // cancel generation of proxies
+    Proxies::manager().terminate();
+
     // all finished, we can clear the back session we just added
     delete back_session_;
     back_session_ = nullptr;
+
+    // clean exit does not need the journal
+    Journal::manager().close();
 }
 
 void Mixer::set(Session *s)
@@ -46,6 +46,7 @@ public:
 
     // draw session and current view
     void draw ();
+    inline uint drawCalls () const { return draw_calls_; } // of the current view
 
     // creation of sources
     Source * createSourceFile   (const std::string &path, bool disable_hw_decoding = false);
@@ -129,6 +130,10 @@ public:
     void close  (bool smooth = false);
     void open   (const std::string& filename, bool smooth = false);
 
+    // pre-load a session in background, to be opened without delay
+    void cue    (const std::string& filename);
+    bool cued   (const std::string& filename) const;
+
     // create sources if clipboard contains well-formed xml text
     void paste  (const std::string& clipboard);
 
@@ -143,6 +148,14 @@ protected:
     bool sessionSwapRequested_;
     void swap();
 
+    // session cued: loaded, initialized and paused on first frame
+    Session *cue_session_;
+    std::string cue_filename_;
+    SourceIdList cue_playing_;
+    bool cue_ready_;
+    void warmup();
+    Session *uncue(bool restore = false);
+
     // temporary buffer of sources to be inserted at next iteration,
     // stored in pair with the source to replace, if provided
     std::list< std::pair<Source *, Source *> > candidate_sources_;
@@ -169,6 +182,7 @@ protected:
     bool busy_;
     float dt_;
     float dt__;
+    uint draw_calls_;
 };
 
 #endif // MIXER_H
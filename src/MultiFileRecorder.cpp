@@ -13,10 +13,16 @@
 
 #include "MultiFileRecorder.h"
 
+// maximum number of threads decoding images
+#define MULTIFILE_MAX_DECODERS 8
+// maximum number of decoded images waiting for encoding
+#define MULTIFILE_DECODE_AHEAD 16
+
 MultiFileRecorder::MultiFileRecorder() :
     fps_(0), width_(0), height_(0),
     pipeline_(nullptr), src_(nullptr), frame_count_(0), timestamp_(0), frame_duration_(0),
-    cancel_(false), endofstream_(false), accept_buffer_(false), progress_(0.f)
+    cancel_(false), endofstream_(false), accept_buffer_(false),
+    decode_index_(0), push_index_(0), decoded_count_(0), progress_(0.f), throughput_(0.f)
 {
     // default profile
     profile_ = VideoRecorder::H264_STANDARD;
@@ -64,11 +70,11 @@ void MultiFileRecorder::callback_enough_data (GstAppSrc *, gpointer p)
         grabber->accept_buffer_ = false;
 }
 
-bool MultiFileRecorder::add_image (const std::string &image_filename, GstCaps *caps)
+GstBuffer *MultiFileRecorder::decode_image (const std::string &image_filename, GstCaps *caps)
 {
     std::string uri = GstToolkit::filename_to_uri(image_filename);
     if (uri.empty())
-        return false;
+        return nullptr;
 
     // create playbin
     GstElement *img_pipeline = gst_element_factory_make("playbin", "imgreader");
@@ -79,7 +85,7 @@ bool MultiFileRecorder::add_image (const std::string &image_filename, GstCaps *c
     // set flag to only read VIDEO with software decoding
     g_object_set(G_OBJECT(img_pipeline), "flags", 0x00001001, NULL);
 
-    // instruct sink to use the required caps
+    // instruct sink to use the required caps (converts and resizes)
     GstElement *sink = gst_element_factory_make("appsink", "imgsink");
     gst_app_sink_set_caps(GST_APP_SINK(sink), caps);
 
@@ -93,51 +99,94 @@ bool MultiFileRecorder::add_image (const std::string &image_filename, GstCaps *c
     gst_element_get_state(img_pipeline, NULL, NULL, GST_CLOCK_TIME_NONE);
 
     /* Get the sample from appsink */
-    GstSample *sample;
+    GstSample *sample = NULL;
     g_signal_emit_by_name(sink, "pull-sample", &sample, NULL);
 
-    /* Extract the buffer */
-    GstBuffer *buffer_read = gst_sample_get_buffer(sample);
-
-    bool ret = false;
-    // map the buffer to access the data
-    GstMapInfo map_read;
-    if ( gst_buffer_map(buffer_read, &map_read, GST_MAP_READ) && map_read.size > 0 ) {
-
-        // map a new gst buffer into memory to WRITE target
-        GstMapInfo map_write;
-        GstBuffer *buffer_write = gst_buffer_new_and_alloc(map_read.size);
-        if ( gst_buffer_map(buffer_write, &map_write, GST_MAP_WRITE) ) {
+    GstBuffer *buffer_write = nullptr;
+    if (sample != NULL) {
 
-            // transfer pixels from map_read memory to map_write memory (buffer to write to)
-            memmove(map_write.data, map_read.data, map_read.size);
+        /* Extract the buffer */
+        GstBuffer *buffer_read = gst_sample_get_buffer(sample);
 
-            // un-map buffer
-            gst_buffer_unmap(buffer_write, &map_write);
+        // map the buffer to access the data
+        GstMapInfo map_read;
+        if ( buffer_read && gst_buffer_map(buffer_read, &map_read, GST_MAP_READ) ) {
 
-            //g_print("frame_added @ timestamp = %ld\n", timestamp_);
-            GST_BUFFER_DTS(buffer_write) = GST_BUFFER_PTS(buffer_write) = timestamp_;
+            if ( map_read.size > 0 ) {
+                // map a new gst buffer into memory to WRITE target
+                GstMapInfo map_write;
+                buffer_write = gst_buffer_new_and_alloc(map_read.size);
+                if ( gst_buffer_map(buffer_write, &map_write, GST_MAP_WRITE) ) {
 
-            // set frame duration
-            buffer_write->duration = frame_duration_;
+                    // transfer pixels from map_read memory to map_write memory (buffer to write to)
+                    memmove(map_write.data, map_read.data, map_read.size);
 
-            // monotonic time increment to keep fixed FPS
-            timestamp_ += frame_duration_;
+                    // un-map buffer
+                    gst_buffer_unmap(buffer_write, &map_write);
+                }
+                else {
+                    gst_buffer_unref(buffer_write);
+                    buffer_write = nullptr;
+                }
+            }
 
-            // push buffer as new frame in appsrc
-            ret = gst_app_src_push_buffer(src_, buffer_write) == GST_FLOW_OK;
+            // unmap read buffer
+            gst_buffer_unmap(buffer_read, &map_read);
         }
 
-        // unmap read buffer
-        gst_buffer_unmap(buffer_read, &map_read);
+        gst_sample_unref(sample);
     }
 
     /* Clean up */
-    gst_sample_unref(sample);
     gst_element_set_state(img_pipeline, GST_STATE_NULL);
     gst_object_unref(GST_OBJECT(img_pipeline));
 
-    return ret;
+    return buffer_write;
+}
+
+void MultiFileRecorder::decode_images (const std::vector<std::string> &files, GstCaps *caps)
+{
+    while ( !cancel_ ) {
+
+        // next image to decode
+        size_t i = decode_index_++;
+        if ( i >= files.size() )
+            break;
+
+        // do not decode too far ahead of encoding
+        {
+            std::unique_lock<std::mutex> lock(decoded_access_);
+            while ( !cancel_ && i >= push_index_ + MULTIFILE_DECODE_AHEAD )
+                decoded_taken_.wait_for(lock, std::chrono::milliseconds(100));
+        }
+        if ( cancel_ )
+            break;
+
+        // decode (nullptr if failed)
+        GstBuffer *buffer = decode_image(files[i], caps);
+
+        {
+            std::lock_guard<std::mutex> lock(decoded_access_);
+            decoded_[i] = buffer;
+            decoded_count_++;
+        }
+        decoded_ready_.notify_all();
+    }
+}
+
+bool MultiFileRecorder::push_image (GstBuffer *buffer)
+{
+    //g_print("frame_added @ timestamp = %ld\n", timestamp_);
+    GST_BUFFER_DTS(buffer) = GST_BUFFER_PTS(buffer) = timestamp_;
+
+    // set frame duration
+    buffer->duration = frame_duration_;
+
+    // monotonic time increment to keep fixed FPS
+    timestamp_ += frame_duration_;
+
+    // push buffer as new frame in appsrc
+    return gst_app_src_push_buffer(src_, buffer) == GST_FLOW_OK;
 }
 
 
@@ -337,6 +386,8 @@ std::string  MultiFileRecorder::assemble (MultiFileRecorder *rec)
 
     // reset
     rec->progress_ = 0.f;
+    rec->throughput_ = 0.f;
+    rec->decoded_count_ = 0;
     rec->width_ = 0;
     rec->height_ = 0;
     rec->cancel_ = false;
@@ -387,13 +438,35 @@ std::string  MultiFileRecorder::assemble (MultiFileRecorder *rec)
         // progressing
         rec->progress_ += inc_;
 
-        // loop over images to open
-        for (auto file = rec->files_.cbegin(); file != rec->files_.cend(); ++file) {
-
-            if ( rec->cancel_ )
-                break;
+        // decode images in parallel threads, ahead of encoding
+        std::vector<std::string> files(rec->files_.cbegin(), rec->files_.cend());
+        rec->decode_index_ = 0;
+        rec->push_index_ = 0;
+        size_t n = CLAMP( std::thread::hardware_concurrency() / 2, 1, MULTIFILE_MAX_DECODERS);
+        std::vector<std::thread> decoders;
+        for (size_t k = 0; k < n; ++k)
+            decoders.push_back( std::thread(&MultiFileRecorder::decode_images, rec, std::cref(files), tmp_caps) );
+
+        GTimer *timer = g_timer_new ();
+
+        // loop over images in order to encode
+        for (size_t i = 0; i < files.size(); ++i) {
+
+            // wait for image to be decoded
+            GstBuffer *buffer = nullptr;
+            {
+                std::unique_lock<std::mutex> lock(rec->decoded_access_);
+                while ( !rec->cancel_ && rec->decoded_.count(i) < 1 )
+                    rec->decoded_ready_.wait_for(lock, std::chrono::milliseconds(100));
+                if ( rec->cancel_ )
+                    break;
+                buffer = rec->decoded_[i];
+                rec->decoded_.erase(i);
+                rec->push_index_ = i + 1;
+            }
+            rec->decoded_taken_.notify_all();
 
-            if ( rec->add_image( *file, tmp_caps) ) {
+            if ( buffer != nullptr && rec->push_image( buffer ) ) {
                 // validate file
                 rec->frame_count_++;
 
@@ -406,16 +479,32 @@ std::string  MultiFileRecorder::assemble (MultiFileRecorder *rec)
                 }
             }
             else
-                Log::Info("MultiFileRecorder Could not add %s.", file->c_str());
+                Log::Info("MultiFileRecorder Could not add %s.", files[i].c_str());
 
             // pause in case appsrc buffer is full
             int max = 100;
             while (!rec->accept_buffer_ && --max > 0)
                 std::this_thread::sleep_for(std::chrono::milliseconds(4));
 
-            // progressing
-            rec->progress_ += inc_;
+            // progressing of both decoding and encoding
+            float done = (float) (rec->decoded_count_ + i + 1) / (2.f * (float) files.size());
+            rec->progress_ = inc_ + done * (1.f - 2.f * inc_);
+            rec->throughput_ = (float) (i + 1) / MAX( (float) g_timer_elapsed (timer, NULL), 0.001f);
+        }
+
+        // end decoding threads
+        if ( rec->cancel_ ) {
+            rec->decoded_taken_.notify_all();
+            rec->decoded_ready_.notify_all();
+        }
+        for (auto t = decoders.begin(); t != decoders.end(); ++t)
+            t->join();
+        for (auto b = rec->decoded_.begin(); b != rec->decoded_.end(); ++b) {
+            if (b->second)
+                gst_buffer_unref(b->second);
         }
+        rec->decoded_.clear();
+        g_timer_destroy (timer);
 
         // Give more explanation for possible errors
         if ( rec->frame_count_ < rec->files_.size())
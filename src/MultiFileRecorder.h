@@ -5,7 +5,9 @@
 #include <string>
 #include <atomic>
 #include <vector>
+#include <map>
 #include <future>
+#include <condition_variable>
 
 #include <gst/gst.h>
 #include <gst/app/gstappsrc.h>
@@ -39,14 +41,20 @@ public:
     inline int height () const { return height_; }
     inline float progress () const { return progress_; }
     inline guint64 numFrames () const { return frame_count_; }
+    inline guint64 numDecoded () const { return decoded_count_; }
+    inline float throughput () const { return throughput_; }
 
 protected:
     // gstreamer functions
     static std::string assemble (MultiFileRecorder *rec);
     bool start_record (const std::string &video_filename);
-    bool add_image    (const std::string &image_filename, GstCaps *caps);
+    bool push_image   (GstBuffer *buffer);
     bool end_record();
 
+    // decoding images ahead of encoding, in parallel
+    static GstBuffer *decode_image (const std::string &image_filename, GstCaps *caps);
+    void decode_images (const std::vector<std::string> &files, GstCaps *caps);
+
     // gstreamer callbacks
     static void callback_need_data (GstAppSrc *, guint, gpointer user_data);
     static void callback_enough_data (GstAppSrc *, gpointer user_data);
@@ -71,8 +79,18 @@ private:
     std::atomic<bool> endofstream_;
     std::atomic<bool> accept_buffer_;
 
+    // decoded images waiting to be encoded, by index in files
+    std::map<size_t, GstBuffer *> decoded_;
+    std::mutex decoded_access_;
+    std::condition_variable decoded_ready_;
+    std::condition_variable decoded_taken_;
+    std::atomic<size_t> decode_index_;
+    size_t push_index_;
+    std::atomic<guint64> decoded_count_;
+
     // progress and result
     float progress_;
+    float throughput_;
     std::vector< std::future<std::string> >promises_;
 };
 
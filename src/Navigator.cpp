@@ -53,6 +53,9 @@
 #include "Resource.h"
 #include "ActionManager.h"
 #include "Mixer.h"
+#include "Residency.h"
+#include "CacheBudget.h"
+#include "Proxies.h"
 #include "MediaPlayer.h"
 #include "Source/MediaSource.h"
 #include "Source/PatternSource.h"
@@ -1379,9 +1382,14 @@ void Navigator::RenderNewPannel(const ImVec2 &iconsize)
                     ImGui::Text("%d fps", _video_recorder.framerate() );
                     ImGui::Text("Codec :");ImGui::SameLine(150);
                     ImGui::Text("%s", VideoRecorder::profile_name[ _video_recorder.profile() ] );
+                    ImGui::Text("Decoded :");ImGui::SameLine(150);
+                    ImGui::Text("%lu / %lu", (unsigned long)_video_recorder.numDecoded(),
+                                (unsigned long)_video_recorder.files().size() );
                     ImGui::Text("Frames :");ImGui::SameLine(150);
                     ImGui::Text("%lu / %lu", (unsigned long)_video_recorder.numFrames(),
                                 (unsigned long)_video_recorder.files().size() );
+                    ImGui::Text("Speed :");ImGui::SameLine(150);
+                    ImGui::Text("%.1f fps", _video_recorder.throughput() );
 
                     ImGui::Spacing();
                     ImGui::ProgressBar(_video_recorder.progress());
@@ -2779,6 +2787,7 @@ void Navigator::RenderMainPannelPlaylist()
 
     std::string session_hovered_ = "";
     std::string session_triggered_ = "";
+    std::string session_next_ = "";
     static uint session_tooltip_ = 0;
     ++session_tooltip_;
 
@@ -2817,6 +2826,8 @@ void Navigator::RenderMainPannelPlaylist()
                     // trigger on double clic
                     if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
                         session_triggered_ = session_file;
+                        if (index + 1 < index_max)
+                            session_next_ = UserInterface::manager().favorites.at(index + 1);
                     }
                     // show tooltips on single clic
                     else
@@ -2895,6 +2906,8 @@ void Navigator::RenderMainPannelPlaylist()
                     // trigger on double clic
                     if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
                         session_triggered_ = session_file;
+                        if (index + 1 < index_max)
+                            session_next_ = active_playlist.at(index + 1);
                     }
                     // show tooltips on single clic
                     else
@@ -2990,6 +3003,8 @@ void Navigator::RenderMainPannelPlaylist()
                     // trigger on double clic
                     if (ImGui::IsMouseDoubleClicked(ImGuiMouseButton_Left)) {
                         session_triggered_ = *it;
+                        if (std::next(it) != folder_session_files.end())
+                            session_next_ = *std::next(it);
                     }
                     // show tooltips on clic
                     else
@@ -3185,13 +3200,23 @@ void Navigator::RenderMainPannelPlaylist()
         Mixer::manager().open( session_triggered_, Settings::application.smooth_transition );
         if (Settings::application.smooth_transition)
             WorkspaceWindow::clearWorkspace();
+        // pre-load the next session in the list
+        if (Settings::application.cue_next_session && !session_next_.empty())
+            Mixer::manager().cue( session_next_ );
     }
     // help indicator
     pos_top.y += list_size.y;
     ImGui::SetCursorPos( ImVec2( pannel_width_ IMGUI_RIGHT_ALIGN, pos_top.y - 2.f * ImGui::GetFrameHeightWithSpacing()));
     ImGuiToolkit::HelpToolTip("Double-clic on a filename to open the session.\n\n"
                               ICON_FA_ARROW_CIRCLE_RIGHT "  enable Smooth transition "
-                                                         "to perform a cross fading with the current session.");
+                                                         "to perform a cross fading with the current session.\n\n"
+                              ICON_FA_STEP_FORWARD "  enable Cue next session "
+                                                   "to pre-load the session following in the list, "
+                                                   "and open it without delay.");
+
+    // toggle button for cue of next session
+    ImGui::SetCursorPos( ImVec2( pannel_width_ IMGUI_RIGHT_ALIGN, pos_top.y - 3.f * ImGui::GetFrameHeightWithSpacing()) );
+    ImGuiToolkit::ButtonToggle(ICON_FA_STEP_FORWARD, &Settings::application.cue_next_session, "Cue next session");
 
     // toggle button for smooth transition
     ImGui::SetCursorPos( ImVec2( pannel_width_ IMGUI_RIGHT_ALIGN, pos_top.y - ImGui::GetFrameHeightWithSpacing()) );
@@ -3434,7 +3459,9 @@ void Navigator::RenderMainPannelSettings()
             // Displayed name of current audio device
             std::string current_audio = "None";
             if (!Settings::application.record.audio_device.empty()) {
-                if (Audio::manager().exists(Settings::application.record.audio_device))
+                if (Audio::manager().exists(Settings::application.record.audio_device)
+                    || (Settings::application.audio_mixing
+                        && Settings::application.record.audio_device.compare(AUDIO_MIXING_NAME) == 0))
                     current_audio = Settings::application.record.audio_device;
                 else
                     Settings::application.record.audio_device = "";
@@ -3444,7 +3471,8 @@ void Navigator::RenderMainPannelSettings()
             ImGuiToolkit::Indication("Select the audio to merge into the recording;\n"
                                      ICON_FA_MICROPHONE_ALT_SLASH " no audio\n "
                                      ICON_FA_MICROPHONE_ALT "  a microphone input\n "
-                                     ICON_FA_VOLUME_DOWN "  an audio output",
+                                     ICON_FA_VOLUME_DOWN "  an audio output\n "
+                                     ICON_FA_SLIDERS_H "  the audio mixing bus",
                                      ICON_FA_MUSIC);
             ImGui::SameLine(0);
 
@@ -3455,6 +3483,16 @@ void Navigator::RenderMainPannelSettings()
                 // No audio selection
                 if (ImGui::Selectable(ICON_FA_MICROPHONE_ALT_SLASH " None"))
                     Settings::application.record.audio_device = "";
+                // audio of sources in the mixing bus
+                if (Settings::application.audio_mixing) {
+                    if (ImGui::Selectable(ICON_FA_SLIDERS_H "  " AUDIO_MIXING_NAME)) {
+                        Settings::application.record.audio_device = AUDIO_MIXING_NAME;
+                        if (Settings::application.record.priority_mode > 0) {
+                            Log::Notify( "When recording with audio, Priority mode must be set to 'Duration'.");
+                            Settings::application.record.priority_mode=0;
+                        }
+                    }
+                }
                 // list of devices from Audio manager
                 for (int d = 0; d < Audio::manager().numDevices(); ++d) {
                     std::string namedev = Audio::manager().name(d);
@@ -3773,6 +3811,99 @@ void Navigator::RenderMainPannelSettings()
                                  "and allows recording audio.", audio ? ICON_FA_VOLUME_UP : ICON_FA_VOLUME_MUTE);
         ImGui::SameLine(0);
         change |= ImGuiToolkit::ButtonSwitch( "Audio (experimental)", &audio);
+        if (Settings::application.accept_audio) {
+            // audio mixing deserves more explanation
+            ImGuiToolkit::Indication("If enabled, audio of videos is mixed in a single stream "
+                                     "to the audio output, with one clock and smooth volume "
+                                     "changes. Applies to videos (re)loaded after change.", ICON_FA_SLIDERS_H);
+            ImGui::SameLine(0);
+            ImGuiToolkit::ButtonSwitch( "Audio mixing bus", &Settings::application.audio_mixing);
+        }
+
+        // backward play deserves more explanation
+        ImGuiToolkit::Indication("If enabled, videos play backward from frames decoded "
+                                 "forward in memory, from one keyframe to the next.", ICON_FA_BACKWARD);
+        ImGui::SameLine(0);
+        ImGuiToolkit::ButtonSwitch( "Backward play cache", &Settings::application.render.reverse_cache);
+
+        // level of detail deserves more explanation
+        ImGuiToolkit::Indication("If enabled, sources displayed much smaller than their "
+                                 "resolution in the output are rendered and filtered "
+                                 "at a lower resolution.", ICON_FA_COMPRESS_ARROWS_ALT);
+        ImGui::SameLine(0);
+        ImGuiToolkit::ButtonSwitch( "Adaptive resolution", &Settings::application.render.level_of_detail);
+
+        // batch compositing deserves more explanation
+        ImGuiToolkit::Indication("If enabled, consecutive sources in normal blending are "
+                                 "composited together in the output frame, in fewer passes "
+                                 "(edges are not multisampled).", ICON_FA_LAYER_GROUP);
+        ImGui::SameLine(0);
+        ImGuiToolkit::ButtonSwitch( "Batch compositing", &Settings::application.render.batch_compositing);
+        if (Settings::application.render.batch_compositing)
+            ImGui::TextDisabled("   %d blending passes saved", Mixer::manager().session()->passesSaved());
+
+        // skip unchanged deserves more explanation
+        ImGuiToolkit::Indication("If enabled, sources and output are rendered only when "
+                                 "their frame changes (e.g. new video frame, change of "
+                                 "geometry or color). Static sessions use very little "
+                                 "resources.", ICON_FA_PAUSE_CIRCLE);
+        ImGui::SameLine(0);
+        ImGuiToolkit::ButtonSwitch( "Skip unchanged frames", &Settings::application.render.skip_unchanged);
+
+        // render on demand deserves more explanation
+        ImGuiToolkit::Indication("If enabled, sources are rendered only if they are visible "
+                                 "in the output, or used by a visible source (e.g. origin of "
+                                 "a clone, mask). Previews of hidden sources are not updated.", ICON_FA_EYE_SLASH);
+        ImGui::SameLine(0);
+        ImGuiToolkit::ButtonSwitch( "Render on demand", &Settings::application.render.render_on_demand);
+
+        // residency deserves more explanation
+        ImGuiToolkit::Indication("If enabled, when sources use more memory than the budget, "
+                                 "those inactive for the longest time release their decoder "
+                                 "and keep a low resolution preview. They are restored when "
+                                 "approaching activation.", ICON_FA_MEMORY);
+        ImGui::SameLine(0);
+        ImGuiToolkit::ButtonSwitch( "Memory budget", &Settings::application.render.residency);
+        if (Settings::application.render.residency) {
+            ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+            ImGui::SliderInt("##ResidencyBudget", &Settings::application.render.residency_budget, 256, 16384, "%d MB");
+            ImGui::TextDisabled("   %d MB used, %d sources evicted", (int) (Residency::manager().usage() / 1048576),
+                                (int) Residency::manager().numEvicted());
+        }
+
+        // clip cache deserves more explanation
+        ImGuiToolkit::Indication("Memory shared by the videos caching all frames of their "
+                                 "timeline and by the images sequences kept in memory. "
+                                 "Caches beyond the budget are refused.", ICON_FA_FILM);
+        ImGui::SameLine(0);
+        ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+        ImGui::SliderInt("Clip cache", &Settings::application.render.clip_cache_budget, 256, 16384, "%d MB");
+        ImGui::TextDisabled("   %d MB used", (int) (CacheBudget::manager().usage() / 1048576));
+
+        // proxy media deserves more explanation
+        ImGuiToolkit::Indication("If enabled, lower resolution copies of videos are generated "
+                                 "in background. Sources play the proxy unless the output is "
+                                 "live (output window, recording or streaming) and the source "
+                                 "is displayed larger than the proxy.", ICON_FA_COMPRESS);
+        ImGui::SameLine(0);
+        ImGuiToolkit::ButtonSwitch( "Proxy media", &Settings::application.render.proxy);
+        if (Settings::application.render.proxy) {
+            static const char* proxy_heights[] = { "360", "540", "720" };
+            static const int proxy_height_values[] = { 360, 540, 720 };
+            int h = 0;
+            while (h < 2 && proxy_height_values[h] < Settings::application.render.proxy_height)
+                ++h;
+            ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+            if (ImGui::Combo("Height##Proxy", &h, proxy_heights, IM_ARRAYSIZE(proxy_heights)))
+                Settings::application.render.proxy_height = proxy_height_values[h];
+            static const char* proxy_locations[] = { "Cache folder", "Next to media" };
+            ImGui::SetNextItemWidth(IMGUI_RIGHT_ALIGN);
+            ImGui::Combo("Location##Proxy", &Settings::application.render.proxy_location,
+                         proxy_locations, IM_ARRAYSIZE(proxy_locations));
+            if (Proxies::manager().pending() > 0)
+                ImGui::TextDisabled("   Generating %d proxies (%d %%)", (int) Proxies::manager().pending(),
+                                    (int) (100.0 * Proxies::manager().progress()));
+        }
 
 #ifndef NDEBUG
 
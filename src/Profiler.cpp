@@ -0,0 +1,351 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include <chrono>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+#include <glad/glad.h>
+
+#include "Settings.h"
+#include "Log.h"
+#include "Toolkit/SystemToolkit.h"
+
+#include "Profiler.h"
+
+// weight of the new value in running averages
+#define PROFILER_AVERAGE 0.1
+// zones not measured since this number of frames are ignored
+#define PROFILER_STALE_FRAMES 60
+
+Profiler::Profiler() : enabled_(false), active_(false), frame_(0), gpu_offset_(0),
+    events_head_(0), events_count_(0), pool_(nullptr), export_requested_(false)
+{
+    for (size_t i = 0; i < PROFILER_QUERY_FRAMES; ++i) {
+        pools_[i].used = 0;
+        pools_[i].frame = 0;
+    }
+}
+
+uint64_t Profiler::now() const
+{
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return (uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Profiler::setEnabled(bool on)
+{
+    if (on != enabled_)
+        Log::Info("Profiler %s.", on ? "enabled" : "disabled");
+    enabled_ = on;
+}
+
+void Profiler::beginFrame()
+{
+    stack_.clear();
+    active_ = enabled_;
+    if (!active_)
+        return;
+
+    // allocate ring buffer on first use
+    if (events_.empty())
+        events_.resize(PROFILER_MAX_EVENTS);
+
+    ++frame_;
+
+    // use the pool of queries of this frame (collected two frames ago)
+    pool_ = &pools_[frame_ % PROFILER_QUERY_FRAMES];
+    if (pool_->queries.empty())
+        pool_ = nullptr;
+    else {
+        pool_->used = 0;
+        pool_->events.clear();
+        pool_->frame = frame_;
+    }
+
+    // the frame includes output windows drawn in other OpenGL contexts
+    begin("Frame", 0, nullptr, false);
+}
+
+bool Profiler::begin(const char *name, uint64_t id, const char *label, bool gpu)
+{
+    if (!active_)
+        return false;
+
+    size_t index = events_head_;
+    events_head_ = (events_head_ + 1) % PROFILER_MAX_EVENTS;
+    events_count_ = std::min(events_count_ + 1, (size_t) PROFILER_MAX_EVENTS);
+
+    Event &e = events_[index];
+    e.name = name;
+    e.id = id;
+    e.depth = (int) stack_.size();
+    e.frame = frame_;
+    e.cpu_begin = now();
+    e.cpu_end = 0;
+    e.gpu_begin = 0;
+    e.gpu_end = 0;
+    e.query = -1;
+
+    if (id > 0 && label != nullptr) {
+        std::lock_guard<std::mutex> lock(access_);
+        labels_[id] = label;
+    }
+
+    // timestamp query in the command stream of the main OpenGL context
+    if (gpu && pool_ != nullptr && pool_->used + 2 <= pool_->queries.size()) {
+        e.query = (int) pool_->used;
+        glQueryCounter(pool_->queries[pool_->used], GL_TIMESTAMP);
+        pool_->events.push_back(index);
+        pool_->used += 2;
+    }
+
+    stack_.push_back(index);
+    return true;
+}
+
+void Profiler::end()
+{
+    if (stack_.empty())
+        return;
+
+    Event &e = events_[stack_.back()];
+    stack_.pop_back();
+    e.cpu_end = now();
+
+    if (e.query > -1 && pool_ != nullptr)
+        glQueryCounter(pool_->queries[e.query + 1], GL_TIMESTAMP);
+
+    accumulate(e, false);
+}
+
+void Profiler::endFrame()
+{
+    // export requested (even if profiler is now disabled)
+    if (export_requested_) {
+        std::string filename;
+        {
+            std::lock_guard<std::mutex> lock(access_);
+            filename = export_filename_;
+        }
+        if (filename.empty())
+            filename = SystemToolkit::filename_dateprefix(Settings::application.record.path, "vimix_trace", "json");
+        exportTrace(filename);
+        export_requested_ = false;
+    }
+
+    if (!active_)
+        return;
+
+    // close zones left open
+    while (!stack_.empty())
+        end();
+
+    // read results of the queries issued two frames ago
+    collectQueries( pools_[(frame_ + 1) % PROFILER_QUERY_FRAMES] );
+
+    // create queries for the next frames
+    QueryPool &next = pools_[(frame_ + 1) % PROFILER_QUERY_FRAMES];
+    if (next.queries.empty()) {
+        next.queries.resize(PROFILER_MAX_ZONES * 2);
+        glGenQueries((GLsizei) next.queries.size(), next.queries.data());
+        next.used = 0;
+    }
+
+    // offset between the GPU clock and the CPU clock
+    GLint64 timestamp = 0;
+    glGetInteger64v(GL_TIMESTAMP, &timestamp);
+    if (timestamp > 0)
+        gpu_offset_ = (int64_t) now() * 1000 - (int64_t) timestamp;
+
+    active_ = false;
+    pool_ = nullptr;
+}
+
+void Profiler::collectQueries(QueryPool &pool)
+{
+    // nothing to read, or queries left from before profiling was paused
+    if (pool.used < 2 || pool.frame + PROFILER_QUERY_FRAMES - 1 != frame_) {
+        pool.used = 0;
+        pool.events.clear();
+        return;
+    }
+
+    // queries complete in order: never wait if the last one is not ready
+    GLuint available = 0;
+    glGetQueryObjectuiv(pool.queries[pool.used - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+        for (size_t i = 0; i < pool.events.size(); ++i) {
+            Event &e = events_[pool.events[i]];
+            // ignore event overwritten in ring buffer or not closed
+            if (e.frame != pool.frame || e.cpu_end == 0)
+                continue;
+            GLuint64 t0 = 0, t1 = 0;
+            glGetQueryObjectui64v(pool.queries[e.query], GL_QUERY_RESULT, &t0);
+            glGetQueryObjectui64v(pool.queries[e.query + 1], GL_QUERY_RESULT, &t1);
+            e.gpu_begin = (uint64_t) std::max( (int64_t) t0 + gpu_offset_, (int64_t) 0) / 1000;
+            e.gpu_end   = (uint64_t) std::max( (int64_t) t1 + gpu_offset_, (int64_t) 0) / 1000;
+            accumulate(e, true);
+        }
+    }
+
+    pool.used = 0;
+    pool.events.clear();
+}
+
+void Profiler::accumulate(const Event &e, bool gpu)
+{
+    std::lock_guard<std::mutex> lock(access_);
+
+    auto z = std::find_if(zones_.begin(), zones_.end(), [&e](const Zone &zone) {
+        return zone.id == e.id && zone.depth == e.depth && strcmp(zone.name, e.name) == 0;
+    });
+
+    if (z == zones_.end()) {
+        Zone zone = { e.name, e.id, e.depth, -1.0, -1.0, e.frame, e.cpu_begin };
+        zones_.push_back(zone);
+        z = zones_.end() - 1;
+    }
+
+    if (gpu) {
+        double d = (double) (e.gpu_end - std::min(e.gpu_begin, e.gpu_end)) / 1000.0;
+        z->gpu = z->gpu < 0.0 ? d : (1.0 - PROFILER_AVERAGE) * z->gpu + PROFILER_AVERAGE * d;
+    }
+    else {
+        double d = (double) (e.cpu_end - e.cpu_begin) / 1000.0;
+        z->cpu = z->cpu < 0.0 ? d : (1.0 - PROFILER_AVERAGE) * z->cpu + PROFILER_AVERAGE * d;
+        z->frame = e.frame;
+        z->begin = e.cpu_begin;
+    }
+}
+
+std::vector<Profiler::Statistics> Profiler::statistics() const
+{
+    std::vector<Statistics> stats;
+    std::lock_guard<std::mutex> lock(access_);
+
+    // recent zones, in order of execution in last frame
+    std::vector<Zone> zones;
+    for (auto z = zones_.begin(); z != zones_.end(); ++z) {
+        if (z->frame + PROFILER_STALE_FRAMES > frame_)
+            zones.push_back(*z);
+    }
+    std::sort(zones.begin(), zones.end(), [](const Zone &a, const Zone &b) {
+        return a.begin < b.begin || (a.begin == b.begin && a.depth < b.depth);
+    });
+
+    for (auto z = zones.begin(); z != zones.end(); ++z) {
+        Statistics s;
+        s.name = z->name;
+        auto l = labels_.find(z->id);
+        if (l != labels_.end())
+            s.label = l->second;
+        s.id = z->id;
+        s.depth = z->depth;
+        s.cpu = z->cpu;
+        s.gpu = z->gpu;
+        stats.push_back(s);
+    }
+
+    return stats;
+}
+
+void Profiler::reset()
+{
+    std::lock_guard<std::mutex> lock(access_);
+    zones_.clear();
+    labels_.clear();
+}
+
+void Profiler::requestExport(const std::string &filename)
+{
+    {
+        std::lock_guard<std::mutex> lock(access_);
+        export_filename_ = filename;
+    }
+    export_requested_ = true;
+}
+
+static std::string json_escape(const std::string &str)
+{
+    std::string out;
+    for (char c : str) {
+        if (c == '"' || c == '\\')
+            out += std::string("\\") + c;
+        else if ((unsigned char) c < 0x20)
+            out += ' ';
+        else
+            out += c;
+    }
+    return out;
+}
+
+bool Profiler::exportTrace(const std::string &filename)
+{
+    if (events_count_ < 1) {
+        Log::Warning("Profiler has no event to export; enable profiling first.");
+        return false;
+    }
+
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        Log::Warning("Cannot write profiler trace '%s'.", filename.c_str());
+        return false;
+    }
+
+    std::map<uint64_t, std::string> labels;
+    {
+        std::lock_guard<std::mutex> lock(access_);
+        labels = labels_;
+    }
+
+    // Chrome trace format; timestamps and durations in microseconds
+    file << "{\"traceEvents\":[\n";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"vimix\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    size_t start = (events_head_ + PROFILER_MAX_EVENTS - events_count_) % PROFILER_MAX_EVENTS;
+    for (size_t i = 0; i < events_count_; ++i) {
+        const Event &e = events_[(start + i) % PROFILER_MAX_EVENTS];
+        if (e.cpu_end == 0)
+            continue;
+
+        std::string name = e.name;
+        auto l = labels.find(e.id);
+        if (l != labels.end())
+            name += " " + l->second;
+        name = json_escape(name);
+
+        file << ",\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+             << ",\"ts\":" << e.cpu_begin << ",\"dur\":" << e.cpu_end - e.cpu_begin
+             << ",\"args\":{\"frame\":" << e.frame << ",\"id\":" << e.id << "}}";
+
+        if (e.gpu_end > e.gpu_begin && e.gpu_begin > 0)
+            file << ",\n{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":2"
+                 << ",\"ts\":" << e.gpu_begin << ",\"dur\":" << e.gpu_end - e.gpu_begin
+                 << ",\"args\":{\"frame\":" << e.frame << ",\"id\":" << e.id << "}}";
+    }
+    file << "\n]}\n";
+    file.close();
+
+    Log::Notify("Profiler trace saved in %s", filename.c_str());
+    return true;
+}
@@ -0,0 +1,156 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+#define PROFILER_MAX_EVENTS 65536
+#define PROFILER_MAX_ZONES 256
+#define PROFILER_QUERY_FRAMES 3
+
+/**
+ * @brief The Profiler measures the CPU and GPU duration of scoped zones
+ * of the rendering loop (e.g. session update, render of each source, GUI).
+ *
+ * Zones are nested and must be opened and closed in the main rendering thread.
+ * GPU durations are measured with OpenGL timestamp queries, read two frames later
+ * to never stall the pipeline. GPU timing is only available
+ * in the main OpenGL context.
+ *
+ * Events are kept in a ring buffer which can be exported in
+ * Chrome trace JSON format (chrome://tracing or https://ui.perfetto.dev)
+ */
+class Profiler
+{
+    // Private Constructor
+    Profiler();
+    Profiler(Profiler const& copy) = delete;
+    Profiler& operator=(Profiler const& copy) = delete;
+
+public:
+
+    static Profiler& manager ()
+    {
+        // The only instance
+        static Profiler _instance;
+        return _instance;
+    }
+
+    // start or stop profiling (thread safe)
+    void setEnabled (bool on);
+    inline bool enabled () const { return enabled_; }
+
+    // mark the frame boundaries in the rendering loop
+    void beginFrame ();
+    void endFrame ();
+
+    // open and close a zone; id is optional (e.g. source id)
+    // label is used to identify the id (e.g. source name)
+    // begin returns false if the profiler is not active in this frame
+    bool begin (const char *name, uint64_t id = 0, const char *label = nullptr, bool gpu = true);
+    void end ();
+
+    // statistics per zone, averaged over recent frames
+    struct Statistics {
+        std::string name;
+        std::string label;
+        uint64_t id;
+        int depth;
+        double cpu;  // milisecond
+        double gpu;  // milisecond, negative if not measured
+    };
+    std::vector<Statistics> statistics () const;
+    void reset ();
+
+    // export ring buffer of events in Chrome trace format
+    // (thread safe: performed in rendering thread at end of frame)
+    // default filename is dated in the recording folder
+    void requestExport (const std::string &filename = "");
+    bool exportTrace (const std::string &filename);
+
+private:
+
+    struct Event {
+        const char *name;
+        uint64_t id;
+        int depth;
+        uint64_t frame;
+        uint64_t cpu_begin;  // microseconds since start
+        uint64_t cpu_end;
+        uint64_t gpu_begin;  // microseconds since start, 0 if not measured
+        uint64_t gpu_end;
+        int query;           // index of query pair, -1 if none
+    };
+
+    std::atomic<bool> enabled_;
+    bool active_;
+    uint64_t frame_;
+    int64_t gpu_offset_;     // gpu clock to cpu clock, in nanoseconds
+
+    // ring buffer of events
+    std::vector<Event> events_;
+    size_t events_head_;
+    size_t events_count_;
+    std::vector<size_t> stack_;
+    std::map<uint64_t, std::string> labels_;
+
+    // GPU queries of the last frames
+    struct QueryPool {
+        std::vector<unsigned int> queries;
+        std::vector<size_t> events;  // index of event for each query pair
+        size_t used;
+        uint64_t frame;
+    };
+    QueryPool pools_[PROFILER_QUERY_FRAMES];
+    QueryPool *pool_;
+    void collectQueries (QueryPool &pool);
+
+    // running averages per zone
+    struct Zone {
+        const char *name;
+        uint64_t id;
+        int depth;
+        double cpu;
+        double gpu;
+        uint64_t frame;  // last frame measured
+        uint64_t begin;  // last begin time, to sort zones
+    };
+    std::vector<Zone> zones_;
+    void accumulate (const Event &e, bool gpu);
+    mutable std::mutex access_;
+
+    // export request (from another thread)
+    std::string export_filename_;
+    std::atomic<bool> export_requested_;
+
+    uint64_t now () const;
+};
+
+/**
+ * @brief ProfileZone opens a zone of the profiler for the current scope
+ *
+ *   {
+ *       ProfileZone zone("Session update");
+ *       ...
+ *   }
+ */
+class ProfileZone
+{
+    bool open_;
+public:
+    ProfileZone(const char *name, uint64_t id = 0, const char *label = nullptr, bool gpu = true)
+        : open_(false) {
+        if (Profiler::manager().enabled())
+            open_ = Profiler::manager().begin(name, id, label, gpu);
+    }
+    ~ProfileZone() {
+        if (open_)
+            Profiler::manager().end();
+    }
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,162 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include <cstdio>
+#include <cstdint>
+
+#include "Settings.h"
+#include "Log.h"
+#include "Transcoder.h"
+#include "FrameGrabbing.h"
+#include "OutputWindow.h"
+#include "Toolkit/BaseToolkit.h"
+#include "Toolkit/SystemToolkit.h"
+
+#include "Proxies.h"
+
+Proxies::Proxies() : transcoder_(nullptr),
+    height_(Settings::application.render.proxy_height),
+    location_(Settings::application.render.proxy_location)
+{
+}
+
+std::string Proxies::filename (const std::string &path) const
+{
+    std::string name = SystemToolkit::base_filename(path) + "_proxy" + std::to_string(height_) + ".mp4";
+
+    // next to the media
+    if (location_ > 0)
+        return SystemToolkit::path_filename(path) + name;
+
+    // in cache directory, with a hash of the full path to distinguish media with the same name
+    std::string dir = SystemToolkit::full_filename(SystemToolkit::settings_path(), "proxies");
+    if ( !SystemToolkit::file_exists(dir) )
+        SystemToolkit::create_directory(dir);
+    uint64_t h = 0;
+    for (auto c = path.begin(); c != path.end(); ++c)
+        BaseToolkit::hash(h, *c);
+    return SystemToolkit::full_filename(dir, std::to_string(h % 100000000) + "_" + name);
+}
+
+std::string Proxies::get (const std::string &path)
+{
+    // known media (NB: empty if pending or failed)
+    auto p = proxies_.find(path);
+    if ( p != proxies_.end() )
+        return p->second;
+
+    // proxy exists and is not older than the media
+    std::string f = filename(path);
+    if ( SystemToolkit::file_exists(f) &&
+         SystemToolkit::file_modification_time(f) >= SystemToolkit::file_modification_time(path) ) {
+        proxies_[path] = f;
+        return f;
+    }
+
+    // request generation
+    proxies_[path] = "";
+    queue_.push_back(path);
+    return "";
+}
+
+void Proxies::update ()
+{
+    // change of settings: forget all proxies
+    if ( !Settings::application.render.proxy ||
+         height_ != Settings::application.render.proxy_height ||
+         location_ != Settings::application.render.proxy_location ) {
+        terminate();
+        proxies_.clear();
+        height_ = Settings::application.render.proxy_height;
+        location_ = Settings::application.render.proxy_location;
+        return;
+    }
+
+    if ( transcoder_ != nullptr ) {
+        if ( !transcoder_->finished() )
+            return;
+
+        // generated in a temporary file to never use an incomplete proxy
+        std::string f = filename(transcoder_->inputFilename());
+        if ( transcoder_->success() && std::rename(transcoder_->outputFilename().c_str(), f.c_str()) == 0 ) {
+            proxies_[transcoder_->inputFilename()] = f;
+            Log::Info("Proxy of '%s' created.", SystemToolkit::filename(transcoder_->inputFilename()).c_str());
+        }
+        else {
+            SystemToolkit::remove_file(transcoder_->outputFilename());
+            Log::Warning("Could not create proxy of '%s' %s", SystemToolkit::filename(transcoder_->inputFilename()).c_str(),
+                         transcoder_->error().c_str());
+        }
+        delete transcoder_;
+        transcoder_ = nullptr;
+    }
+
+    // start generation of next proxy
+    if ( !queue_.empty() ) {
+        std::string path = queue_.front();
+        queue_.pop_front();
+
+        // frequent keyframes for seeking, audio kept, video scaled to proxy height
+        transcoder_ = new Transcoder(path, filename(path) + ".part");
+        if ( !transcoder_->start( TranscoderOptions(true, PsyTuning::NONE, -1, false, height_) ) ) {
+            Log::Warning("Could not create proxy of '%s' %s", SystemToolkit::filename(path).c_str(),
+                         transcoder_->error().c_str());
+            delete transcoder_;
+            transcoder_ = nullptr;
+        }
+    }
+}
+
+void Proxies::terminate ()
+{
+    // forget pending proxies to allow requesting them again
+    for (auto it = queue_.begin(); it != queue_.end(); ++it)
+        proxies_.erase(*it);
+    queue_.clear();
+
+    if ( transcoder_ != nullptr ) {
+        transcoder_->stop();
+        SystemToolkit::remove_file(transcoder_->outputFilename());
+        proxies_.erase(transcoder_->inputFilename());
+        delete transcoder_;
+        transcoder_ = nullptr;
+    }
+}
+
+size_t Proxies::pending () const
+{
+    return queue_.size() + (transcoder_ != nullptr ? 1 : 0);
+}
+
+double Proxies::progress () const
+{
+    return transcoder_ != nullptr ? transcoder_->progress() : 0.0;
+}
+
+bool Proxies::live ()
+{
+    // output window displayed
+    if ( OutputWindow::num_active_outputs > 0 && !Settings::application.render.disabled )
+        return true;
+
+    // output frame recorded, streamed or shared
+    return Outputs::manager().enabled( FrameGrabber::GRABBER_VIDEO, FrameGrabber::GRABBER_GPU,
+                                       FrameGrabber::GRABBER_P2P, FrameGrabber::GRABBER_BROADCAST,
+                                       FrameGrabber::GRABBER_SHM, FrameGrabber::GRABBER_LOOPBACK );
+}
@@ -0,0 +1,68 @@
+#ifndef PROXIES_H
+#define PROXIES_H
+
+#include <map>
+#include <list>
+#include <string>
+
+// margin to avoid switching back and forth between proxy and full resolution
+#define PROXY_HYSTERESIS 0.7f
+
+class Transcoder;
+
+///
+/// \brief The Proxies manager generates and keeps track of lightweight
+/// proxies of video files (same content, lower resolution, light decoding).
+///
+/// Proxies are generated in background by a Transcoder, one at a time,
+/// in the cache directory or next to the media (Settings render.proxy_location).
+/// A proxy older than its media is considered obsolete and re-generated.
+///
+/// Media sources play the proxy when the output is not live (no output window,
+/// no recording or streaming), or when their display is smaller than the proxy.
+///
+class Proxies
+{
+    // Private Constructor
+    Proxies();
+    Proxies(Proxies const& copy) = delete;
+    Proxies& operator=(Proxies const& copy) = delete;
+
+public:
+
+    static Proxies& manager ()
+    {
+        // The only instance
+        static Proxies _instance;
+        return _instance;
+    }
+
+    // filename of the proxy of the media at path, empty if not available yet
+    // (generation of the proxy is requested if needed)
+    std::string get (const std::string &path);
+
+    // progress of proxy generation (called once per frame)
+    void update ();
+    // stop proxy generation
+    void terminate ();
+
+    // number of proxies waiting for generation (incl. current)
+    size_t pending () const;
+    // progress of current generation (0.0 to 1.0)
+    double progress () const;
+
+    // the output frame is displayed, recorded or streamed
+    static bool live ();
+
+private:
+
+    std::string filename (const std::string &path) const;
+
+    std::map<std::string, std::string> proxies_;
+    std::list<std::string> queue_;
+    Transcoder *transcoder_;
+    int height_;
+    int location_;
+};
+
+#endif // PROXIES_H
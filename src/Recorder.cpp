@@ -439,9 +439,13 @@ std::string VideoRecorder::init(GstCaps *read_caps, GstCaps *write_caps)
             !Settings::application.record.audio_device.empty()) {
             // ensure the Audio manager has the device specified in settings
             int current_audio = Audio::manager().index(Settings::application.record.audio_device);
-            if (current_audio > -1) {
+            // or tap the output of the audio mixing bus
+            bool mixing = Settings::application.audio_mixing &&
+                    Settings::application.record.audio_device.compare(AUDIO_MIXING_NAME) == 0;
+            if (current_audio > -1 || mixing) {
+                std::string audio = mixing ? Audio::manager().mixingPipeline() : Audio::manager().pipeline(current_audio);
                 description += "mux. ";
-                description += Audio::manager().pipeline(current_audio);
+                description += audio;
                 description += " ! audio/x-raw ! audioconvert ! audioresample ! ";
                 description += "identity name=audiosync ! ";
                 // select encoder depending on codec
@@ -450,7 +454,7 @@ std::string VideoRecorder::init(GstCaps *read_caps, GstCaps *write_caps)
                 else
                     description += "avenc_aac ! aacparse ! queue ! ";
 
-                Log::Info("Video Recording : audio (%s)", Audio::manager().pipeline(current_audio).c_str());
+                Log::Info("Video Recording : audio (%s)", audio.c_str());
             }
         }
 
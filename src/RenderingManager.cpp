@@ -65,6 +65,7 @@
 #include "UserInterfaceManager.h"
 #include "Scene/Primitives.h"
 #include "TabletInput.h"
+#include "Profiler.h"
 
 #include "RenderingManager.h"
 
@@ -346,6 +347,8 @@ void Rendering::pushBackDrawCallback(RenderingCallback function)
 
 void Rendering::draw()
 {
+    Profiler::manager().beginFrame();
+
     // Poll and handle events (inputs, window resize, etc.)
     // You can read the io.WantCaptureMouse, io.WantCaptureKeyboard flags to tell if dear imgui wants to use your inputs.
     // - When io.WantCaptureMouse is true, do not dispatch mouse input data to your main application.
@@ -369,19 +372,28 @@ void Rendering::draw()
     main_.makeCurrent();
 
     // draw scene and GUI in main window
-    std::list<Rendering::RenderingCallback>::iterator iter;
-    for (iter=draw_callbacks_.begin(); iter != draw_callbacks_.end(); ++iter)
     {
-        (*iter)();
+        ProfileZone zone("Main window");
+        std::list<Rendering::RenderingCallback>::iterator iter;
+        for (iter=draw_callbacks_.begin(); iter != draw_callbacks_.end(); ++iter)
+        {
+            (*iter)();
+        }
+
+        // perform screenshot if requested
+        if (request_screenshot_) {
+            screenshot_.captureGL(main_.width(), main_.height());
+            request_screenshot_ = false;
+        }
     }
 
-    // perform screenshot if requested
-    if (request_screenshot_) {
-        screenshot_.captureGL(main_.width(), main_.height());
-        request_screenshot_ = false;
+    {
+        ProfileZone zone("Swap buffers", 0, nullptr, false);
+        glfwSwapBuffers(main_.window());
     }
 
-    glfwSwapBuffers(main_.window());
+    // end of frame in main window context
+    Profiler::manager().endFrame();
 
     // software framerate limiter < 60 FPS
     {
@@ -657,6 +669,8 @@ void Rendering::drawOutputWindows()
     for (auto it = monitors_.begin(); it != monitors_.end(); ++it) {
         // if output is active and initialized, draw it
         if (it->output.isActive() && it->output.isInitialized()) {
+            // no GPU timing in the OpenGL context of output windows
+            ProfileZone zone("Output window", 0, nullptr, false);
             it->output.draw(Canvas::manager().session()->frame());
             busy = true;
         }
@@ -0,0 +1,127 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include <set>
+#include <vector>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "Settings.h"
+#include "Log.h"
+#include "Session.h"
+#include "MediaPlayer.h"
+#include "Source/Source.h"
+#include "Source/MediaSource.h"
+
+#include "Residency.h"
+
+Residency::Residency() : usage_(0), evicted_(0)
+{
+}
+
+uint64_t Residency::memory (Source *s)
+{
+    uint64_t m = 0;
+
+    // render buffer and mask buffer (half resolution)
+    FrameBuffer *f = s->frame();
+    if (f) {
+        m = (uint64_t) f->width() * f->height() * 4;
+        m += m / 4;
+    }
+
+    // frames of the decoder, unless suspended
+    MediaSource *ms = dynamic_cast<MediaSource *>(s);
+    if (ms && ms->mediaplayer() && !ms->mediaplayer()->isSuspended() && !ms->mediaplayer()->isImage())
+        m += (uint64_t) ms->mediaplayer()->width() * ms->mediaplayer()->height() * 4 * RESIDENCY_DECODER_FRAMES;
+
+    return m;
+}
+
+void Residency::update (Session *session, float dt)
+{
+    if (session == nullptr)
+        return;
+
+    const uint64_t budget = (uint64_t) Settings::application.render.residency_budget * 1048576;
+    const bool enabled = Settings::application.render.residency;
+    const float threshold = session->activationThreshold() * RESIDENCY_MARGIN;
+
+    // sources used by other sources (e.g. origin of a clone, mask) must remain resident
+    std::set<uint64_t> needed;
+    for (auto it = session->begin(); it != session->end(); ++it) {
+        SourceIdList d = (*it)->dependencies();
+        needed.insert(d.begin(), d.end());
+        if ( !(*it)->clones().empty() )
+            needed.insert( (*it)->id() );
+    }
+
+    // least recently used sources that could be evicted
+    std::vector< std::pair<float, Source *> > candidates;
+    std::map<uint64_t, float> inactive;
+    usage_ = 0;
+    evicted_ = 0;
+
+    for (auto it = session->begin(); it != session->end(); ++it) {
+        Source *s = *it;
+
+        // source is active or about to be activated
+        bool near = s->active() || needed.count(s->id()) > 0 ||
+                glm::length( glm::vec2(s->group(View::MIXING)->translation_) ) < threshold;
+
+        if ( near || !enabled ) {
+            inactive[s->id()] = 0.f;
+            // restore source
+            if ( !s->resident() )
+                s->setResident(true);
+        }
+        else {
+            // time since deactivation
+            auto i = inactive_.find(s->id());
+            float t = ( i != inactive_.end() ? i->second : 0.f ) + dt * 0.001f;
+            inactive[s->id()] = t;
+            if ( s->resident() && t > RESIDENCY_DELAY )
+                candidates.push_back( {t, s} );
+        }
+
+        if ( s->resident() )
+            usage_ += memory(s);
+        else
+            ++evicted_;
+    }
+
+    // forget sources no longer in the session
+    inactive_.swap(inactive);
+
+    if ( !enabled || usage_ <= budget || candidates.empty() )
+        return;
+
+    // evict least recently used sources until the budget is respected
+    std::sort(candidates.begin(), candidates.end(),
+              [](const std::pair<float, Source *> &a, const std::pair<float, Source *> &b) {
+                  return a.first > b.first; });
+    for (auto c = candidates.begin(); c != candidates.end() && usage_ > budget; ++c) {
+        uint64_t m = memory(c->second);
+        c->second->setResident(false);
+        usage_ -= std::min(m, usage_);
+        ++evicted_;
+        Log::Info("Source '%s' evicted from memory (%d MB).", c->second->name().c_str(), (int) (m / 1048576));
+    }
+}
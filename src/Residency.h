@@ -0,0 +1,62 @@
+#ifndef RESIDENCY_H
+#define RESIDENCY_H
+
+#include <map>
+#include <cstdint>
+
+// seconds a source must be inactive before it can be evicted
+#define RESIDENCY_DELAY 5.f
+// sources closer than this factor of the activation threshold are restored
+#define RESIDENCY_MARGIN 1.3f
+// frames of a video decoder in memory (texture, pixel buffers and pipeline)
+#define RESIDENCY_DECODER_FRAMES 6
+
+class Session;
+class Source;
+
+///
+/// \brief The Residency manager keeps the memory used by the sources
+/// of the session within a budget (Settings render.residency_budget).
+///
+/// When above budget, the sources inactive for the longest time
+/// (least recently used) are evicted: they release their decoder
+/// and keep a low resolution proxy of their frame for the views.
+/// Sources are restored (decoder re-created and prerolled in background)
+/// as soon as they approach the activation threshold of the session.
+///
+class Residency
+{
+    // Private Constructor
+    Residency();
+    Residency(Residency const& copy) = delete;
+    Residency& operator=(Residency const& copy) = delete;
+
+public:
+
+    static Residency& manager ()
+    {
+        // The only instance
+        static Residency _instance;
+        return _instance;
+    }
+
+    // evict or restore sources of the session (called once per frame)
+    void update (Session *session, float dt);
+
+    // estimated memory used by resident sources, in bytes
+    inline uint64_t usage () const { return usage_; }
+    // number of sources evicted
+    inline size_t numEvicted () const { return evicted_; }
+
+    // estimated memory used by a source (frame buffers and decoder), in bytes
+    static uint64_t memory (Source *s);
+
+private:
+
+    // time since deactivation of each source
+    std::map<uint64_t, float> inactive_;
+    uint64_t usage_;
+    size_t evicted_;
+};
+
+#endif // RESIDENCY_H
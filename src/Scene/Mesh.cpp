@@ -22,7 +22,9 @@
 #include <istream>
 #include <vector>
 #include <map>
+#include <mutex>
 #include <utility>
+#include <typeinfo>
 
 #include <glad/glad.h>
 
@@ -340,21 +342,249 @@ bool parsePLY(string ascii,
 
 
 
-Mesh::Mesh(const std::string& ply_path, const std::string& tex_path) : Primitive(), mesh_resource_(ply_path), texture_resource_(tex_path), textureindex_(0)
+/**
+ * @brief The MeshGeometry is the content of a PLY file,
+ * shared by all meshes created from this file.
+ *
+ * The vertex array is created on first init of a mesh,
+ * and deleted when the last mesh using it is deleted.
+ */
+struct MeshGeometry {
+    vector<vec3> points;
+    vector<vec4> colors;
+    vector<vec2> texCoords;
+    vector<uint> indices;
+    uint primitive = 0;
+    bool valid = false;
+    GlmToolkit::AxisAlignedBoundingBox bbox;
+    uint vao = 0;
+    uint instances = 0;
+    uint refcount = 0;
+};
+
+// per instance attributes, in the instances buffer of a geometry
+struct MeshInstance {
+    glm::mat4 modelview;
+    glm::vec4 color;
+};
+
+// geometries by resource path (meshes can be created in loading threads)
+static std::map<std::string, MeshGeometry> mesh_geometries_;
+static std::mutex mesh_geometries_access_;
+
+static MeshGeometry *get_geometry(const std::string& ply_path)
 {
-    if ( !parsePLY( Resource::getText(mesh_resource_), points_, colors_, texCoords_, indices_, drawMode_) )
-    {
-        points_.clear();
-        colors_.clear();
-        texCoords_.clear();
-        indices_.clear();
+    std::lock_guard<std::mutex> lock(mesh_geometries_access_);
+
+    auto it = mesh_geometries_.find(ply_path);
+    if ( it != mesh_geometries_.end() )
+        return &(it->second);
+
+    // first use of this file: parse
+    MeshGeometry &g = mesh_geometries_[ply_path];
+    g.valid = parsePLY( Resource::getText(ply_path), g.points, g.colors, g.texCoords, g.indices, g.primitive);
+    if ( g.valid )
+        g.bbox.extend(g.points);
+    else
         Log::Warning("Mesh could not be created from %s", ply_path.c_str());
+
+    return &g;
+}
+
+static void create_vertex_array(MeshGeometry *g)
+{
+    glGenVertexArrays( 1, &g->vao );
+    uint arrayBuffer_;
+    uint elementBuffer_;
+    glGenBuffers( 1, &arrayBuffer_ );
+    glGenBuffers( 1, &elementBuffer_);
+    glBindVertexArray( g->vao );
+
+    std::size_t sizeofPoints = sizeof(glm::fvec3) * g->points.size();
+    std::size_t sizeofColors = sizeof(glm::fvec4) * g->colors.size();
+    std::size_t sizeofTexCoords = sizeof(glm::fvec2) * g->texCoords.size();
+
+    glBindBuffer( GL_ARRAY_BUFFER, arrayBuffer_ );
+    glBufferData( GL_ARRAY_BUFFER, sizeofPoints + sizeofColors + sizeofTexCoords, NULL, GL_STATIC_DRAW);
+    glBufferSubData( GL_ARRAY_BUFFER, 0, sizeofPoints, &g->points[0] );
+    glBufferSubData( GL_ARRAY_BUFFER, sizeofPoints, sizeofColors, &g->colors[0] );
+    if ( sizeofTexCoords )
+        glBufferSubData( GL_ARRAY_BUFFER, sizeofPoints + sizeofColors, sizeofTexCoords, &g->texCoords[0] );
+
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBuffer_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, g->indices.size() * sizeof(GLuint), &(g->indices[0]), GL_STATIC_DRAW);
+
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::fvec3), (void *)0 );
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(glm::fvec4), (void *)(sizeofPoints) );
+    glEnableVertexAttribArray(1);
+    if ( sizeofTexCoords ) {
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::fvec2), (void *)(sizeofPoints + sizeofColors) );
+        glEnableVertexAttribArray(2);
+    }
+
+    // per instance attributes 3 to 6 (modelview matrix) and 7 (color), for instanced drawing
+    MeshInstance identity = { glm::identity<glm::mat4>(), glm::vec4(1.f) };
+    glGenBuffers( 1, &g->instances );
+    glBindBuffer( GL_ARRAY_BUFFER, g->instances );
+    glBufferData( GL_ARRAY_BUFFER, sizeof(MeshInstance), &identity, GL_STREAM_DRAW);
+    for (uint c = 0; c < 4; ++c) {
+        glVertexAttribPointer(3 + c, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), (void *)(c * sizeof(glm::vec4)) );
+        glEnableVertexAttribArray(3 + c);
+        glVertexAttribDivisor(3 + c, 1);
+    }
+    glVertexAttribPointer(7, 4, GL_FLOAT, GL_FALSE, sizeof(MeshInstance), (void *)(sizeof(glm::mat4)) );
+    glEnableVertexAttribArray(7);
+    glVertexAttribDivisor(7, 1);
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    // buffers are kept alive by the vertex array
+    glDeleteBuffers ( 1, &arrayBuffer_);
+    glDeleteBuffers ( 1, &elementBuffer_);
+}
+
+//
+// Instanced drawing of meshes
+//
+ShadingProgram instancedShadingProgram("shaders/instanced.vs", "shaders/instanced.fs");
+
+class InstancedShader : public Shader
+{
+public:
+    InstancedShader() : Shader(), textured(false) {
+        program_ = &instancedShadingProgram;
+        Shader::reset();
+    }
+
+    void use() override {
+        Shader::use();
+        program_->setUniform("iTextured", textured);
+    }
+
+    bool textured;
+};
+
+// meshes of the same geometry, texture and blending
+struct MeshBatch {
+    MeshGeometry *geometry;
+    uint texture;
+    Shader::BlendMode blending;
+    bool force_blending_opacity;
+    glm::mat4 projection;
+    std::vector<MeshInstance> instances;
+};
+
+static bool instancing_ = false;
+static bool flushing_ = false;
+static std::vector<MeshBatch> batches_;
+
+void Mesh::beginInstancing()
+{
+    flushInstances();
+    instancing_ = true;
+    // draw pending instances before anything else uses a shader
+    Shader::before_use = Mesh::flushInstances;
+}
+
+void Mesh::endInstancing()
+{
+    flushInstances();
+    instancing_ = false;
+    Shader::before_use = nullptr;
+}
+
+void Mesh::flushInstances()
+{
+    if ( flushing_ || batches_.empty() )
+        return;
+
+    // shader use would flush again
+    flushing_ = true;
+
+    // created in OpenGL context
+    static InstancedShader *shader = new InstancedShader;
+
+    // draw batches in order
+    const bool force = Shader::force_blending_opacity;
+    for (auto b = batches_.begin(); b != batches_.end(); ++b) {
+
+        glBindBuffer( GL_ARRAY_BUFFER, b->geometry->instances );
+        glBufferData( GL_ARRAY_BUFFER, b->instances.size() * sizeof(MeshInstance), b->instances.data(), GL_STREAM_DRAW);
+        glBindBuffer( GL_ARRAY_BUFFER, 0 );
+
+        shader->projection = b->projection;
+        shader->blending = b->blending;
+        shader->textured = b->texture > 0;
+        Shader::force_blending_opacity = b->force_blending_opacity;
+        shader->use();
+
+        if (b->texture)
+            glBindTexture(GL_TEXTURE_2D, b->texture);
+
+        glBindVertexArray( b->geometry->vao );
+        glDrawElementsInstanced( b->geometry->primitive, b->geometry->indices.size(), GL_UNSIGNED_INT, 0, b->instances.size() );
+        glBindVertexArray(0);
+
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    Shader::force_blending_opacity = force;
+
+    batches_.clear();
+    flushing_ = false;
+}
+
+bool Mesh::batch(glm::mat4 modelview, glm::mat4 projection)
+{
+    // only meshes with default shaders and texture coordinates
+    if ( !instancing_ || !vao_ || shader_ == nullptr || shader_->iTransform != glm::identity<glm::mat4>() )
+        return false;
+    if ( typeid(*shader_) != typeid(Shader) && typeid(*shader_) != typeid(TextureShader) )
+        return false;
+
+    // add the instance to the last batch if of same geometry, texture and blending
+    // (a mesh is never moved before a different one drawn earlier, to keep painter's order)
+    MeshInstance instance = { modelview * transform_, shader_->color };
+    if ( !batches_.empty() ) {
+        MeshBatch &b = batches_.back();
+        if ( b.geometry == geometry_ && b.texture == textureindex_ && b.blending == shader_->blending
+             && b.force_blending_opacity == Shader::force_blending_opacity && b.projection == projection ) {
+            b.instances.push_back(instance);
+            return true;
+        }
     }
+    batches_.push_back( { geometry_, textureindex_, shader_->blending, Shader::force_blending_opacity, projection, { instance } } );
+
+    return true;
+}
+
+Mesh::Mesh(const std::string& ply_path, const std::string& tex_path) : Primitive(), mesh_resource_(ply_path), texture_resource_(tex_path), textureindex_(0)
+{
+    geometry_ = get_geometry(mesh_resource_);
+    drawMode_ = geometry_->primitive;
 
     // default non texture shader (deleted in Primitive)
     shader_ = new Shader;
 }
 
+Mesh::~Mesh()
+{
+    // release the shared vertex array (not deleted by Primitive)
+    if ( vao_ ) {
+        std::lock_guard<std::mutex> lock(mesh_geometries_access_);
+        if ( --geometry_->refcount < 1 ) {
+            // draw pending instances before deleting
+            flushInstances();
+            glDeleteVertexArrays ( 1, &geometry_->vao);
+            glDeleteBuffers ( 1, &geometry_->instances);
+            geometry_->vao = 0;
+            geometry_->instances = 0;
+        }
+        vao_ = 0;
+    }
+}
+
 
 void Mesh::setTexture(uint textureindex)
 {
@@ -368,7 +598,18 @@ void Mesh::setTexture(uint textureindex)
 
 void Mesh::init()
 {
-    Primitive::init();
+    // use the vertex array of the geometry, created on first use
+    if ( geometry_->valid && !vao_ ) {
+        std::lock_guard<std::mutex> lock(mesh_geometries_access_);
+        if ( geometry_->vao == 0 )
+            create_vertex_array(geometry_);
+        geometry_->refcount++;
+        vao_ = geometry_->vao;
+        drawCount_ = geometry_->indices.size();
+        bbox_ = geometry_->bbox;
+    }
+
+    Node::init();
 
     if (!texture_resource_.empty())
         setTexture(Resource::getTextureImage(texture_resource_));
@@ -381,6 +622,10 @@ void Mesh::draw(glm::mat4 modelview, glm::mat4 projection)
         init();
 
     if ( visible_ ) {
+        // drawn later with other instances
+        if ( batch(modelview, projection) )
+            return;
+
         if (textureindex_)
             glBindTexture(GL_TEXTURE_2D, textureindex_);
 
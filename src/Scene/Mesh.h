@@ -5,17 +5,27 @@
 
 #include "Scene.h"
 
+struct MeshGeometry;
+
 /**
  * @brief The Mesh class creates a Primitive node from a PLY File
  *
  *  PLY - Polygon File Format
  *  Also known as the Stanford Triangle Format
  *  http://paulbourke.net/dataformats/ply/
+ *
+ *  Each PLY file is parsed only once, and the vertex array
+ *  is shared by all the meshes created from the same file.
+ *
+ *  During instancing, meshes with default shaders are not drawn
+ *  immediately but collected in batches, drawn when anything else
+ *  uses a shader (to keep the drawing order) or at the end.
  */
 class Mesh : public Primitive {
 
 public:
     Mesh(const std::string& ply_path, const std::string& tex_path = "");
+    ~Mesh();
 
     void setTexture(uint textureindex);
     inline uint texture() const { return textureindex_; }
@@ -27,10 +37,19 @@ public:
     inline std::string meshPath() const { return mesh_resource_; }
     inline std::string texturePath() const { return texture_resource_; }
 
+    // meshes drawn between begin and end of instancing are collected
+    // and drawn with one instanced draw call per geometry and texture
+    static void beginInstancing ();
+    static void endInstancing ();
+    // draw the meshes collected, before anything else is drawn
+    static void flushInstances ();
+
 protected:
     std::string mesh_resource_;
     std::string texture_resource_;
     uint textureindex_;
+    MeshGeometry *geometry_;
+    bool batch (glm::mat4 modelview, glm::mat4 projection);
 
 };
 
@@ -51,6 +51,11 @@ Node::Node() : initialized_(false), visible_(true), refcount_(0)
     translation_ = glm::vec3(0.f);
     crop_ = glm::vec4(-1.f, 1.f, 1.f, -1.f);
     data_ = glm::zero<glm::mat4>();
+
+    update_transform_ = transform_;
+    update_scale_ = scale_;
+    update_rotation_ = rotation_;
+    update_translation_ = translation_;
 #if DEBUG_SCENE
     num_nodes_++;
 #endif
@@ -103,8 +108,15 @@ void Node::update( float dt)
             ++iter;
     }
 
-    // update transform matrix from attributes
-    transform_ = GlmToolkit::transform(translation_, rotation_, scale_);
+    // update transform matrix from attributes, only if modified
+    if ( translation_ != update_translation_ || rotation_ != update_rotation_ ||
+         scale_ != update_scale_ || transform_ != update_transform_ ) {
+        transform_ = GlmToolkit::transform(translation_, rotation_, scale_);
+        update_transform_ = transform_;
+        update_scale_ = scale_;
+        update_rotation_ = rotation_;
+        update_translation_ = translation_;
+    }
 }
 
 void Node::accept(Visitor& v)
@@ -270,6 +282,7 @@ void Group::clear()
         // erase this iterator from the list
         it = children_.erase(it);
     }
+    ordered_children_.clear();
 }
 
 void Group::attach(Node *child)
@@ -277,6 +290,16 @@ void Group::attach(Node *child)
     if (child != nullptr) {
         children_.insert(child);
         child->refcount_++;
+        // children are being traversed: insert in vector after traversal
+        if (traversal_ > 0)
+            reorder_pending_ = true;
+        else if (reorder_pending_)
+            reorder();
+        // insert in vector at the same position as in the multiset (after equal depths)
+        else
+            ordered_children_.insert( std::upper_bound(ordered_children_.begin(),
+                                                       ordered_children_.end(),
+                                                       child, z_comparator()), child);
     }
 }
 
@@ -287,6 +310,29 @@ void Group::sort()
     for(auto it = children_.begin(); it != children_.end(); it++)
         ordered_children.insert(*it);
     children_.swap(ordered_children);
+    if (traversal_ > 0)
+        reorder_pending_ = true;
+    else
+        reorder();
+}
+
+void Group::reorder()
+{
+    // copy the depth-sorted set in the vector of children
+    ordered_children_.assign(children_.begin(), children_.end());
+    reorder_pending_ = false;
+}
+
+std::vector<Node *>::iterator Group::ordered(Node *child)
+{
+    // search among children of same depth first
+    auto range = std::equal_range(ordered_children_.begin(), ordered_children_.end(),
+                                  child, z_comparator());
+    auto it = std::find(range.first, range.second, child);
+    // depth of child changed since attached
+    if (it == range.second)
+        it = std::find(ordered_children_.begin(), ordered_children_.end(), child);
+    return it;
 }
 
 void Group::detach(Node *child)
@@ -299,6 +345,17 @@ void Group::detach(Node *child)
             // detatch child from group parent
             children_.erase(it);
             child->refcount_--;
+            // erase the node from vector of children
+            auto o = ordered(child);
+            if (o != ordered_children_.end()) {
+                // children are being traversed: only skip node until traversal ends
+                if (traversal_ > 0) {
+                    *o = nullptr;
+                    reorder_pending_ = true;
+                }
+                else
+                    ordered_children_.erase(o);
+            }
         }
     }
 }
@@ -308,10 +365,17 @@ void Group::update( float dt )
     Node::update(dt);
 
     // update every child node
-    for (NodeSet::iterator node = children_.begin();
-         node != children_.end(); ++node) {
-        (*node)->update ( dt );
+    // (callbacks of children might attach or detach nodes: these
+    // are applied to the vector of children after the traversal)
+    ++traversal_;
+    for (size_t i = 0; i < ordered_children_.size(); ++i) {
+        if (ordered_children_[i] != nullptr)
+            ordered_children_[i]->update ( dt );
     }
+    --traversal_;
+
+    if (traversal_ < 1 && reorder_pending_)
+        reorder();
 }
 
 void Group::draw(glm::mat4 modelview, glm::mat4 projection)
@@ -325,10 +389,15 @@ void Group::draw(glm::mat4 modelview, glm::mat4 projection)
         glm::mat4 ctm = modelview * transform_;
 
         // draw every child node
-        for (NodeSet::iterator node = children_.begin();
-             node != children_.end(); ++node) {
-            (*node)->draw ( ctm, projection );
+        ++traversal_;
+        for (size_t i = 0; i < ordered_children_.size(); ++i) {
+            if (ordered_children_[i] != nullptr)
+                ordered_children_[i]->draw ( ctm, projection );
         }
+        --traversal_;
+
+        if (traversal_ < 1 && reorder_pending_)
+            reorder();
     }
 }
 
@@ -24,7 +24,9 @@ class Group;
  *
  * Every Node has geometric operations for translation,
  * scale and rotation. The update() function computes the
- * transform_ matrix from these components.
+ * transform_ matrix from these components, only if they
+ * changed since the previous update (or if transform_ was
+ * modified directly).
  *
  * draw() shall be defined by the subclass.
  * The visible flag can be used to show/hide a Node.
@@ -42,6 +44,10 @@ class Node {
     uint64_t  id_;
     bool      initialized_;
 
+    // components of the last computed transform_
+    glm::vec3 update_scale_, update_rotation_, update_translation_;
+    glm::mat4 update_transform_;
+
 public:
     Node ();
     virtual ~Node ();
@@ -159,6 +165,10 @@ private:
  * update() will update all children
  * draw() will draw all children
  *
+ * The children are also kept in the same order in a contiguous
+ * vector for the traversal in update() and draw(). Nodes attached
+ * or detached during a traversal are applied to the vector after it.
+ *
  * When a group is deleted, the children are NOT deleted.
  */
 class Group : public Node {
@@ -187,7 +197,11 @@ public:
 
 protected:
     NodeSet children_;
-
+    std::vector<Node *> ordered_children_;
+    std::vector<Node *>::iterator ordered(Node *child);
+    void reorder();
+    int  traversal_ = 0;
+    bool reorder_pending_ = false;
 };
 
 /**
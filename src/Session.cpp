@@ -20,6 +20,7 @@
 #include <algorithm>
 #include <glib.h>
 #include <limits>
+#include <functional>
 
 #include <tinyxml2.h>
 
@@ -30,6 +31,7 @@
 #include "Source/Source.h"
 #include "Settings.h"
 #include "FrameBuffer.h"
+#include "Shader.h"
 #include "SessionCreator.h"
 #include "Visitor/SessionVisitor.h"
 #include "ActionManager.h"
@@ -39,6 +41,7 @@
 #include "Source/SourceCallback.h"
 #include "Visitor/CountVisitor.h"
 #include "Log.h"
+#include "Profiler.h"
 
 #include "Session.h"
 
@@ -48,7 +51,7 @@ SessionNote::SessionNote(const std::string &t, bool l, int s): label(std::to_str
 }
 
 Session::Session(uint64_t id) : id_(id), active_(true), activation_threshold_(MIXING_MIN_THRESHOLD),
-    filename_(""), thumbnail_(nullptr), ready_(false)
+    filename_(""), scheduled_(false), schedule_state_(0), resolved_(false), thumbnail_(nullptr), ready_(false), cued_(false), changed_(true), changes_(0), state_(0)
 {
     // create unique id
     if (id_ == 0)
@@ -189,8 +192,8 @@ void Session::update(float dt)
     if ( render_.frame() == nullptr )
         return;
 
-    // listen to inputs
-    for (auto k = input_callbacks_.begin(); k != input_callbacks_.end(); ++k)
+    // listen to inputs (unless cued)
+    for (auto k = input_callbacks_.begin(); k != input_callbacks_.end() && !cued_; ++k)
     {
         // get if the input is activated (e.g. key pressed)
         bool input_active = Control::manager().inputActive(k->first);
@@ -205,85 +208,67 @@ void Session::update(float dt)
                 // ON PRESS
                 if (input_active) {
 
-                    // Add callback to the target(s)
+                    // get the list of sources target (batches are resolved once)
+                    SourceList single;
+                    const SourceList *targets = &single;
 
                     // 3. Case of variant as Current source
                     if (std::holds_alternative<Current>(k->second.target_)) {
                         Source *s = Mixer::manager().currentSource();
-                        if ( s != nullptr ) {
-                            // generate a new callback from the model
-                            SourceCallback *forward = k->second.model_->clone();
-                            // apply value multiplyer from input
-                            forward->multiply( Control::manager().inputValue(k->first) );
-                            // add delay
-                            forward->delay( Metronome::manager().timeToSync( (Metronome::Synchronicity) input_sync_[k->first] ) );
-                            // add callback to source
-                            s->call( forward );
-                            // get the reverse of the callback (can be null)
-                            SourceCallback *backward = forward->reverse(s);
-                            // remember instances
-                            k->second.instances_[s->id()] = {forward, backward};
-                        }
+                        if ( s != nullptr )
+                            single.push_back(s);
                     }
                     // 1. Case of variant as Source pointer
                     else if (Source * const* v = std::get_if<Source *>(&k->second.target_)) {
                         // verify variant value
-                        if ( *v != nullptr ) {
-                            // generate a new callback from the model
-                            SourceCallback *forward = k->second.model_->clone();
-                            // apply value multiplyer from input
-                            forward->multiply( Control::manager().inputValue(k->first) );
-                            // add delay
-                            forward->delay( Metronome::manager().timeToSync( (Metronome::Synchronicity) input_sync_[k->first] ) );
-                            // add callback to source
-                            (*v)->call( forward );
-                            // get the reverse of the callback (can be null)
-                            SourceCallback *backward = forward->reverse(*v);;
-                            // remember instances
-                            k->second.instances_[(*v)->id()] = {forward, backward};
-
-                        }
+                        if ( *v != nullptr )
+                            single.push_back(*v);
                     }
                     // 2. Case of variant as index of batch
                     else if ( const size_t* v = std::get_if<size_t>(&k->second.target_)) {
-                        // verify variant value
-                        if ( *v < batch_.size() )
-                        {
-                            // loop over all sources in Batch
-                            for (auto sid = batch_[*v].begin(); sid != batch_[*v].end(); ++sid){
-                                SourceList::const_iterator sit = std::find_if(sources_.begin(), sources_.end(), Source::hasId(*sid));;
-                                if ( sit != sources_.end()) {
-                                    // generate a new callback from the model
-                                    SourceCallback *forward = k->second.model_->clone();
-                                    // apply value multiplyer from input
-                                    forward->multiply( Control::manager().inputValue(k->first) );
-                                    // add delay
-                                    forward->delay( Metronome::manager().timeToSync( (Metronome::Synchronicity) input_sync_[k->first] ) );
-                                    // add callback to source
-                                    (*sit)->call( forward );
-                                    // get the reverse of the callback (can be null)
-                                    SourceCallback *backward = forward->reverse(*sit);;
-                                    // remember instances
-                                    k->second.instances_[*sid] = {forward, backward};
-                                }
-                            }
+                        // verify variant value and get sources of batch
+                        if ( *v < batch_.size() ) {
+                            resolve();
+                            targets = &resolved_batch_[*v];
                         }
                     }
+
+                    // value multiplyer from input and delay are the same for all targets
+                    const float value = Control::manager().inputValue(k->first);
+                    const float delay = Metronome::manager().timeToSync( (Metronome::Synchronicity) input_sync_[k->first] );
+
+                    // Add callback to the target(s)
+                    for (auto sit = targets->begin(); sit != targets->end(); ++sit) {
+                        // generate a new callback from the model
+                        SourceCallback *forward = k->second.model_->clone();
+                        // apply value multiplyer from input
+                        forward->multiply( value );
+                        // add delay
+                        forward->delay( delay );
+                        // add callback to source, replacing the pending ones of same type
+                        // so that repeated triggers in a frame run only the last one
+                        (*sit)->call( forward, true );
+                        // get the reverse of the callback (can be null)
+                        SourceCallback *backward = forward->reverse(*sit);
+                        // remember instances
+                        k->second.instances_[(*sit)->id()] = {forward, backward};
+                    }
                 }
                 // ON RELEASE
                 else {
+                    resolve();
                     // go through all instances stored for that action
                     for (auto clb = k->second.instances_.begin(); clb != k->second.instances_.end(); ++clb) {
                         // find the source referenced by each instance
-                        SourceList::const_iterator sit = std::find_if(sources_.begin(), sources_.end(), Source::hasId(clb->first));;
+                        auto sit = resolved_sources_.find(clb->first);
                         // if the source is valid
-                        if ( sit != sources_.end()) {
+                        if ( sit != resolved_sources_.end()) {
                             // either call the reverse if exists (stored as second element in pair)
                             if (clb->second.second != nullptr)
-                                (*sit)->call( clb->second.second, true );
+                                sit->second->call( clb->second.second, true );
                             // or finish the called
                             else
-                                (*sit)->finish( clb->second.first );
+                                sit->second->finish( clb->second.first );
                         }
                     }
                     // do not keep reference to instances: will be deleted when finished
@@ -296,9 +281,18 @@ void Session::update(float dt)
         }
     }
 
+    // skip rendering of unchanged frames if enabled
+    const bool skip = Settings::application.render.skip_unchanged;
+    bool changed = !ready_ || fading_.active;
+
+    // order sources after the sources they depend on, and get those needed in output
+    SourceListUnique needed;
+    const SourceList &order = schedule(needed);
+    const bool cull = Settings::application.render.render_on_demand;
+
     // pre-render all sources
     bool test_ready = true;
-    for( SourceList::iterator it = sources_.begin(); it != sources_.end(); ++it){
+    for( SourceList::const_iterator it = order.begin(); it != order.end(); ++it){
 
         // ensure the RenderSource is rendering *this* session
         RenderSource *rs = dynamic_cast<RenderSource *>( *it );
@@ -321,10 +315,17 @@ void Session::update(float dt)
             if ( !(*it)->ready() )
                 test_ready = false;
             // update the source
-            (*it)->setActive(activation_threshold_);
+            ProfileZone zone("Source", (*it)->id(), (*it)->name().c_str());
+            (*it)->updateLevelOfDetail( render_.resolution() );
             (*it)->update(dt);
-            // render the source
-            (*it)->render();
+            (*it)->updateChanged();
+            changed |= (*it)->changed();
+            // do not render a source not needed in the output
+            if ( cull && (*it)->ready() && needed.count(*it) < 1 )
+                culled_.insert( (*it)->id() );
+            // render the source (if its frame changed, or was culled before)
+            else if ( culled_.erase( (*it)->id() ) > 0 || (*it)->changed() || !skip )
+                (*it)->render();
         }
 
         // apply session fading to audio
@@ -371,17 +372,109 @@ void Session::update(float dt)
         }
     }
 
-    // update the scene tree
-    render_.update(dt);
+    // detect changes of the composition (e.g. sources added or removed)
+    uint64_t h = BASETOOLKIT_HASH_SEED;
+    for( SourceList::iterator it = sources_.begin(); it != sources_.end(); ++it)
+        BaseToolkit::hash(h, (*it)->id());
+    BaseToolkit::hash(h, render_.fading());
+    BaseToolkit::hash(h, render_.resolution());
+    BaseToolkit::hash(h, Shader::force_blending_opacity);
+    if ( h != state_ ) {
+        state_ = h;
+        changed = true;
+    }
+    changed_ = changed;
 
-    // draw render view in Frame Buffer
-    render_.draw();
+    {
+        ProfileZone zone("Session render");
+        // update the scene tree
+        render_.update(dt);
+
+        // draw render view in Frame Buffer (if changed)
+        if ( changed_ || !skip ) {
+            render_.draw();
+            ++changes_;
+        }
+    }
 
     // draw the thumbnail only after all sources are ready
     if (ready_)
         render_.drawThumbnail();
 }
 
+const SourceList &Session::schedule(SourceListUnique &needed)
+{
+    // index sources by id (updated after changes of sources)
+    resolve();
+
+    // topological order: depth-first visit of the sources each source depends on
+    // (only after sources or their dependencies changed)
+    const bool ordered = !scheduled_;
+    if ( ordered ) {
+        schedule_.clear();
+        std::map<Source *, int> visit; // 1: visiting, 2: visited
+        std::function<void(Source *)> sort = [&](Source *s) {
+            visit[s] = 1;
+            SourceIdList dependencies = s->dependencies();
+            for (auto d = dependencies.begin(); d != dependencies.end(); ++d) {
+                auto dep = resolved_sources_.find(*d);
+                if ( dep == resolved_sources_.end() || dep->second == s )
+                    continue;
+                // dependency being visited is a cycle: it will use previous frame
+                if ( visit[dep->second] == 1 ) {
+                    if ( cycles_.insert( {s->id(), *d} ).second )
+                        Log::Info("Session sources '%s' and '%s' depend on each other; one renders with one frame delay.",
+                                  s->name().c_str(), dep->second->name().c_str());
+                }
+                else if ( visit[dep->second] == 0 )
+                    sort(dep->second);
+            }
+            visit[s] = 2;
+            schedule_.push_back(s);
+        };
+        for (auto it = sources_.begin(); it != sources_.end(); ++it) {
+            if ( visit[*it] == 0 )
+                sort(*it);
+        }
+        scheduled_ = true;
+    }
+
+    // in reverse order, consumers come before the sources they depend on:
+    // activate and propagate the need of visible sources to their dependencies
+    uint64_t h = BASETOOLKIT_HASH_SEED;
+    for (auto it = schedule_.rbegin(); it != schedule_.rend(); ++it) {
+        SourceIdList dependencies = (*it)->dependencies();
+        // keep track of dependencies to detect their change
+        for (auto d = dependencies.begin(); d != dependencies.end(); ++d)
+            BaseToolkit::hash(h, *d);
+        BaseToolkit::hash(h, dependencies.size());
+        if ( (*it)->failed() )
+            continue;
+        (*it)->setActive(activation_threshold_);
+        if ( (*it)->active() && (*it)->alpha() > EPSILON )
+            needed.insert(*it);
+        if ( needed.count(*it) > 0 ) {
+            for (auto d = dependencies.begin(); d != dependencies.end(); ++d) {
+                auto dep = resolved_sources_.find(*d);
+                if ( dep != resolved_sources_.end() )
+                    needed.insert(dep->second);
+            }
+        }
+    }
+
+    // a dependency changed (e.g. mask source or origin of clone): order again
+    if ( h != schedule_state_ ) {
+        schedule_state_ = h;
+        if ( !ordered ) {
+            scheduled_ = false;
+            needed.clear();
+            return schedule(needed);
+        }
+    }
+
+    return schedule_;
+}
+
 SourceList::iterator Session::addSource(Source *s)
 {
     // lock before change
@@ -396,6 +489,7 @@ SourceList::iterator Session::addSource(Source *s)
         attachSource(s);
         // insert the source to the end of the list
         sources_.push_back(s);
+        resolved_ = false;
         // return the iterator to the source created at the end
         its = --sources_.end();
     }
@@ -423,6 +517,7 @@ SourceList::iterator Session::deleteSource(Source *s)
         failed_.erase(s);
         // erase the source from the update list & get next element
         its = sources_.erase(its);
+        resolved_ = false;
         // delete the source : safe now
         delete s;
     }
@@ -451,6 +546,7 @@ SourceList::iterator Session::removeSource(Source *s)
         failed_.erase(s);
         // erase the source from the update list & get next element
         ret = sources_.erase(its);
+        resolved_ = false;
     }
 
     // unlock access
@@ -472,6 +568,7 @@ Source *Session::popSource()
         detachSource(s);
         // erase the source from the update list & get next element
         sources_.erase(its);
+        resolved_ = false;
     }
 
     return s;
@@ -663,6 +760,7 @@ void Session::move(int current_index, int target_index)
     Source *s = (*from);
     sources_.erase(from);
     sources_.insert(to, s);
+    resolved_ = false;
 }
 
 bool Session::hasLink (SourceList sources)
@@ -777,6 +875,7 @@ size_t Session::numBatch() const
 void Session::addBatch(const SourceIdList &ids)
 {
     batch_.push_back( ids );
+    resolved_ = false;
 }
 
 void Session::addSourceToBatch(Source *s, size_t i)
@@ -785,6 +884,7 @@ void Session::addSourceToBatch(Source *s, size_t i)
     {
         if ( std::find(batch_[i].begin(), batch_[i].end(), s->id()) == batch_[i].end() )
             batch_[i].push_back(s->id());
+        resolved_ = false;
     }
 }
 
@@ -803,12 +903,39 @@ void Session::removeSourceFromBatch(Source *s, size_t i)
     {
         batch_[i].remove( s->id() );
     }
+    resolved_ = false;
 }
 
 void Session::deleteBatch(size_t i)
 {
     if (i < batch_.size() )
         batch_.erase( batch_.begin() + i);
+    resolved_ = false;
+}
+
+void Session::resolve()
+{
+    if (resolved_)
+        return;
+
+    // map id of sources to sources
+    resolved_sources_.clear();
+    for (auto it = sources_.begin(); it != sources_.end(); ++it)
+        resolved_sources_[(*it)->id()] = *it;
+
+    // list of sources for each batch
+    resolved_batch_.assign( batch_.size(), SourceList() );
+    for (size_t i = 0; i < batch_.size(); ++i) {
+        for (auto sid = batch_[i].begin(); sid != batch_[i].end(); ++sid) {
+            auto it = resolved_sources_.find(*sid);
+            if ( it != resolved_sources_.end())
+                resolved_batch_[i].push_back( it->second );
+        }
+    }
+
+    resolved_ = true;
+    // sources changed: order them again
+    scheduled_ = false;
 }
 
 SourceList Session::getBatch(size_t i) const
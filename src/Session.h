@@ -99,6 +99,9 @@ public:
 
     // update all sources and mark sources which failed
     inline bool ready () const  { return ready_; }
+    // a session cued (pre-loaded in background) does not listen to inputs
+    inline void setCued (bool on) { cued_ = on; }
+    inline bool cued () const   { return cued_; }
     void update (float dt);
     uint64_t runtime() const;
 
@@ -114,6 +117,11 @@ public:
 
     // get frame result of render
     inline FrameBuffer *frame () const { return render_.frame(); }
+    inline uint passesSaved () const { return render_.passesSaved(); }
+
+    // informs if the frame changed in last update, and counts frames changed
+    inline bool changed () const { return changed_; }
+    inline uint64_t changes () const { return changes_; }
 
     // get an newly rendered thumbnail
     inline FrameBufferImage *renderThumbnail () { return render_.thumbnail(); }
@@ -219,15 +227,31 @@ protected:
     SourceListUnique failed_;
     SourceList sources_;
     void validate(SourceList &sources);
+    // sources in topological order (updated after changes)
+    SourceList schedule_;
+    bool scheduled_;
+    uint64_t schedule_state_;
+    const SourceList &schedule(SourceListUnique &needed);
+    std::set<uint64_t> culled_;
+    std::set< std::pair<uint64_t, uint64_t> > cycles_;
     std::list<SessionNote> notes_;
     std::list<MixingGroup *> mixing_groups_;
     std::map<View::Mode, Group*> config_;
     SessionSnapshots snapshots_;
     std::vector<SourceIdList> batch_;
+    // sources and batches resolved into pointers (updated after changes)
+    std::map<uint64_t, Source *> resolved_sources_;
+    std::vector<SourceList> resolved_batch_;
+    bool resolved_;
+    void resolve();
     std::mutex access_;
     FrameBufferImage *thumbnail_;
     uint64_t start_time_;
     bool ready_;
+    bool cued_;
+    bool changed_;
+    uint64_t changes_;
+    uint64_t state_;
 
     struct Fading
     {
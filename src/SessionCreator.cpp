@@ -930,8 +930,27 @@ void SessionLoader::visit(MediaPlayer &n)
             }
             XMLElement *fadingselement = timelineelement->FirstChildElement("Fading");
             if (fadingselement) {
-                XMLElement* array = fadingselement->FirstChildElement("array");
-                XMLElementDecodeArray(array, tl.fadingArray(), MAX_TIMELINE_ARRAY * sizeof(float));
+                XMLElement* key = fadingselement->FirstChildElement("Key");
+                if (key) {
+                    FadingKeys keys;
+                    for( ; key ; key = key->NextSiblingElement("Key"))
+                    {
+                        uint64_t t = GST_CLOCK_TIME_NONE;
+                        float v = 1.f;
+                        key->QueryUnsigned64Attribute("time", &t);
+                        key->QueryFloatAttribute("value", &v);
+                        if (t != GST_CLOCK_TIME_NONE)
+                            keys.push_back( {(GstClockTime) t, v} );
+                    }
+                    tl.setFadingKeys(keys);
+                }
+                else {
+                    // older versions saved fading as an array of samples
+                    XMLElement* array = fadingselement->FirstChildElement("array");
+                    float fading[MAX_TIMELINE_ARRAY];
+                    if ( XMLElementDecodeArray(array, fading, MAX_TIMELINE_ARRAY * sizeof(float)) )
+                        tl.setFadingArray(fading, MAX_TIMELINE_ARRAY);
+                }
                 uint mode = 0;
                 fadingselement->QueryUnsignedAttribute("mode", &mode);
                 n.setTimelineFadingMode((MediaPlayer::FadingMode) mode);
@@ -979,6 +998,10 @@ void SessionLoader::visit(MediaPlayer &n)
             mediaplayerNode->QueryBoolAttribute("software_decoding", &gpudisable);
             n.setSoftwareDecodingForced(gpudisable);
 
+            bool clipcache = false;
+            mediaplayerNode->QueryBoolAttribute("clip_cache", &clipcache);
+            n.setClipCache(clipcache);
+
             int sync_to_metronome = 0;
             mediaplayerNode->QueryIntAttribute("sync_to_metronome", &sync_to_metronome);
             n.setSyncToMetronome( (Metronome::Synchronicity) sync_to_metronome);
@@ -1224,8 +1247,12 @@ void SessionLoader::visit (SessionFileSource& s)
                     path = rel;
                 }
             }
+            // share session with other sources of the same file
+            bool shared = false;
+            xmlCurrent_->QueryBoolAttribute("shared", &shared);
             // load only if session source s is new
             if ( path != s.path() ) {
+                s.setShared(shared);
                 // level of session imbrication
                 uint l = level_;
                 if ( path == session_->filename() && l < MAX_SESSION_LEVEL) {
@@ -1239,6 +1266,9 @@ void SessionLoader::visit (SessionFileSource& s)
                 // launch session loader at incremented level
                 s.load(path, l);
             }
+            // change of sharing mode reloads the session
+            else if ( shared != s.shared() )
+                s.setShared(shared);
         }
     }
 
@@ -1490,6 +1520,11 @@ void SessionLoader::visit (MultiFileSource& s)
             seq->QueryBoolAttribute("loop", &loop);
             if ( loop != s.loop() )
                 s.setLoop(loop);
+
+            bool memory_cache = false;
+            seq->QueryBoolAttribute("memory_cache", &memory_cache);
+            if ( memory_cache != s.memoryCache() )
+                s.setMemoryCache(memory_cache);
         }
     }
 
@@ -147,6 +147,7 @@ void Settings::terminate(uint64_t runtime, const std::string &filename)
     applicationNode->SetAttribute("scale", application.scale);
     applicationNode->SetAttribute("accent_color", application.accent_color);
     applicationNode->SetAttribute("smooth_transition", application.smooth_transition);
+    applicationNode->SetAttribute("cue_next_session", application.cue_next_session);
     applicationNode->SetAttribute("save_snapshot", application.save_version_snapshot);
     applicationNode->SetAttribute("action_history_follow_view", application.action_history_follow_view);
     applicationNode->SetAttribute("show_tooptips", application.show_tooptips);
@@ -173,6 +174,8 @@ void Settings::terminate(uint64_t runtime, const std::string &filename)
     applicationNode->SetAttribute("shm_socket_path", application.shm_socket_path.c_str());
     applicationNode->SetAttribute("shm_method", application.shm_method);
     applicationNode->SetAttribute("accept_audio", application.accept_audio);
+    applicationNode->SetAttribute("audio_mixing", application.audio_mixing);
+    applicationNode->SetAttribute("session_journal", application.session_journal);
 
     XMLElement *transcodeNode = xmlDoc.NewElement( "Transcode" );
     transcodeNode->SetAttribute("option_0", application.transcode_options[0]);
@@ -220,6 +223,18 @@ void Settings::terminate(uint64_t runtime, const std::string &filename)
     RenderNode->SetAttribute("multisampling", application.render.multisampling);
     RenderNode->SetAttribute("gpu_decoding", application.render.gpu_decoding);
     RenderNode->SetAttribute("gst_glmemory_context", application.render.gst_glmemory_context);
+    RenderNode->SetAttribute("reverse_cache", application.render.reverse_cache);
+    RenderNode->SetAttribute("clip_cache_budget", application.render.clip_cache_budget);
+    RenderNode->SetAttribute("cue_memory_budget", application.render.cue_memory_budget);
+    RenderNode->SetAttribute("residency", application.render.residency);
+    RenderNode->SetAttribute("residency_budget", application.render.residency_budget);
+    RenderNode->SetAttribute("proxy", application.render.proxy);
+    RenderNode->SetAttribute("proxy_height", application.render.proxy_height);
+    RenderNode->SetAttribute("proxy_location", application.render.proxy_location);
+    RenderNode->SetAttribute("level_of_detail", application.render.level_of_detail);
+    RenderNode->SetAttribute("batch_compositing", application.render.batch_compositing);
+    RenderNode->SetAttribute("skip_unchanged", application.render.skip_unchanged);
+    RenderNode->SetAttribute("render_on_demand", application.render.render_on_demand);
     RenderNode->SetAttribute("ratio", application.render.ratio);
     RenderNode->SetAttribute("res", application.render.res);
     RenderNode->SetAttribute("custom_width", application.render.custom_width);
@@ -514,6 +529,7 @@ void Settings::init(const std::string &filename)
             applicationNode->QueryFloatAttribute("scale", &application.scale);
             applicationNode->QueryIntAttribute("accent_color", &application.accent_color);
             applicationNode->QueryBoolAttribute("smooth_transition", &application.smooth_transition);
+            applicationNode->QueryBoolAttribute("cue_next_session", &application.cue_next_session);
             applicationNode->QueryBoolAttribute("save_snapshot", &application.save_version_snapshot);
             applicationNode->QueryBoolAttribute("action_history_follow_view", &application.action_history_follow_view);
             applicationNode->QueryBoolAttribute("show_tooptips", &application.show_tooptips);
@@ -538,6 +554,8 @@ void Settings::init(const std::string &filename)
             applicationNode->QueryIntAttribute("broadcast_port", &application.broadcast_port);
             applicationNode->QueryIntAttribute("loopback_camera", &application.loopback_camera);
             applicationNode->QueryBoolAttribute("accept_audio", &application.accept_audio);
+            applicationNode->QueryBoolAttribute("audio_mixing", &application.audio_mixing);
+            applicationNode->QueryBoolAttribute("session_journal", &application.session_journal);
             applicationNode->QueryIntAttribute("shm_method", &application.shm_method);
 
             XMLElement * transcodeNode = applicationNode->FirstChildElement("Transcode");
@@ -597,6 +615,18 @@ void Settings::init(const std::string &filename)
 #ifndef USE_GST_OPENGL_SYNC_HANDLER
             application.render.gst_glmemory_context = false;
 #endif
+            rendernode->QueryBoolAttribute("reverse_cache", &application.render.reverse_cache);
+            rendernode->QueryIntAttribute("clip_cache_budget", &application.render.clip_cache_budget);
+            rendernode->QueryIntAttribute("cue_memory_budget", &application.render.cue_memory_budget);
+            rendernode->QueryBoolAttribute("residency", &application.render.residency);
+            rendernode->QueryIntAttribute("residency_budget", &application.render.residency_budget);
+            rendernode->QueryBoolAttribute("proxy", &application.render.proxy);
+            rendernode->QueryIntAttribute("proxy_height", &application.render.proxy_height);
+            rendernode->QueryIntAttribute("proxy_location", &application.render.proxy_location);
+            rendernode->QueryBoolAttribute("level_of_detail", &application.render.level_of_detail);
+            rendernode->QueryBoolAttribute("batch_compositing", &application.render.batch_compositing);
+            rendernode->QueryBoolAttribute("skip_unchanged", &application.render.skip_unchanged);
+            rendernode->QueryBoolAttribute("render_on_demand", &application.render.render_on_demand);
             rendernode->QueryIntAttribute("ratio", &application.render.ratio);
             rendernode->QueryIntAttribute("res", &application.render.res);
             rendernode->QueryIntAttribute("custom_width", &application.render.custom_width);
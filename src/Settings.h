@@ -195,6 +195,18 @@ struct RenderConfig
     bool gpu_decoding;
     bool gpu_decoding_available;
     bool gst_glmemory_context;
+    bool reverse_cache;
+    int clip_cache_budget;
+    int cue_memory_budget;
+    bool residency;
+    int residency_budget;
+    bool proxy;
+    int proxy_height;
+    int proxy_location;
+    bool level_of_detail;
+    bool batch_compositing;
+    bool skip_unchanged;
+    bool render_on_demand;
 
     RenderConfig() {
         disabled = false;
@@ -208,6 +220,18 @@ struct RenderConfig
         gpu_decoding = true;
         gpu_decoding_available = false;
         gst_glmemory_context = true;
+        reverse_cache = true;
+        clip_cache_budget = 2048;
+        cue_memory_budget = 1024;
+        residency = false;
+        residency_budget = 2048;
+        proxy = false;
+        proxy_height = 540;
+        proxy_location = 0;
+        level_of_detail = false;
+        batch_compositing = false;
+        skip_unchanged = false;
+        render_on_demand = false;
     }
 };
 
@@ -290,6 +314,7 @@ struct Application
     int  accent_color;
     bool save_version_snapshot;
     bool smooth_transition;
+    bool cue_next_session;
     bool proportional_grid;
     int  mouse_pointer;
     bool mouse_pointer_lock;
@@ -315,6 +340,10 @@ struct Application
 
     // audio
     bool accept_audio;
+    bool audio_mixing;
+
+    // journal of session changes
+    bool session_journal;
 
     // Settings of widgets
     WidgetsConfig widget;
@@ -381,6 +410,7 @@ struct Application
         scale = 1.f;
         accent_color = 0;
         smooth_transition = true;
+        cue_next_session = false;
         save_version_snapshot = false;
         proportional_grid = true;
         mouse_pointer = 1;
@@ -423,6 +453,8 @@ struct Application
         brush = glm::vec3(0.5f, 0.1f, 0.f);
         brush_pressure_mode = 0;
         accept_audio = false;
+        audio_mixing = false;
+        session_journal = true;
         dialogPosition = glm::ivec2(-1, -1);
         image_sequence.framerate_mode = 15;
         gamepad_id = 0;
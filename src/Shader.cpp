@@ -208,6 +208,11 @@ void ShadingProgram::use()
     }
 }
 
+int ShadingProgram::location(const std::string& name) const
+{
+    return glGetUniformLocation(id_, name.c_str());
+}
+
 void ShadingProgram::enduse()
 {
     glUseProgram(0);
@@ -320,6 +325,8 @@ bool ShadingProgram::setUniform<glm::mat4>(const std::string& name, glm::mat4 va
 
 
 bool Shader::force_blending_opacity = false;
+uint Shader::draw_calls = 0;
+void (*Shader::before_use)() = nullptr;
 std::vector< std::tuple<int, int, std::string> > Shader::blendingFunction = {
     {5, 6, "Normal"},
     {7, 6, "Screen"},
@@ -354,6 +361,11 @@ void Shader::accept(Visitor& v) {
 
 void Shader::use()
 {
+    // draw what was pending before
+    if (before_use)
+        before_use();
+    ++draw_calls;
+
     // Use program
     program_->use();
 
@@ -29,6 +29,10 @@ public:
     template<typename T> bool setUniform(const std::string& name, T val1, T val2);
     template<typename T> bool setUniform(const std::string& name, T val1, T val2, T val3);
 
+    // to look up uniform locations once (changes with id after compilation)
+    inline unsigned int id() const { return id_; }
+    int location(const std::string& name) const;
+
 private:
     unsigned int id_;
     bool need_compile_;
@@ -75,6 +79,10 @@ public:
     BlendMode blending;
     static std::vector< std::tuple<int, int, std::string> > blendingFunction;
     static bool force_blending_opacity;
+    // count of shader uses, i.e. of draw calls
+    static uint draw_calls;
+    // called before any shader use (e.g. to draw pending instanced meshes)
+    static void (*before_use)();
 
 protected:
     ShadingProgram *program_;
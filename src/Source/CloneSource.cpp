@@ -89,6 +89,31 @@ void CloneSource::init()
     }
 }
 
+bool CloneSource::contentChanged()
+{
+    // frame of origin changed, or filter can change over time
+    return ( origin_ != nullptr && origin_->changed() ) ||
+           ( playing() && filter_->type() != FrameBufferFilter::FILTER_PASSTHROUGH );
+}
+
+SourceIdList CloneSource::dependencies() const
+{
+    SourceIdList ids = Source::dependencies();
+
+    // frame of origin
+    if ( origin_ != nullptr )
+        ids.push_back( origin_->id() );
+
+    // textures of image filter
+    if ( filter_->type() == FrameBufferFilter::FILTER_IMAGE ) {
+        auto textures = static_cast<ImageFilter *>(filter_)->program().textures();
+        for (auto t = textures.begin(); t != textures.end(); ++t)
+            ids.push_back( t->second );
+    }
+
+    return ids;
+}
+
 void CloneSource::render()
 {
     if ( renderbuffer_ == nullptr )
@@ -27,6 +27,7 @@ public:
     glm::ivec2 icon() const override;
     std::string info() const override;
     bool texturePostProcessed() const override { return true; }
+    SourceIdList dependencies() const override;
 
     // implementation of cloning mechanism
     void detach();
@@ -43,6 +44,9 @@ protected:
     CloneSource(Source *origin, uint64_t id = 0);
 
     void init() override;
+    bool contentChanged() override;
+    // resolution follows the frame of the origin
+    void applyLevelOfDetail() override {}
     Source *origin_;
     std::string origin_name_;
 
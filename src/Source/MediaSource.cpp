@@ -24,11 +24,13 @@
 #include "Scene/Decorations.h"
 #include "MediaPlayer.h"
 #include "Visitor/Visitor.h"
+#include "Settings.h"
+#include "Proxies.h"
 #include "Log.h"
 
 #include "MediaSource.h"
 
-MediaSource::MediaSource(uint64_t id) : Source(id), path_("")
+MediaSource::MediaSource(uint64_t id) : Source(id), path_(""), texture_updates_(0)
 {
     // create media player
     mediaplayer_ = new MediaPlayer;
@@ -153,6 +155,14 @@ void MediaSource::setActive (bool on)
 }
 
 
+void MediaSource::setResident (bool on)
+{
+    Source::setResident(on);
+
+    // release or re-create the decoding pipeline
+    mediaplayer_->suspend(!on);
+}
+
 bool MediaSource::playing () const
 {
     return mediaplayer_->isPlaying();
@@ -187,10 +197,39 @@ void MediaSource::update(float dt)
 {
     Source::update(dt);
 
+    // decode proxy or full resolution media
+    updateProxy();
+
     // update video
     mediaplayer_->update();
 }
 
+void MediaSource::updateProxy()
+{
+    bool use_proxy = false;
+    const float h = (float) Settings::application.render.proxy_height;
+
+    // proxy only for videos larger than the proxy
+    if ( Settings::application.render.proxy && mediaplayer_->isOpen() && !mediaplayer_->isImage()
+         && (float) mediaplayer_->height() > h ) {
+
+        // get proxy when available
+        if ( !mediaplayer_->hasProxy() ) {
+            std::string p = Proxies::manager().get(path_);
+            if ( !p.empty() )
+                mediaplayer_->setProxy(p, (guint) h);
+        }
+
+        // full resolution needed only for a live output, if displayed larger than the proxy
+        if ( mediaplayer_->hasProxy() )
+            use_proxy = !Proxies::live() ||
+                    footprint() < ( mediaplayer_->usingProxy() ? h : h * PROXY_HYSTERESIS );
+    }
+
+    // NB: no change if the proxy is not set
+    mediaplayer_->useProxy(use_proxy);
+}
+
 void MediaSource::updateAudio()
 {
     // update enable/ disable status of audio of media player (do nothing if no change)
@@ -217,11 +256,22 @@ void MediaSource::updateAudio()
     }
 }
 
+bool MediaSource::contentChanged()
+{
+    // a new frame was filled in the texture of the media player
+    guint64 n = mediaplayer_->textureUpdates();
+    bool c = n != texture_updates_;
+    texture_updates_ = n;
+    return c;
+}
+
 void MediaSource::render()
 {
     if ( renderbuffer_ == nullptr )
         init();
     else {
+        // texture of the media player changes with proxy
+        texturesurface_->setTextureIndex( mediaplayer_->texture() );
         // render the media player into frame buffer
         // NB: this also applies the color correction shader
         renderbuffer_->begin();
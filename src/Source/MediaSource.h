@@ -14,6 +14,7 @@ public:
     // implementation of source API
     void update (float dt) override;
     void setActive (bool on) override;
+    void setResident (bool on) override;
     bool playing () const override;
     void play (bool) override;
     bool playable () const  override;
@@ -38,9 +39,12 @@ public:
 protected:
 
     void init() override;
+    bool contentChanged() override;
+    void updateProxy();
 
     std::string path_;
     MediaPlayer *mediaplayer_;
+    guint64 texture_updates_;
 };
 
 #endif // MEDIASOURCE_H
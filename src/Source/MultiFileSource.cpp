@@ -18,8 +18,12 @@
 **/
 
 #include <sstream>
+#include <iomanip>
 #include <algorithm>
 
+#include <gst/app/gstappsrc.h>
+#include <stb_image.h>
+
 #include "Scene/Decorations.h"
 #include "Stream.h"
 #include "Visitor/Visitor.h"
@@ -27,6 +31,7 @@
 #include "Toolkit/BaseToolkit.h"
 #include "Toolkit/SystemToolkit.h"
 #include "MediaPlayer.h"
+#include "CacheBudget.h"
 #include "Log.h"
 
 #include "MultiFileSource.h"
@@ -39,6 +44,13 @@
 // imagesequencesrc : sequence of numbered images (cannot loop)
 // gst-launch-1.0 imagesequencesrc location=frames%03d.png start-index=1 framerate=24/1 ! decodebin ! videoconvert ! autovideosink
 //
+// appsrc : images decoded by MultiFileReader
+// appsrc name=src format=time block=true caps="video/x-raw,format=RGBA,width=1920,height=1080,framerate=(fraction)30/1" ! videoconvert
+
+// maximum number of threads decoding images of a sequence
+#define MULTIFILE_MAX_WORKERS 8
+// number of frames pushed in advance in the gstreamer pipeline
+#define MULTIFILE_QUEUE 2
 
 MultiFileSequence::MultiFileSequence() : width(0), height(0), min(0), max(0)
 {
@@ -80,11 +92,339 @@ bool MultiFileSequence::operator != (const MultiFileSequence& b)
               height != b.height || min != b.min || max != b.max );
 }
 
+MultiFileReader::MultiFileReader(const MultiFileSequence &sequence, uint framerate) :
+    digits_(0), width_(sequence.width), height_(sequence.height),
+    begin_(sequence.min), end_(sequence.max), loop_(true), cursor_(sequence.min), last_(sequence.min),
+    cache_all_(false), reserved_(0), stopped_(false)
+{
+    // split location pattern 'prefix%0Nd.suffix'
+    size_t pos = sequence.location.rfind('%');
+    if (pos != std::string::npos) {
+        prefix_ = sequence.location.substr(0, pos);
+        digits_ = std::atoi( sequence.location.c_str() + pos + 1 );
+        size_t d = sequence.location.find('d', pos);
+        if (d != std::string::npos)
+            suffix_ = sequence.location.substr(d + 1);
+    }
+
+    duration_ = gst_util_uint64_scale_int (GST_SECOND, 1, MAX(framerate, 1));
+
+    // pool of decoding threads, each decoding one frame in advance
+    size_t n = CLAMP( std::thread::hardware_concurrency() / 2, 2, MULTIFILE_MAX_WORKERS);
+    prefetch_ = n + MULTIFILE_QUEUE;
+    for (size_t i = 0; i < n; ++i)
+        workers_.push_back( std::thread(&MultiFileReader::decode, this) );
+}
+
+MultiFileReader::~MultiFileReader()
+{
+    stop();
+    for (auto t = workers_.begin(); t != workers_.end(); ++t)
+        t->join();
+
+    for (auto f = frames_.begin(); f != frames_.end(); ++f) {
+        if (f->second)
+            gst_buffer_unref(f->second);
+    }
+    CacheBudget::manager().release(reserved_);
+}
+
+bool MultiFileReader::supported(const MultiFileSequence &sequence)
+{
+    // formats decoded by stb_image
+    static const std::list<std::string> extensions = { "png", "jpg", "jpeg", "bmp", "tga", "ppm", "pgm" };
+
+    for (auto e = extensions.begin(); e != extensions.end(); ++e) {
+        if ( SystemToolkit::has_extension(sequence.location, *e) )
+            return sequence.valid();
+    }
+    return false;
+}
+
+std::string MultiFileReader::filename(int index) const
+{
+    std::ostringstream oss;
+    oss << prefix_ << std::setw(digits_) << std::setfill('0') << index << suffix_;
+    return oss.str();
+}
+
+int MultiFileReader::following(int index) const
+{
+    if (index < end_)
+        return index + 1;
+    return loop_ ? begin_ : -1;
+}
+
+bool MultiFileReader::wanted(int index) const
+{
+    if (index < begin_ || index > end_)
+        return false;
+
+    if (cache_all_)
+        return true;
+
+    // in the look-ahead window
+    int i = cursor_;
+    for (size_t k = 0; k < prefetch_ && i > -1; ++k, i = following(i)) {
+        if (i == index)
+            return true;
+    }
+    return false;
+}
+
+int MultiFileReader::candidate() const
+{
+    // first in the look-ahead window
+    int i = cursor_;
+    for (size_t k = 0; k < prefetch_ && i > -1; ++k, i = following(i)) {
+        if ( frames_.count(i) < 1 && pending_.count(i) < 1 )
+            return i;
+    }
+
+    // then any frame of the range to keep in memory
+    if (cache_all_) {
+        for (i = begin_; i <= end_; ++i) {
+            if ( frames_.count(i) < 1 && pending_.count(i) < 1 )
+                return i;
+        }
+    }
+
+    return -1;
+}
+
+void MultiFileReader::evict()
+{
+    for (auto f = frames_.begin(); f != frames_.end(); ) {
+        if ( !wanted(f->first) ) {
+            if (f->second)
+                gst_buffer_unref(f->second);
+            f = frames_.erase(f);
+        }
+        else
+            ++f;
+    }
+}
+
+void MultiFileReader::decode()
+{
+    std::unique_lock<std::mutex> lock(access_);
+    while (!stopped_) {
+
+        int index = candidate();
+        if (index < 0) {
+            work_.wait(lock);
+            continue;
+        }
+        pending_.insert(index);
+        lock.unlock();
+
+        // decode image outside of lock
+        GstBuffer *buffer = nullptr;
+        int w = 0, h = 0, c = 0;
+        std::string file = filename(index);
+        unsigned char *data = stbi_load(file.c_str(), &w, &h, &c, 4);
+        if (data) {
+            if ( (guint) w == width_ && (guint) h == height_ ) {
+                gsize size = (gsize) w * (gsize) h * 4;
+                buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, data, size, 0, size,
+                                                     data, stbi_image_free);
+            }
+            else {
+                Log::Info("MultiFile image '%s' has not the size of the sequence.", file.c_str());
+                stbi_image_free(data);
+            }
+        }
+        else
+            Log::Info("MultiFile cannot read image '%s'.", file.c_str());
+
+        lock.lock();
+        pending_.erase(index);
+        // keep frame (or nullptr if unreadable) if still wanted
+        if ( !stopped_ && wanted(index) && frames_.count(index) < 1 )
+            frames_[index] = buffer;
+        else if (buffer)
+            gst_buffer_unref(buffer);
+        ready_.notify_all();
+    }
+}
+
+GstBuffer *MultiFileReader::next()
+{
+    std::unique_lock<std::mutex> lock(access_);
+    while (!stopped_) {
+        // cursor_ is -1 at the end of a sequence not looping
+        if (cursor_ > -1) {
+            auto f = frames_.find(cursor_);
+            if (f != frames_.end()) {
+                // shallow copy of the frame, to set timestamp
+                GstBuffer *frame = f->second ? gst_buffer_copy(f->second) : nullptr;
+                if (frame)
+                    last_ = cursor_;
+                // move look-ahead window
+                cursor_ = following(cursor_);
+                evict();
+                work_.notify_all();
+                // skip unreadable images
+                if (frame)
+                    return frame;
+                continue;
+            }
+        }
+        ready_.wait(lock);
+    }
+    return nullptr;
+}
+
+void MultiFileReader::feed(std::shared_ptr<MultiFileReader> reader, GstElement *appsrc)
+{
+    GstClockTime pts = 0;
+
+    GstBuffer *frame = reader->next();
+    while ( frame != nullptr ) {
+
+        // do not timestamp in the past after waiting for a frame
+        // (e.g. paused at end of sequence, or decoding too slow)
+        if ( GST_STATE(appsrc) == GST_STATE_PLAYING ) {
+            GstClock *clock = gst_element_get_clock(appsrc);
+            if (clock) {
+                GstClockTime now = gst_clock_get_time(clock);
+                GstClockTime base = gst_element_get_base_time(appsrc);
+                if (now > base)
+                    pts = MAX(pts, now - base);
+                gst_object_unref(clock);
+            }
+        }
+        GST_BUFFER_PTS(frame) = pts;
+        GST_BUFFER_DURATION(frame) = reader->duration_;
+        pts += reader->duration_;
+
+        // blocking push (appsrc queue is full); fails when pipeline is stopped
+        if ( gst_app_src_push_buffer(GST_APP_SRC(appsrc), frame) != GST_FLOW_OK )
+            break;
+
+        frame = reader->next();
+    }
+
+    gst_object_unref(appsrc);
+}
+
+void MultiFileReader::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(access_);
+        stopped_ = true;
+    }
+    work_.notify_all();
+    ready_.notify_all();
+}
+
+void MultiFileReader::setRange(int begin, int end, bool loop)
+{
+    std::lock_guard<std::mutex> lock(access_);
+    begin_ = begin;
+    end_ = MAX(begin, end);
+    loop_ = loop;
+
+    // restart from begin if out of range, or if looping after the end
+    if ( (cursor_ < 0 && loop_) || (cursor_ > -1 && (cursor_ < begin_ || cursor_ > end_)) )
+        cursor_ = begin_;
+
+    // update memory reserved for the new range
+    if (cache_all_) {
+        CacheBudget::manager().release(reserved_);
+        reserved_ = (guint64) (end_ - begin_ + 1) * (guint64) width_ * (guint64) height_ * 4;
+        uint64_t available = 0;
+        if ( !CacheBudget::manager().reserve(reserved_, &available) ) {
+            Log::Notify("Cannot keep images '%s' in memory; %lu MB needed, %lu MB available.",
+                        SystemToolkit::base_filename(prefix_).c_str(), reserved_ / 1048576, available / 1048576);
+            reserved_ = 0;
+            cache_all_ = false;
+        }
+    }
+
+    evict();
+    work_.notify_all();
+    ready_.notify_all();
+}
+
+void MultiFileReader::setIndex(int index)
+{
+    std::lock_guard<std::mutex> lock(access_);
+    cursor_ = CLAMP(index, begin_, end_);
+    evict();
+    work_.notify_all();
+    ready_.notify_all();
+}
+
+void MultiFileReader::rewind()
+{
+    std::lock_guard<std::mutex> lock(access_);
+    cursor_ = begin_;
+    evict();
+    work_.notify_all();
+    ready_.notify_all();
+}
+
+int MultiFileReader::index() const
+{
+    std::lock_guard<std::mutex> lock(access_);
+    return last_;
+}
+
+bool MultiFileReader::setCacheAll(bool on)
+{
+    std::lock_guard<std::mutex> lock(access_);
+    if (on == cache_all_)
+        return true;
+
+    if (on) {
+        // admission in global memory budget
+        guint64 size = (guint64) (end_ - begin_ + 1) * (guint64) width_ * (guint64) height_ * 4;
+        uint64_t available = 0;
+        if ( !CacheBudget::manager().reserve(size, &available) ) {
+            Log::Notify("Cannot keep images '%s' in memory; %lu MB needed, %lu MB available.",
+                        SystemToolkit::base_filename(prefix_).c_str(), size / 1048576, available / 1048576);
+            return false;
+        }
+        reserved_ = size;
+    }
+    else {
+        CacheBudget::manager().release(reserved_);
+        reserved_ = 0;
+    }
+
+    cache_all_ = on;
+    evict();
+    work_.notify_all();
+    return true;
+}
+
+bool MultiFileReader::cacheAll() const
+{
+    std::lock_guard<std::mutex> lock(access_);
+    return cache_all_;
+}
+
+
 MultiFile::MultiFile() : Stream(), src_(nullptr)
 {
 
 }
 
+// join the decoding threads and free the images of a reader
+// (in background, not to block the caller)
+static void reader_terminate(std::shared_ptr<MultiFileReader> reader)
+{
+    reader->stop();
+    reader.reset();
+}
+
+MultiFile::~MultiFile()
+{
+    if (reader_)
+        std::thread(reader_terminate, std::move(reader_)).detach();
+}
+
 void MultiFile::open (const MultiFileSequence &sequence, uint framerate )
 {
     std::string path = SystemToolkit::path_filename( sequence.location );
@@ -93,6 +433,30 @@ void MultiFile::open (const MultiFileSequence &sequence, uint framerate )
         return;
     }
 
+    // stop previous reader
+    if (reader_)
+        std::thread(reader_terminate, std::move(reader_)).detach();
+
+    // images decoded in advance by MultiFileReader and given to gstreamer
+    if ( MultiFileReader::supported(sequence) ) {
+
+        guint64 framesize = (guint64) sequence.width * (guint64) sequence.height * 4;
+        std::ostringstream gstreamer_pipeline;
+        gstreamer_pipeline << "appsrc name=src format=time block=true max-bytes=";
+        gstreamer_pipeline << framesize * MULTIFILE_QUEUE;
+        gstreamer_pipeline << " caps=\"video/x-raw,format=RGBA,width=";
+        gstreamer_pipeline << sequence.width << ",height=" << sequence.height;
+        gstreamer_pipeline << ",framerate=(fraction)" << framerate << "/1\"";
+        gstreamer_pipeline << " ! videoconvert";
+
+        // (private) open stream - asynchronous threaded process
+        Stream::open(gstreamer_pipeline.str(), sequence.width, sequence.height);
+
+        // reader ready to decode and feed the appsrc once opened
+        reader_ = std::make_shared<MultiFileReader>(sequence, framerate);
+        return;
+    }
+
     std::ostringstream gstreamer_pipeline;
     gstreamer_pipeline << "multifilesrc name=src location=\"";
     gstreamer_pipeline << sequence.location;
@@ -117,11 +481,18 @@ void MultiFile::execute_open()
     Stream::execute_open();
 
     // keep multifile source for dynamic properties change
-    src_ = gst_bin_get_by_name (GST_BIN (pipeline_), "src");
+    if (pipeline_ != nullptr)
+        src_ = gst_bin_get_by_name (GST_BIN (pipeline_), "src");
+
+    // start feeding the appsrc with images of the reader
+    if (reader_ && src_ && opened_)
+        std::thread(MultiFileReader::feed, reader_, GST_ELEMENT(gst_object_ref(src_))).detach();
 }
 
 void MultiFile::close ()
 {
+    if (reader_)
+        std::thread(reader_terminate, std::move(reader_)).detach();
     if (src_ != nullptr) {
         gst_object_unref (src_);
         src_ = nullptr;
@@ -131,6 +502,11 @@ void MultiFile::close ()
 
 void MultiFile::rewind ()
 {
+    if (reader_) {
+        reader_->rewind();
+        return;
+    }
+
     if (src_) {
         int begin = 0;
         g_object_get (src_, "start-index", &begin, NULL);
@@ -141,7 +517,9 @@ void MultiFile::rewind ()
 
 void MultiFile::setIndex(int val)
 {
-    if (src_) {
+    if (reader_)
+        reader_->setIndex(val);
+    else if (src_) {
         g_object_set (src_, "index", val, NULL);
     }
 }
@@ -149,7 +527,9 @@ void MultiFile::setIndex(int val)
 int MultiFile::index()
 {
     int val = 0;
-    if (src_) {
+    if (reader_)
+        val = reader_->index();
+    else if (src_) {
         g_object_get (src_, "index", &val, NULL);
     }
     return val;
@@ -157,16 +537,31 @@ int MultiFile::index()
 
 void MultiFile::setProperties (int begin, int end, int loop)
 {
-    if (src_) {
+    if (reader_)
+        reader_->setRange(MAX(begin, 0), MAX(end, 0), loop > 0);
+    else if (src_) {
         g_object_set (src_, "start-index", MAX(begin, 0), NULL);
         g_object_set (src_, "stop-index", MAX(end, 0), NULL);
         g_object_set (src_, "loop", MIN(loop, 1), NULL);
     }
 }
 
+bool MultiFile::setCacheAll (bool on)
+{
+    if (reader_)
+        return reader_->setCacheAll(on);
+    return !on;
+}
 
+bool MultiFile::cacheAll () const
+{
+    return reader_ ? reader_->cacheAll() : false;
+}
 
-MultiFileSource::MultiFileSource (uint64_t id) : StreamSource(id), framerate_(0), begin_(-1), end_(INT_MAX), loop_(1)
+
+
+MultiFileSource::MultiFileSource (uint64_t id) : StreamSource(id), framerate_(0), begin_(-1), end_(INT_MAX), loop_(1),
+    memory_cache_(false)
 {
     // create stream
     stream_ = static_cast<Stream *>( new MultiFile );
@@ -196,6 +591,10 @@ void MultiFileSource::setSequence (const MultiFileSequence &sequence, uint frame
         // validate range and apply loop_
         setRange(begin_, end_);
 
+        // keep images in memory
+        if (memory_cache_)
+            memory_cache_ = multifile()->setCacheAll(true);
+
         // will be ready after init and one frame rendered
         ready_ = false;
     }
@@ -227,6 +626,12 @@ void MultiFileSource::setRange (int begin, int end)
         multifile()->setProperties (begin_, end_, loop_);
 }
 
+void MultiFileSource::setMemoryCache (bool on)
+{
+    if (multifile())
+        memory_cache_ = multifile()->setCacheAll(on) && on;
+}
+
 void MultiFileSource::replay ()
 {
     if (multifile())
@@ -3,6 +3,12 @@
 
 #include <string>
 #include <list>
+#include <map>
+#include <set>
+#include <vector>
+#include <thread>
+#include <memory>
+#include <condition_variable>
 
 #include "StreamSource.h"
 
@@ -20,10 +26,71 @@ struct MultiFileSequence {
     bool operator != (const MultiFileSequence& b);
 };
 
+/**
+ * @brief The MultiFileReader decodes images of a sequence ahead of
+ * playback on a pool of threads, into a bounded set of ready frames.
+ *
+ * Frames are pushed in order to a gstreamer appsrc, looping or stopping
+ * at the end of the range. Optionally, all frames of the range are kept
+ * in memory (within the global clip cache budget).
+ */
+class MultiFileReader
+{
+public:
+    MultiFileReader (const MultiFileSequence &sequence, uint framerate);
+    ~MultiFileReader ();
+
+    // true if the images can be decoded by the reader
+    static bool supported (const MultiFileSequence &sequence);
+
+    // range and looping define the order of look-ahead
+    void setRange (int begin, int end, bool loop);
+    // next image to provide, and last image provided
+    void setIndex (int index);
+    void rewind ();
+    int index () const;
+
+    // keep all images of the range decoded in memory
+    bool setCacheAll (bool on);
+    bool cacheAll () const;
+
+    // push frames to the appsrc until stopped (thread function)
+    static void feed (std::shared_ptr<MultiFileReader> reader, GstElement *appsrc);
+    // terminate threads
+    void stop ();
+
+private:
+    std::string filename (int index) const;
+    int following (int index) const;
+    bool wanted (int index) const;
+    int candidate () const;
+    void evict ();
+    GstBuffer *next ();
+    void decode ();
+
+    std::string prefix_, suffix_;
+    int digits_;
+    guint width_, height_;
+    GstClockTime duration_;
+    int begin_, end_;
+    bool loop_;
+    int cursor_, last_;
+    bool cache_all_;
+    guint64 reserved_;
+    bool stopped_;
+    size_t prefetch_;
+    std::map<int, GstBuffer *> frames_;
+    std::set<int> pending_;
+    std::vector<std::thread> workers_;
+    mutable std::mutex access_;
+    std::condition_variable work_, ready_;
+};
+
 class MultiFile : public Stream
 {
 public:
     MultiFile ();
+    ~MultiFile ();
     void open (const MultiFileSequence &sequence, uint framerate = 30);
     void close () override;
     void rewind () override;
@@ -35,8 +102,13 @@ public:
     int index();
     void setIndex(int val);
 
+    // keep all images of the range in memory (if decoded by reader)
+    bool setCacheAll(bool on);
+    bool cacheAll() const;
+
 protected:
     GstElement *src_ ;
+    std::shared_ptr<MultiFileReader> reader_;
     void execute_open() override;
 };
 
@@ -71,12 +143,16 @@ public:
     inline int begin() const { return begin_; }
     inline int end  () const { return end_;   }
 
+    void setMemoryCache (bool on);
+    inline bool memoryCache () const { return memory_cache_; }
+
     MultiFile *multifile () const;
 
 private:
     MultiFileSequence sequence_;
     uint framerate_;
     int  begin_, end_, loop_;
+    bool memory_cache_;
 
 };
 
@@ -20,6 +20,9 @@
 #include <thread>
 #include <chrono>
 
+//  Desktop OpenGL function loader
+#include <glad/glad.h>
+
 #include <glm/gtc/matrix_transform.hpp>
 #include <gst/pbutils/pbutils.h>
 #include <gst/gst.h>
@@ -34,6 +37,7 @@
 #include "Scene/Decorations.h"
 #include "Visitor/Visitor.h"
 #include "Log.h"
+#include "FrameRing.h"
 
 #include "NetworkSource.h"
 
@@ -86,7 +90,8 @@ void NetworkStream::ResponseListener::ProcessMessage( const osc::ReceivedMessage
 
 
 NetworkStream::NetworkStream(): Stream(),
-    receiver_(nullptr), received_config_(false), connected_(false)
+    receiver_(nullptr), received_config_(false), connected_(false),
+    ring_(nullptr), ring_sequence_(0), ring_deadline_(0), ring_failed_(false)
 {
 
 }
@@ -170,6 +175,8 @@ void NetworkStream::connect(const std::string &nameconnection)
     // send my listening port to indicate to Connection::manager where to reply
     p << listener_port_;
     p << Connection::manager().info().name.c_str();
+    // indicate if frames can be shared in a memory ring (ignored by older streamers)
+    p << (!ring_failed_ && FrameRing::available());
     p << osc::EndMessage;
 
     // send OSC message to streamer
@@ -221,8 +228,25 @@ bool NetworkStream::connected() const
     return connected_ && Stream::isPlaying();
 }
 
+void NetworkStream::close()
+{
+    if (ring_) {
+        delete ring_;
+        ring_ = nullptr;
+    }
+    ring_deadline_ = 0;
+
+    Stream::close();
+}
+
 void NetworkStream::update()
 {
+    // no pipeline with shared memory ring
+    if (ring_ != nullptr || ring_deadline_ > 0) {
+        update_ring();
+        return;
+    }
+
     Stream::update();
 
     if ( !opened_ && !failed_ && received_config_)
@@ -239,6 +263,12 @@ void NetworkStream::update()
 #ifdef NETWORK_DEBUG
             Log::Info("Creating Shared Stream %d (%d x %d)", config_.port, config_.width, config_.height);
 #endif
+            // shared memory ring is created with the first frame sent: wait for it
+            if (config_.protocol == NetworkToolkit::SHM_RING) {
+                ring_deadline_ = g_get_monotonic_time() + 4 * G_TIME_SPAN_SECOND;
+                return;
+            }
+
             // prepare pipeline parameter with port given in config_
             std::string parameter = std::to_string(config_.port);
 
@@ -302,6 +332,86 @@ void NetworkStream::update()
     }
 }
 
+void NetworkStream::update_ring()
+{
+    // discard
+    if (failed_)
+        return;
+
+    // connect to the ring of frames of the streamer
+    if (ring_ == nullptr) {
+        std::string shm_file = SystemToolkit::full_filename(SystemToolkit::temp_path(), "shm") + std::to_string(config_.port);
+        ring_ = FrameRing::connect(shm_file);
+
+        if (ring_ == nullptr) {
+            // failed to connect the ring in time: try to reconnect without it
+            if ( g_get_monotonic_time() > ring_deadline_ ) {
+                ring_failed_ = true;
+                Log::Warning("Cannot connect to %s with shared memory ring: reverting to stream.", shm_file.c_str());
+                // disconnect whatever the play state (informs streamer of failure, ends waiting for ring)
+                failed_ = true;
+                disconnect();
+                failed_ = false;
+                // and quickly re-connect
+                connect( streamer_.name );
+            }
+            return;
+        }
+        ring_deadline_ = 0;
+        ring_sequence_ = 0;
+
+#ifdef NETWORK_DEBUG
+        Log::Info("Reading Shared Stream %d (%d x %d x %d)", config_.port, ring_->width(), ring_->height(), ring_->channels());
+#endif
+        // texture filled directly from shared memory (no pipeline)
+        width_ = ring_->width();
+        height_ = ring_->height();
+        glActiveTexture(GL_TEXTURE0);
+        if (textureindex_)
+            glDeleteTextures(1, &textureindex_);
+        glGenTextures(1, &textureindex_);
+        glBindTexture(GL_TEXTURE_2D, textureindex_);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width_, height_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        textureinitialized_ = false;
+        live_ = true;
+        opened_ = true;
+    }
+
+    // streamer stopped sharing
+    if (ring_->closed()) {
+        fail("Stream ended by " + streamer_.name);
+        return;
+    }
+
+    // paused or disabled
+    if (!enabled_ || !isPlaying())
+        return;
+
+    // upload the latest frame, if new, straight from shared memory
+    uint32_t sequence = ring_sequence_;
+    const unsigned char *pixels = ring_->latest(sequence);
+    if (pixels) {
+        glBindTexture(GL_TEXTURE_2D, textureindex_);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_,
+                        ring_->channels() > 3 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, pixels);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // keep the frame only if not overwritten during upload (otherwise read next one)
+        if ( ring_->valid(sequence) ) {
+            ring_sequence_ = sequence;
+            ++texture_updates_;
+            textureinitialized_ = true;
+            timecount_.tic();
+        }
+    }
+}
 
 NetworkSource::NetworkSource(uint64_t id) : StreamSource(id)
 {
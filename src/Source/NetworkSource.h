@@ -5,6 +5,8 @@
 #include "Connection.h"
 #include "StreamSource.h"
 
+class FrameRing;
+
 class NetworkStream : public Stream
 {
 public:
@@ -15,6 +17,7 @@ public:
     void disconnect();
 
     void update() override;
+    void close() override;
 
     glm::ivec2 resolution() const;
     inline NetworkToolkit::StreamProtocol protocol() const { return config_.protocol; }
@@ -42,6 +45,13 @@ private:
     std::atomic<bool> connected_;
 
     NetworkToolkit::StreamConfig config_;
+
+    // frames read directly from the shared memory ring of the streamer
+    FrameRing *ring_;
+    uint32_t ring_sequence_;
+    gint64 ring_deadline_;
+    bool ring_failed_;
+    void update_ring();
 };
 
 
@@ -44,7 +44,7 @@ std::vector< std::tuple<int, int, std::string> > RenderSource::ProvenanceMethod
     { 2, 10, "Canvas" }
 };
 
-RenderSource::RenderSource(uint64_t id) : Source(id), session_(nullptr), runtime_(0), rendered_output_(nullptr),
+RenderSource::RenderSource(uint64_t id) : Source(id), session_(nullptr), runtime_(0), session_changes_(0), rendered_output_(nullptr),
     paused_(false), reset_(true), provenance_(RENDER_TEXTURE), canvas_index_(0)
 {
     // set symbol
@@ -118,6 +118,23 @@ void RenderSource::init()
     }
 }
 
+bool RenderSource::contentChanged()
+{
+    // projections and canvas are rendered again at every update
+    if (session_ == nullptr || provenance_ != RENDER_TEXTURE)
+        return Source::contentChanged();
+
+    // frozen while paused
+    if (paused_)
+        return false;
+
+    // the frame of the session was rendered again
+    uint64_t n = session_->changes();
+    bool c = n != session_changes_;
+    session_changes_ = n;
+    return c;
+}
+
 void RenderSource::update(float dt)
 {
     static glm::mat4 projection = glm::ortho(-1.f, 1.f, 1.f, -1.f, -SCENE_DEPTH, 1.f);
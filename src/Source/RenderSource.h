@@ -49,8 +49,10 @@ public:
 protected:
 
     void init() override;
+    bool contentChanged() override;
     Session *session_;
     uint64_t runtime_;
+    uint64_t session_changes_;
 
     FrameBuffer *rendered_output_;
 
@@ -18,6 +18,11 @@
 **/
 
 #include <algorithm>
+#include <list>
+#include <map>
+#include <set>
+#include <mutex>
+#include <thread>
 
 #include <glib.h>
 #include <glm/ext/vector_float3.hpp>
@@ -34,7 +39,8 @@
 
 #include "SessionSource.h"
 
-SessionSource::SessionSource(uint64_t id) : Source(id), failed_(false), timer_(0), paused_(false)
+SessionSource::SessionSource(uint64_t id) : Source(id), failed_(false), timer_(0), paused_(false),
+    session_changes_(0)
 {
     session_ = new Session;
 
@@ -147,6 +153,18 @@ void SessionSource::setActive (bool on)
     }
 }
 
+bool SessionSource::contentChanged()
+{
+    if (session_ == nullptr)
+        return true;
+
+    // the frame of the session was rendered again
+    uint64_t n = session_->changes();
+    bool c = n != session_changes_;
+    session_changes_ = n;
+    return c;
+}
+
 void SessionSource::update(float dt)
 {
     Source::update(dt);
@@ -160,11 +178,20 @@ void SessionSource::update(float dt)
         timer_ += guint64(dt * 1000.f) * GST_USECOND;
     }
 
-    // update audio
+    updateAudio();
+    updateFailed();
+}
+
+void SessionSource::updateAudio()
+{
+    // audio of sources in session follows alpha of this source
     for (auto it = session_->begin(); it != session_->end(); ++it) {
         (*it)->setAudioVolumeFactor(Source::VOLUME_PARENT, blendingshader_->color.a);
     }
+}
 
+void SessionSource::updateFailed()
+{
     // manage sources which failed
     if ( !session_->failedSources().empty() ) {
 
@@ -247,7 +274,93 @@ bool SessionSource::playable () const
     return p;
 }
 
-SessionFileSource::SessionFileSource(uint64_t id) : SessionSource(id), path_(""), initialized_(false), wait_for_sources_(false)
+// Nested sessions shared by SessionFileSources, indexed by filename and level.
+// Sessions are loaded in threads which can create SessionFileSources:
+// access is locked, but never while waiting for a loader or deleting a session.
+struct SharedSession {
+    std::shared_future<Session *> loader;
+    std::list<SessionFileSource *> sources;
+    // sources updated since the last update of the session
+    std::set<SessionFileSource *> updated;
+};
+static std::map<std::string, SharedSession> shared_sessions_;
+static std::mutex shared_access_;
+
+// true if any of the sources of the shared session is active
+static bool shared_active(const SharedSession &shared)
+{
+    return std::any_of(shared.sources.begin(), shared.sources.end(),
+                       [](SessionFileSource *s){ return s->active(); });
+}
+
+// delete the session of a loader still running, once loaded
+// (never given to a source, its sources have no OpenGL resources yet)
+static void delete_loaded(std::shared_future<Session *> loader)
+{
+    Session *se = loader.get();
+    if (se)
+        delete se;
+}
+
+// remove a source from a shared session;
+// returns the session if it was the last source using it (to be deleted by caller)
+static Session *release_shared(const std::string &key, SessionFileSource *source)
+{
+    std::shared_future<Session *> loader;
+    bool last = false, on = false;
+    {
+        std::lock_guard<std::mutex> lock(shared_access_);
+        auto it = shared_sessions_.find(key);
+        if (it == shared_sessions_.end())
+            return nullptr;
+
+        it->second.sources.remove(source);
+        it->second.updated.erase(source);
+        loader = it->second.loader;
+        last = it->second.sources.empty();
+        if (last)
+            shared_sessions_.erase(it);
+        else
+            on = shared_active(it->second);
+    }
+
+    bool loaded = loader.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+
+    // last source: give away the session, or delete it in background when loaded
+    if (last) {
+        if (loaded)
+            return loader.get();
+        std::thread(delete_loaded, loader).detach();
+        return nullptr;
+    }
+
+    // keep the session active only if one of its other sources is active
+    if (loaded && loader.get())
+        loader.get()->setActive(on);
+
+    return nullptr;
+}
+
+// true if the source is the first of the shared session to be updated in this frame,
+// i.e. the first source updated again since the previous update of the session
+static bool first_updated(const std::string &key, SessionFileSource *source)
+{
+    std::lock_guard<std::mutex> lock(shared_access_);
+    auto it = shared_sessions_.find(key);
+    if (it == shared_sessions_.end())
+        return true;
+
+    std::set<SessionFileSource *> &updated = it->second.updated;
+    bool first = updated.empty() || updated.count(source) > 0;
+    if (first)
+        updated.clear();
+    updated.insert(source);
+
+    return first;
+}
+
+SessionFileSource::SessionFileSource(uint64_t id) : SessionSource(id), path_(""), level_(0),
+    initialized_(false), wait_for_sources_(false), shared_(false)
 {
     // specific node for transition view
     groups_[View::TRANSITION]->scale_ = glm::vec3(0.1f, 0.1f, 1.f);
@@ -294,14 +407,34 @@ SessionFileSource::SessionFileSource(uint64_t id) : SessionSource(id), path_("")
 
 }
 
-void SessionFileSource::load(const std::string &p, uint level)
+SessionFileSource::~SessionFileSource()
 {
-    path_ = p;
+    // delete or release session
+    unload();
+}
 
-    // delete session
-    if (session_)
+void SessionFileSource::unload()
+{
+    if ( !shared_key_.empty() ) {
+        // delete shared session only if no other source uses it
+        Session *se = release_shared(shared_key_, this);
+        if (se)
+            delete se;
+        shared_key_.clear();
+    }
+    else if (session_)
         delete session_;
+
     session_ = nullptr;
+}
+
+void SessionFileSource::load(const std::string &p, uint level)
+{
+    path_ = p;
+    level_ = level;
+
+    // delete or release session
+    unload();
 
     // reset renderbuffer_
     if (renderbuffer_)
@@ -314,9 +447,22 @@ void SessionFileSource::load(const std::string &p, uint level)
         session_ = new Session;
         Log::Warning("Empty Session filename provided.");
     }
+    else if ( shared_ ) {
+        // get the shared session of this file, or load it if not already loaded
+        shared_key_ = path_ + "@" + std::to_string(level);
+        std::lock_guard<std::mutex> lock(shared_access_);
+        auto it = shared_sessions_.find(shared_key_);
+        if (it == shared_sessions_.end()) {
+            it = shared_sessions_.emplace(shared_key_, SharedSession()).first;
+            it->second.loader = std::async(std::launch::async, Session::load, path_, level).share();
+            Log::Notify("Opening '%s'...", p.c_str());
+        }
+        it->second.sources.push_back(this);
+        sessionLoader_ = it->second.loader;
+    }
     else {
         // launch a thread to load the session file
-        sessionLoader_ = std::async(std::launch::async, Session::load, path_, level);
+        sessionLoader_ = std::async(std::launch::async, Session::load, path_, level).share();
         Log::Notify("Opening '%s'...", p.c_str());
     }
 
@@ -325,9 +471,186 @@ void SessionFileSource::load(const std::string &p, uint level)
     ready_ = false;
 }
 
+void SessionFileSource::load(Session *session, const std::string &p)
+{
+    if (session == nullptr) {
+        load(p);
+        return;
+    }
+
+    path_ = p;
+    level_ = 0;
+
+    // delete or release session
+    unload();
+
+    // reset renderbuffer_
+    if (renderbuffer_)
+        delete renderbuffer_;
+    renderbuffer_ = nullptr;
+
+    // no loader needed: init will use the session given
+    session_ = session;
+
+    // will be ready after init and one frame rendered
+    initialized_ = false;
+    ready_ = false;
+}
+
 void SessionFileSource::reload()
 {
-    load(path_);
+    load(path_, level_);
+}
+
+void SessionFileSource::setShared(bool on)
+{
+    if (on == shared_)
+        return;
+
+    shared_ = on;
+
+    // reload the session file in the new mode
+    if ( !path_.empty() )
+        load(path_, level_);
+}
+
+size_t SessionFileSource::sharedCount() const
+{
+    std::lock_guard<std::mutex> lock(shared_access_);
+    auto it = shared_sessions_.find(shared_key_);
+    if (it != shared_sessions_.end())
+        return it->second.sources.size();
+    return 0;
+}
+
+bool SessionFileSource::leading() const
+{
+    std::lock_guard<std::mutex> lock(shared_access_);
+    auto it = shared_sessions_.find(shared_key_);
+    if (it == shared_sessions_.end())
+        return true;
+
+    // lead by the first source playing, or by the first source if none is playing
+    for (auto s = it->second.sources.begin(); s != it->second.sources.end(); ++s) {
+        if ( (*s)->active() && (*s)->playing() )
+            return *s == this;
+    }
+    return it->second.sources.front() == this;
+}
+
+void SessionFileSource::update(float dt)
+{
+    if ( shared_key_.empty() || session_ == nullptr ) {
+        SessionSource::update(dt);
+        return;
+    }
+
+    Source::update(dt);
+    if (active_ && !paused_)
+        timer_ += guint64(dt * 1000.f) * GST_USECOND;
+
+    // a shared session is updated (and rendered) only once per frame, by the first
+    // of its sources to be updated, so that all its sources render the same frame
+    if ( first_updated(shared_key_, this) ) {
+        if ( session_->active() && !paused_ )
+            session_->update(dt);
+        updateFailed();
+    }
+
+    // the audio of a shared session follows the alpha of its leading source only
+    if ( leading() )
+        updateAudio();
+}
+
+void SessionFileSource::setActive (bool on)
+{
+    if ( shared_key_.empty() ) {
+        SessionSource::setActive(on);
+        return;
+    }
+
+    bool was_active = active_;
+
+    Source::setActive(on);
+
+    // shared session is active if any of its sources is active
+    if (session_ && active_ != was_active ) {
+        bool any_active = false;
+        {
+            std::lock_guard<std::mutex> lock(shared_access_);
+            auto it = shared_sessions_.find(shared_key_);
+            if (it != shared_sessions_.end())
+                any_active = shared_active(it->second);
+        }
+
+        // option to automatically replay when the sources are disabled
+        if (!any_active && replay_on_disable_) {
+            replay();
+            session_->update(0.f);
+        }
+
+        session_->setActive(any_active);
+    }
+}
+
+void SessionFileSource::play (bool on)
+{
+    // all sources sharing the session play or pause together
+    {
+        std::lock_guard<std::mutex> lock(shared_access_);
+        auto it = shared_sessions_.find(shared_key_);
+        if (it != shared_sessions_.end()) {
+            for (auto s = it->second.sources.begin(); s != it->second.sources.end(); ++s)
+                (*s)->paused_ = !on;
+        }
+    }
+
+    SessionSource::play(on);
+}
+
+Session *SessionFileSource::detach()
+{
+    if ( shared_key_.empty() )
+        return SessionSource::detach();
+
+    Session *giveaway = nullptr;
+
+    if ( session_ != nullptr ) {
+        // hand over the shared session
+        std::list<SessionFileSource *> others;
+        {
+            std::lock_guard<std::mutex> lock(shared_access_);
+            auto it = shared_sessions_.find(shared_key_);
+            if (it != shared_sessions_.end()) {
+                others = it->second.sources;
+                others.remove(this);
+                shared_sessions_.erase(it);
+            }
+        }
+        giveaway = session_;
+
+        // the other sources sharing it load the file again, in background
+        for (auto s = others.begin(); s != others.end(); ++s)
+            (*s)->load((*s)->path_, (*s)->level_);
+    }
+    else
+        // session not loaded yet: nothing to give away
+        release_shared(shared_key_, this);
+
+    shared_key_.clear();
+    if (giveaway == nullptr)
+        giveaway = new Session;
+
+    // work on a new session
+    session_ = new Session;
+
+    // un-ready
+    ready_ = false;
+
+    // ask to delete me
+    failed_ = true;
+
+    return giveaway;
 }
 
 void SessionFileSource::init()
@@ -353,7 +676,8 @@ void SessionFileSource::init()
             ++View::need_deep_update_;
 
             // update to draw framebuffer
-            session_->update(dt_);
+            if ( leading() )
+                session_->update(dt_);
 
             // if all sources are ready, done with initialization!
             auto unintitializedsource = std::find_if_not(session_->begin(), session_->end(), Source::isInitialized);
@@ -370,7 +694,8 @@ void SessionFileSource::init()
             session_->setResolution( session_->config(View::RENDERING)->scale_ );
 
             // update to draw framebuffer
-            session_->update(dt_);
+            if ( leading() )
+                session_->update(dt_);
 
             // get the texture index from framebuffer of session, apply it to the surface
             texturesurface_->setTextureIndex( session_->frame()->texture() );
@@ -400,7 +725,10 @@ void SessionFileSource::init()
         // request deep update to reorder session_
         ++View::need_deep_update_;
         // run update to redraw framebuffer (after reorder)
-        session_->update(dt_);
+        if ( leading() )
+            session_->update(dt_);
+        if ( !shared_key_.empty() )
+            Log::Info("Session %s shared by %d sources.", std::to_string(session_->id()).c_str(), (int) sharedCount());
     }
 }
 
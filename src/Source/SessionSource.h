@@ -22,32 +22,50 @@ public:
     Failure failed () const override;
     uint texture () const override;
 
-    Session *detach();
+    virtual Session *detach();
     inline Session *session() const { return session_; }
 
 protected:
 
+    bool contentChanged() override;
+    void updateAudio();
+    void updateFailed();
     Session *session_;
     std::atomic<bool> failed_;
     guint64 timer_;
     bool paused_;
+    uint64_t session_changes_;
 };
 
 class SessionFileSource : public SessionSource
 {
 public:
     SessionFileSource(uint64_t id = 0);
+    ~SessionFileSource();
 
     // implementation of source API
     void accept (Visitor& v) override;
     void render() override;
+    void update (float dt) override;
+    void setActive (bool on) override;
+    void play (bool on) override;
+    Session *detach() override;
 
     // SessionFile Source specific interface
     void load(const std::string &p = "", uint level = 0);
+    // use a session already loaded from file p (e.g. cued by Mixer)
+    void load(Session *session, const std::string &p);
     void reload () override;
 
     inline std::string path() const { return path_; }
 
+    // shared mode: SessionFileSources of the same file share
+    // a single nested session, updated and rendered once per frame
+    // (play, pause and fading apply to all sources sharing it)
+    void setShared (bool on);
+    inline bool shared() const { return shared_; }
+    size_t sharedCount() const;
+
     glm::ivec2 icon() const override;
     std::string info() const override;
 
@@ -56,9 +74,17 @@ protected:
     void init() override;
 
     std::string path_;
+    uint level_;
     bool initialized_;
     bool wait_for_sources_;
-    std::future<Session *> sessionLoader_;
+    std::shared_future<Session *> sessionLoader_;
+
+    bool shared_;
+    std::string shared_key_;
+    // first source active and playing, or first source if none
+    // (its alpha sets the volume of the shared session)
+    bool leading() const;
+    void unload();
 };
 
 class SessionGroupSource : public SessionSource
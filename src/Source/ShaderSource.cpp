@@ -56,6 +56,20 @@ void ShaderSource::setResolution(glm::vec3 resolution)
         delete background_;
 
     background_ = new FrameBuffer(resolution);
+
+    // new native resolution of the shader
+    native_resolution_ = resolution;
+    lod_ = 1.f;
+}
+
+void ShaderSource::applyLevelOfDetail()
+{
+    // the shader runs at the resolution of the background,
+    // and the render buffer follows the resolution of the filter
+    if (background_ && native_resolution_.x > 0.f) {
+        glm::vec3 res = glm::max( glm::round(native_resolution_ * lod_), glm::vec3(2.f, 2.f, 0.f) );
+        background_->resize(res);
+    }
 }
 
 void ShaderSource::setProgram(const FilteringProgram &f)
@@ -179,6 +193,18 @@ guint64 ShaderSource::playtime () const
     return 0;
 }
 
+SourceIdList ShaderSource::dependencies() const
+{
+    SourceIdList ids = Source::dependencies();
+
+    // textures of shader program
+    auto textures = filter_->program().textures();
+    for (auto t = textures.begin(); t != textures.end(); ++t)
+        ids.push_back( t->second );
+
+    return ids;
+}
+
 uint ShaderSource::texture() const
 {
     return filter_->texture();
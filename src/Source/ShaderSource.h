@@ -29,6 +29,7 @@ public:
     glm::ivec2 icon() const override;
     std::string info() const override;
     bool texturePostProcessed() const override { return true; }
+    SourceIdList dependencies() const override;
 
     // setup shader
     void setResolution(glm::vec3 resolution);
@@ -40,6 +41,7 @@ public:
 protected:
 
     void init() override;
+    void applyLevelOfDetail() override;
 
     // control
     bool paused_;
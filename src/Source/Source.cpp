@@ -24,6 +24,7 @@
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "defines.h"
+#include "Settings.h"
 #include "FrameBuffer.h"
 #include "Scene/Decorations.h"
 #include "Resource.h"
@@ -117,8 +118,8 @@ SourceCore& SourceCore::operator= (SourceCore const& other)
 
 
 Source::Source(uint64_t id) : SourceCore(), id_(id), ready_(false), symbol_(nullptr),
-    active_(true), locked_(false), need_update_(SourceUpdate_None), dt_(16.f), 
-    workspace_(WORKSPACE_CENTRAL), replay_on_disable_(false)
+    active_(true), locked_(false), need_update_(SourceUpdate_None), changed_(true), state_(0), dt_(16.f), 
+    workspace_(WORKSPACE_CENTRAL), replay_on_disable_(false), resident_(true), callbacks_pending_(false)
 {
     // create unique id
     if (id_ == 0)
@@ -388,6 +389,9 @@ Source::Source(uint64_t id) : SourceCore(), id_(id), ready_(false), symbol_(null
 
     // will be created at init
     renderbuffer_   = nullptr;
+    native_resolution_ = glm::vec3(0.f);
+    lod_            = 1.f;
+    lod_footprint_  = 0.f;
     rendersurface_  = nullptr;
     mixingsurface_  = nullptr;
     activesurface_  = nullptr;
@@ -409,6 +413,11 @@ Source::~Source()
 {
     // clear and delete callbacks
     access_callbacks_.lock();
+    for (auto iter=pending_callbacks_.begin(); iter != pending_callbacks_.end(); )  {
+        SourceCallback *callback = iter->first;
+        iter = pending_callbacks_.erase(iter);
+        delete callback;
+    }
     for (auto iter=update_callbacks_.begin(); iter != update_callbacks_.end(); )  {
         SourceCallback *callback = *iter;
         iter = update_callbacks_.erase(iter);
@@ -575,6 +584,10 @@ void Source::attach(FrameBuffer *renderbuffer)
         delete renderbuffer_;
     renderbuffer_ = renderbuffer;
 
+    // new native resolution: level of detail to be adapted
+    native_resolution_ = renderbuffer_->resolution();
+    lod_ = 1.f;
+
     // create rendersurface_ only once
     if ( rendersurface_ == nullptr) {
         // create the surfaces to draw the frame buffer in the views
@@ -686,6 +699,15 @@ void Source::setActive (float threshold)
     setActive( glm::length( glm::vec2(groups_[View::MIXING]->translation_) ) < threshold );
 }
 
+void Source::setResident (bool on)
+{
+    if (resident_ != on) {
+        resident_ = on;
+        // level of detail is adapted at next update
+        need_update_ |= Source::SourceUpdate_Render;
+    }
+}
+
 void Source::setLocked (bool on)
 {
     locked_ = on;
@@ -761,20 +783,22 @@ void Source::call(SourceCallback *callback, bool override)
 {
     if (callback != nullptr) {
 
-        // lock access to callbacks list
+        // lock access to pending callbacks list
         access_callbacks_.lock();
 
-        // if operation should override previous callbacks of same type
+        // if operation should override previous callbacks of same type,
+        // the callbacks of the same type still pending will never run:
+        // coalesce repeated calls in the same frame into the last one
         if (override) {
-            // finish all callbacks of the same type
-            for (auto iter=update_callbacks_.begin(); iter != update_callbacks_.end(); ++iter) {
-                if ( callback->type() == (*iter)->type() )
-                    (*iter)->finish();
+            for (auto iter=pending_callbacks_.begin(); iter != pending_callbacks_.end(); ++iter) {
+                if ( callback->type() == iter->first->type() )
+                    iter->first->finish();
             }
         }
 
-        // allways add the given callback to list of callbacks
-        update_callbacks_.push_back(callback);
+        // allways add the given callback to list of pending callbacks
+        pending_callbacks_.push_back( {callback, override} );
+        callbacks_pending_ = true;
 
         // release access to callbacks list
         access_callbacks_.unlock();
@@ -794,6 +818,13 @@ void Source::finish(SourceCallback *callback)
         if (cb != update_callbacks_.end())
             // set found callback to finish state
             (*cb)->finish();
+        else {
+            // or a callback pending
+            for (auto iter=pending_callbacks_.begin(); iter != pending_callbacks_.end(); ++iter) {
+                if ( iter->first == callback )
+                    callback->finish();
+            }
+        }
 
         // release access to callbacks list
         access_callbacks_.unlock();
@@ -802,10 +833,41 @@ void Source::finish(SourceCallback *callback)
 
 void Source::updateCallbacks(float dt)
 {
-    // lock access to callbacks list
-    access_callbacks_.lock();
+    // merge pending callbacks, only locking if some were added
+    if ( callbacks_pending_ ) {
+
+        // lock access to pending callbacks list
+        access_callbacks_.lock();
+
+        for (auto iter=pending_callbacks_.begin(); iter != pending_callbacks_.end(); ) {
+            SourceCallback *callback = iter->first;
+
+            // pending callback was overriden before it could start: discard
+            if (callback->finished()) {
+                iter = pending_callbacks_.erase(iter);
+                delete callback;
+                continue;
+            }
+
+            // finish all running callbacks of the same type
+            if (iter->second) {
+                for (auto cb=update_callbacks_.begin(); cb != update_callbacks_.end(); ++cb) {
+                    if ( callback->type() == (*cb)->type() )
+                        (*cb)->finish();
+                }
+            }
+
+            // move pending callback to list of callbacks
+            update_callbacks_.push_back(callback);
+            iter = pending_callbacks_.erase(iter);
+        }
+        callbacks_pending_ = false;
+
+        // release access to pending callbacks list
+        access_callbacks_.unlock();
+    }
 
-    // call callback functions
+    // call callback functions (list is only accessed in this thread)
     for (auto iter=update_callbacks_.begin(); iter != update_callbacks_.end(); )
     {
         SourceCallback *callback = *iter;
@@ -823,9 +885,6 @@ void Source::updateCallbacks(float dt)
         else
             ++iter;
     }
-
-    // release access to callbacks list
-    access_callbacks_.unlock();
 }
 
 CloneSource *Source::clone(uint64_t id)
@@ -852,6 +911,9 @@ void Source::update(float dt)
     // keep delta-t
     dt_ = dt;
 
+    // any update requested changes the frame
+    changed_ = need_update_ != SourceUpdate_None;
+
     // if update is possible
     if (renderbuffer_ && mixingsurface_ && maskbuffer_)
     {
@@ -1019,6 +1081,12 @@ void Source::update(float dt)
                 blendingshader_->secondary_texture = maskbuffer_->texture();
             }
         }
+        else if (maskshader_->mode == MaskShader::SOURCE && masksource_->connected()) {
+            // frame of mask source can be re-created (e.g. level of detail changed)
+            Source *ref_source = masksource_->source();
+            if (ref_source != nullptr && ref_source->ready())
+                blendingshader_->secondary_texture = ref_source->frame()->texture();
+        }
 
         // update audio if requested:
         if (need_update_ & SourceUpdate_Audio) {
@@ -1042,6 +1110,135 @@ void Source::update(float dt)
 
 }
 
+SourceIdList Source::dependencies() const
+{
+    SourceIdList ids;
+
+    // source used as mask
+    if ( maskshader_->mode == MaskShader::SOURCE && masksource_->connected() )
+        ids.push_back( masksource_->id() );
+
+    return ids;
+}
+
+void Source::updateChanged()
+{
+    // not rendered yet
+    if ( !ready_ || renderbuffer_ == nullptr ) {
+        changed_ = true;
+        return;
+    }
+
+    // new content (e.g. new frame of a video)
+    if ( contentChanged() )
+        changed_ = true;
+
+    // content of the source used as mask
+    if ( maskshader_->mode == MaskShader::SOURCE && masksource_->connected() ) {
+        Source *ref_source = masksource_->source();
+        if ( ref_source != nullptr && ref_source->changed() )
+            changed_ = true;
+    }
+
+    // state of rendering
+    uint64_t h = BASETOOLKIT_HASH_SEED;
+    BaseToolkit::hash(h, renderingshader_);
+    BaseToolkit::hash(h, texturesurface_->shader()->color);
+    BaseToolkit::hash(h, texturesurface_->shader()->iTransform);
+    if ( renderingshader_ == processingshader_ ) {
+        BaseToolkit::hash(h, processingshader_->color);
+        BaseToolkit::hash(h, processingshader_->brightness);
+        BaseToolkit::hash(h, processingshader_->contrast);
+        BaseToolkit::hash(h, processingshader_->saturation);
+        BaseToolkit::hash(h, processingshader_->hueshift);
+        BaseToolkit::hash(h, processingshader_->threshold);
+        BaseToolkit::hash(h, processingshader_->gamma);
+        BaseToolkit::hash(h, processingshader_->levels);
+        BaseToolkit::hash(h, processingshader_->nbColors);
+        BaseToolkit::hash(h, processingshader_->invert);
+    }
+    BaseToolkit::hash(h, renderbuffer_->texture());
+    BaseToolkit::hash(h, renderbuffer_->resolution());
+    BaseToolkit::hash(h, groups_[View::GEOMETRY]->crop_);
+
+    // state of composition in the rendering view
+    BaseToolkit::hash(h, groups_[View::RENDERING]->visible_);
+    BaseToolkit::hash(h, groups_[View::RENDERING]->translation_);
+    BaseToolkit::hash(h, groups_[View::RENDERING]->rotation_);
+    BaseToolkit::hash(h, groups_[View::RENDERING]->scale_);
+    BaseToolkit::hash(h, blendingshader_->color);
+    BaseToolkit::hash(h, blendingshader_->iTransform);
+    BaseToolkit::hash(h, blendingshader_->blending);
+    BaseToolkit::hash(h, blendingshader_->iNodes);
+    BaseToolkit::hash(h, blendingshader_->stipple);
+    BaseToolkit::hash(h, blendingshader_->premultiply);
+    BaseToolkit::hash(h, blendingshader_->secondary_texture);
+
+    if ( h != state_ ) {
+        state_ = h;
+        changed_ = true;
+    }
+}
+
+// lowest fraction of the native resolution rendered
+#define LOD_MIN 0.125f
+// margin to avoid switching back and forth between two levels
+#define LOD_HYSTERESIS 0.7f
+
+void Source::updateLevelOfDetail(glm::vec3 output)
+{
+    if (renderbuffer_ == nullptr)
+        return;
+
+    // height in output pixels of the render buffer, given GEOMETRY scale and crop
+    // (the cropped area of the source is rendered in the whole render buffer)
+    glm::vec3 s = glm::abs(groups_[View::GEOMETRY]->scale_);
+    glm::vec2 c = renderbuffer_->projectionSize();
+    lod_footprint_ = std::max(s.x * c.x, s.y * c.y) * output.y;
+
+    float lod = 1.f;
+    if ( Settings::application.render.level_of_detail && native_resolution_.y > 0.f ) {
+
+        // clones display the frame of this source: keep enough details for the largest
+        float needed = footprint() / native_resolution_.y;
+
+        // power of two levels; increase as soon as more details are needed,
+        // decrease only when much less than the lower level is needed
+        lod = lod_;
+        while ( lod < 1.f && needed > lod )
+            lod *= 2.f;
+        while ( lod > LOD_MIN && needed < lod * 0.5f * LOD_HYSTERESIS )
+            lod *= 0.5f;
+        lod = CLAMP(lod, LOD_MIN, 1.f);
+    }
+
+    // a source not resident keeps only a proxy at lowest resolution
+    if ( !resident_ )
+        lod = LOD_MIN;
+
+    if ( lod != lod_ ) {
+        lod_ = lod;
+        // NB: the render buffer is re-created at next render, in the same frame
+        applyLevelOfDetail();
+    }
+}
+
+float Source::footprint() const
+{
+    float f = lod_footprint_;
+    for (auto it = clones_.begin(); it != clones_.end(); ++it)
+        f = std::max(f, ((Source *) *it)->lod_footprint_);
+    return f;
+}
+
+void Source::applyLevelOfDetail()
+{
+    if (renderbuffer_ && native_resolution_.x > 0.f) {
+        glm::vec3 res = glm::max( glm::round(native_resolution_ * lod_), glm::vec3(2.f, 2.f, 0.f) );
+        renderbuffer_->resize(res);
+    }
+}
+
 FrameBuffer *Source::frame() const
 {
     if ( mode_ > Source::UNINITIALIZED && renderbuffer_)
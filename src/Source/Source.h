@@ -163,6 +163,23 @@ public:
     // a Source shall be updated before displayed (Mixing, Geometry and Layer)
     virtual void update (float dt);
 
+    // after update, detect if the frame of the source changed since last update
+    // (new content, or change of image processing, mask, geometry or blending)
+    void updateChanged ();
+    inline bool changed () const { return changed_; }
+
+    // ids of the sources which frames are used to update and render this source
+    // (e.g. mask source, origin of a clone, textures of a filter)
+    virtual SourceIdList dependencies () const;
+
+    // level of detail adapts the render resolution to the size of
+    // the source in the output (given resolution of the output)
+    void updateLevelOfDetail (glm::vec3 output);
+    inline float levelOfDetail () const { return lod_; }
+    // height in output pixels of the largest display of the source frame (incl. clones)
+    float footprint () const;
+    inline glm::vec3 nativeResolution () const { return native_resolution_; }
+
     // add callback to each update
     void call(SourceCallback *callback, bool override = false);
     void finish(SourceCallback *callback);
@@ -174,6 +191,11 @@ public:
     inline void setReplayOnDeactivate(bool on) { replay_on_disable_ = on; }
     inline bool replayOnDeactivate() const { return replay_on_disable_; }
 
+    // residency : a source not resident releases its decoder
+    // and renders a low resolution proxy of its frame
+    inline  bool resident () const { return resident_; }
+    virtual void setResident (bool on);
+
     // lock mode
     inline  bool locked () const { return locked_; }
     virtual void setLocked (bool on);
@@ -339,6 +361,13 @@ protected:
     FrameBuffer *renderbuffer_;
     void attach(FrameBuffer *renderbuffer);
 
+    // level of detail: fraction of the native resolution rendered
+    // (native resolution is the one of the renderbuffer attached)
+    float lod_;
+    float lod_footprint_;
+    glm::vec3 native_resolution_;
+    virtual void applyLevelOfDetail ();
+
     // the rendersurface draws the renderbuffer in the scene
     // It is associated to the rendershader for mixing effects
     FrameBufferMeshSurface *rendersurface_;
@@ -378,12 +407,19 @@ protected:
     bool  active_;
     bool  locked_;
     UpdateFlags   need_update_;
+    bool  changed_;
+    uint64_t state_;
+    virtual bool contentChanged () { return playing(); }
     float dt_;
     Workspace  workspace_;
     bool replay_on_disable_;
+    bool resident_;
 
-    // callbacks
+    // callbacks (pending callbacks are added by any thread, and
+    // merged into update callbacks in the update of the source)
     std::list<SourceCallback *> update_callbacks_;
+    std::list< std::pair<SourceCallback *, bool> > pending_callbacks_;
+    std::atomic<bool> callbacks_pending_;
     std::mutex access_callbacks_;
     void updateCallbacks(float dt);
 
@@ -86,7 +86,7 @@ std::string GenericStreamSource::info() const
     return "Gstreamer";
 }
 
-StreamSource::StreamSource(uint64_t id) : Source(id), stream_(nullptr)
+StreamSource::StreamSource(uint64_t id) : Source(id), stream_(nullptr), texture_updates_(0)
 {
 }
 
@@ -220,6 +220,18 @@ void StreamSource::update(float dt)
         stream_->update();
 }
 
+bool StreamSource::contentChanged()
+{
+    if ( stream_ == nullptr )
+        return true;
+
+    // a new frame was filled in the texture of the stream
+    guint64 n = stream_->textureUpdates();
+    bool c = n != texture_updates_;
+    texture_updates_ = n;
+    return c;
+}
+
 void StreamSource::accept(Visitor& v)
 {
     Source::accept(v);
@@ -47,8 +47,10 @@ public:
 
 protected:
     void init() override;
+    bool contentChanged() override;
 
     Stream *stream_;
+    guint64 texture_updates_;
 };
 
 /**
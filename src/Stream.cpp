@@ -57,10 +57,6 @@ Stream::Stream()
     failed_ = false;
     decoder_name_ = "";
 
-    // start index in frame_ stack
-    write_index_ = 0;
-    last_index_ = 0;
-
     // no PBO by default
     pbo_[0] = pbo_[1] = 0;
     pbo_size_ = 0;
@@ -71,6 +67,7 @@ Stream::Stream()
     // OpenGL texture
     textureindex_ = 0;
     textureinitialized_ = false;
+    texture_updates_ = 0;
 }
 
 Stream::~Stream()
@@ -426,17 +423,7 @@ void Stream::close()
     opened_ = false;
 
     // cleanup eventual remaining frame memory
-    for(guint i = 0; i < N_FRAME; ++i){
-        frame_[i].access.lock();
-        if (frame_[i].buffer) {
-            gst_buffer_unref(frame_[i].buffer);
-            frame_[i].buffer = NULL;
-        }
-        frame_[i].status = INVALID;
-        frame_[i].access.unlock();
-    }
-    write_index_ = 0;
-    last_index_ = 0;
+    frames_.clear();
 
     // clean up GST
     if (pipeline_ != nullptr) {
@@ -583,7 +570,7 @@ GstClockTime Stream::position()
     return position_;
 }
 
-void Stream::init_texture(guint index)
+void Stream::init_texture(GstBuffer *buf)
 {
     glActiveTexture(GL_TEXTURE0);
     if (textureindex_)
@@ -592,12 +579,12 @@ void Stream::init_texture(guint index)
     glBindTexture(GL_TEXTURE_2D, textureindex_);
     glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width_, height_);
 
-    // fill texture with frame at given index
-    if (frame_[index].buffer) {
+    // fill texture with frame
+    if (buf) {
         GstMapInfo map;
-        gst_buffer_map(frame_[index].buffer, &map, GST_MAP_READ);
+        gst_buffer_map(buf, &map, GST_MAP_READ);
         glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, map.data);
-        gst_buffer_unmap(frame_[index].buffer, &map);
+        gst_buffer_unmap(buf, &map);
     }
 
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -632,19 +619,21 @@ void Stream::init_texture(guint index)
 }
 
 
-void Stream::fill_texture(guint index)
+void Stream::fill_texture(GstBuffer *buf)
 {
+    ++texture_updates_;
+
     // is this the first frame ?
     if ( !textureinitialized_ || !textureindex_)
     {
         // initialize texture
-        // (this also fills the texture with frame at index)
-        init_texture(index);
+        // (this also fills the texture with frame)
+        init_texture(buf);
     }
     else {
         // Use GST mapping to access pointer to RGBA data
         GstMapInfo map;
-        gst_buffer_map(frame_[index].buffer, &map, GST_MAP_READ);
+        gst_buffer_map(buf, &map, GST_MAP_READ);
 
         // bind texture for writing
         glBindTexture(GL_TEXTURE_2D, textureindex_);
@@ -692,7 +681,7 @@ void Stream::fill_texture(guint index)
         glBindTexture(GL_TEXTURE_2D, 0);
 
         // unmap buffer to let it free
-        gst_buffer_unmap (frame_[index].buffer, &map);
+        gst_buffer_unmap (buf, &map);
     }
 }
 
@@ -729,63 +718,36 @@ void Stream::update()
     if (single_frame_ && textureinitialized_)
         return;
 
-    // local variables before trying to update
-    guint read_index = 0;
     bool need_loop = false;
 
-    // locked access to current index
-    index_lock_.lock();
-    // get the last frame filled from fill_frame()
-    read_index = last_index_;
-    // Do NOT miss and jump directly to a pre-roll
-    for (guint i = 0; i < N_FRAME; ++i) {
-        if (frame_[i].status == PREROLL) {
-            read_index = i;
-            break;
-        }
-    }
-    // unlock access to index change
-    index_lock_.unlock();
-
-    // lock frame while reading it
-    frame_[read_index].access.lock();
-
-    // do not fill a frame twice
-    if (frame_[read_index].status != INVALID ) {
+    // get the last frame filled from fill_frame() (never misses a pre-roll)
+    FrameSlots::Frame frame;
+    if ( frames_.pop(frame) ) {
 
         // is this an End-of-Stream frame ?
-        if (frame_[read_index].status == EOS )
+        if (frame.status == FrameSlots::EOS )
         {
-            // will execute seek command below (after unlock)
+            // will execute seek command below
             need_loop = true;
         }
         // otherwise just fill non-empty SAMPLE or PREROLL
-        else if (frame_[read_index].is_new)
+        else
         {
-            // fill the texture with the frame at reading index
-            fill_texture(read_index);
+            // fill the texture with the frame
+            fill_texture(frame.buffer);
 
             // double update for pre-roll frame and dual PBO (ensure frame is displayed now)
             // also double-fill if we need to refresh PBOs after resuming a live source
-            if (pbo_size_ > 0 && (frame_[read_index].status == PREROLL || need_pbo_refresh_)) {
-                fill_texture(read_index);
+            if (pbo_size_ > 0 && (frame.status == FrameSlots::PREROLL || need_pbo_refresh_)) {
+                fill_texture(frame.buffer);
                 need_pbo_refresh_ = false;  // clear the flag after refresh
             }
 
-            // free frame
-            frame_[read_index].is_new = false;
+            // we just displayed a vframe : set position time to frame PTS
+            position_ = frame.position;
         }
-
-        // we just displayed a vframe : set position time to frame PTS
-        position_ = frame_[read_index].position;
-
-        // avoid reading it again
-        frame_[read_index].status = INVALID;
     }
 
-    // unkock frame after reading it
-    frame_[read_index].access.unlock();
-
     if (need_loop) {
         // stop on end of stream
         play(false);
@@ -804,58 +766,21 @@ double Stream::updateFrameRate() const
 
 // CALLBACKS
 
-bool Stream::fill_frame(GstBuffer *buf, FrameStatus status)
+bool Stream::fill_frame(GstBuffer *buf, FrameSlots::Status status)
 {
 //    Log::Info("Stream fill frame");
 
-    // Do NOT overwrite an unread EOS
-    if ( frame_[write_index_].status == EOS )
-        write_index_ = (write_index_ + 1) % N_FRAME;
-
-    // lock access to frame
-    frame_[write_index_].access.lock();
-
-    // always empty frame before filling it again
-    if (frame_[write_index_].buffer) {
-        gst_buffer_unref(frame_[write_index_].buffer);
-        frame_[write_index_].buffer = NULL;
-    }
-
-    // accept status of frame received
-    frame_[write_index_].status = status;
-
     // a buffer is given (not EOS)
-    if (buf != NULL) {
-
-        // copy the buffer in the frame
-        frame_[write_index_].buffer = gst_buffer_copy(buf);
-
-        // indicate to update loop that buffer is new
-        frame_[write_index_].is_new = true;
-
-        // set presentation time stamp
-        frame_[write_index_].position = buf->pts;
-    }
-    // else; null buffer for EOS: give a position
+    if (buf != NULL)
+        frames_.push(buf, status);
+    // else; null buffer for EOS
     else {
-        frame_[write_index_].status = EOS;
+        frames_.push(NULL, FrameSlots::EOS);
 #ifdef STREAM_DEBUG
         Log::Info("Stream %s Reached End Of Stream", std::to_string(id_).c_str());
 #endif
     }
 
-    // unlock access to frame
-    frame_[write_index_].access.unlock();
-
-    // lock access to change current index (very quick)
-    index_lock_.lock();
-    // indicate update() that this is the last frame filled (and unlocked)
-    last_index_ = write_index_;
-    // unlock access to index change
-    index_lock_.unlock();
-    // for writing, we will access the next in stack
-    write_index_ = (write_index_ + 1) % N_FRAME;
-
     // calculate actual FPS of update
     timecount_.tic();
 
@@ -866,7 +791,7 @@ void Stream::callback_end_of_stream (GstAppSink *, gpointer p)
 {
     Stream *m = static_cast<Stream *>(p);
     if (m && m->opened_) {
-        m->fill_frame(NULL, Stream::EOS);
+        m->fill_frame(NULL, FrameSlots::EOS);
     }
 }
 
@@ -887,7 +812,7 @@ GstFlowReturn Stream::callback_new_preroll (GstAppSink *sink, gpointer p)
             GstBuffer *buf = gst_sample_get_buffer (sample);
 
             // fill frame from buffer
-            if ( !m->fill_frame(buf, Stream::PREROLL) )
+            if ( !m->fill_frame(buf, FrameSlots::PREROLL) )
                 ret = GST_FLOW_ERROR;
         }
     }
@@ -921,7 +846,7 @@ GstFlowReturn Stream::callback_new_sample (GstAppSink *sink, gpointer p)
             GstBuffer *buf = gst_sample_get_buffer (sample) ;
 
             // fill frame with buffer
-            if ( !m->fill_frame(buf, Stream::SAMPLE) )
+            if ( !m->fill_frame(buf, FrameSlots::SAMPLE) )
                 ret = GST_FLOW_ERROR;
         }
     }
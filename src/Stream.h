@@ -11,10 +11,11 @@
 #include <gst/pbutils/pbutils.h>
 #include <gst/app/gstappsink.h>
 
+#include "FrameSlots.h"
+
 // Forward declare classes referenced
 class Visitor;
 
-#define N_FRAME 3
 #define TIMEOUT 10
 
 struct StreamInfo {
@@ -139,6 +140,11 @@ public:
      * Must be called in OpenGL context
      * */
     guint texture() const;
+    /**
+     * Get the number of frames filled in the texture
+     * (changes when a new frame is displayed)
+     * */
+    inline guint64 textureUpdates() const { return texture_updates_; }
     /**
      * Get the name of the decoder used,
      * return 'software' if no hardware decoder is used
@@ -166,6 +172,7 @@ protected:
     uint64_t id_;
     std::string description_;
     guint textureindex_;
+    guint64 texture_updates_;
 
     // general properties of media
     guint width_;
@@ -197,32 +204,8 @@ protected:
     };
     TimeCounter timecount_;
 
-    // frame stack
-    typedef enum  {
-        SAMPLE = 0,
-        PREROLL = 1,
-        EOS = 2,
-        INVALID = 3
-    } FrameStatus;
-
-    struct Frame {
-        GstBuffer *buffer;
-        FrameStatus status;
-        bool is_new;
-        GstClockTime position;
-        std::mutex access;
-
-        Frame() {
-            buffer = NULL;
-            is_new = false;
-            status = INVALID;
-            position = GST_CLOCK_TIME_NONE;
-        }
-    };
-    Frame frame_[N_FRAME];
-    guint write_index_;
-    guint last_index_;
-    std::mutex index_lock_;
+    // frames passed from streaming thread to update
+    FrameSlots frames_;
 
     // for PBO
     guint pbo_[2];
@@ -237,9 +220,9 @@ protected:
 
     // gst frame filling
     bool textureinitialized_;
-    void init_texture(guint index);
-    void fill_texture(guint index);
-    bool fill_frame(GstBuffer *buf, FrameStatus status);
+    void init_texture(GstBuffer *buf);
+    void fill_texture(GstBuffer *buf);
+    bool fill_frame(GstBuffer *buf, FrameSlots::Status status);
     std::condition_variable initialized_;
     static void timeout_initialize(Stream *str);
 
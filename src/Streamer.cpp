@@ -40,10 +40,12 @@
 #include "Settings.h"
 #include "Toolkit/GstToolkit.h"
 #include "Toolkit/SystemToolkit.h"
+#include "Toolkit/BaseToolkit.h"
 #include "Log.h"
 #include "Connection.h"
 #include "Toolkit/NetworkToolkit.h"
 #include "FrameGrabbing.h"
+#include "FrameRing.h"
 
 #include "Streamer.h"
 
@@ -76,6 +78,8 @@ void Streaming::RequestListener::ProcessMessage( const osc::ReceivedMessage& m,
             osc::ReceivedMessage::const_iterator arg = m.ArgumentsBegin();
             int reply_to_port = (arg++)->AsInt32();
             const char *client_name = (arg++)->AsString();
+            // optional: client can read frames from a shared memory ring
+            bool client_ring = arg != m.ArgumentsEnd() && (arg++)->AsBool();
             if (Streaming::manager().enabled()) {
                 // default proposed protocol to stream
                 NetworkToolkit::StreamProtocol protocol = NetworkToolkit::DEFAULT;
@@ -89,7 +93,7 @@ void Streaming::RequestListener::ProcessMessage( const osc::ReceivedMessage& m,
                         protocol = NetworkToolkit::UDP_H264;
                 }
                 // add stream answering to request
-                Streaming::manager()._addStream(sender, reply_to_port, client_name, protocol);
+                Streaming::manager()._addStream(sender, reply_to_port, client_name, protocol, client_ring);
             }
             else
                 Streaming::manager()._refuseStream(sender, reply_to_port);
@@ -163,8 +167,10 @@ std::vector<std::string> Streaming::listStreams()
 
     streamers_lock_.lock();
     std::vector<VideoStreamer *>::const_iterator sit = streamers_.begin();
-    for (; sit != streamers_.end(); ++sit)
-        ls.push_back( (*sit)->info() );
+    for (; sit != streamers_.end(); ++sit) {
+        std::vector<std::string> c = (*sit)->clients();
+        ls.insert(ls.end(), c.begin(), c.end());
+    }
     streamers_lock_.unlock();
 
     return ls;
@@ -195,20 +201,17 @@ NetworkToolkit::StreamConfig Streaming::removeStream(const std::string &sender,
     // get ip of sender
     std::string sender_ip = sender.substr(0, sender.find_last_of(":"));
 
-    // parse the list for a streamers matching IP and port
+    // parse the list for a streamer sending to IP and port
     streamers_lock_.lock();
     std::vector<VideoStreamer *>::const_iterator sit = streamers_.begin();
     for (; sit != streamers_.end(); ++sit){
-        NetworkToolkit::StreamConfig config = (*sit)->config_;
-        if (config.client_address.compare(sender_ip) == 0 && config.port == port ) {
-#ifdef STREAMER_DEBUG
-            Log::Info("Ending streaming to %s:%d", config.client_address.c_str(), config.port);
-#endif
-            // match: stop this streamer
-            removed = config;
-            (*sit)->stop();
-            // remove from list
-            streamers_.erase(sit);
+        if ( (*sit)->removeClient(sender_ip, port, &removed) ) {
+            // match: stop this streamer if it was the last client
+            if ( (*sit)->numClients() < 1 ) {
+                (*sit)->stop();
+                // remove from list
+                streamers_.erase(sit);
+            }
             break;
         }
     }
@@ -218,16 +221,12 @@ NetworkToolkit::StreamConfig Streaming::removeStream(const std::string &sender,
 
 void Streaming::removeStreams(const std::string &clientname)
 {
-    // remove all streamers matching given IP
+    // remove all clients matching given name
     streamers_lock_.lock();
     std::vector<VideoStreamer *>::const_iterator sit = streamers_.begin();
     while ( sit != streamers_.end() ){
-        NetworkToolkit::StreamConfig config = (*sit)->config_;
-        if (config.client_name.compare(clientname) == 0) {
-#ifdef STREAMER_DEBUG
-            Log::Info("Ending streaming to %s:%d", config.client_address.c_str(), config.port);
-#endif
-            // match: stop this streamer
+        // match: stop this streamer if no client remains
+        if ( (*sit)->removeClients(clientname) > 0 && (*sit)->numClients() < 1 ) {
             (*sit)->stop();
             // remove from list
             sit = streamers_.erase(sit);
@@ -296,18 +295,13 @@ void Streaming::addStream(const std::string &sender, int port,
     conf.height = FrameGrabbing::manager().height();
     conf.protocol = Settings::application.stream_protocol > 0 ? NetworkToolkit::UDP_H264 : NetworkToolkit::UDP_JPEG;
 
-    // create streamer & remember it
-    VideoStreamer *streamer = new VideoStreamer(conf);
-    streamers_lock_.lock();
-    streamers_.push_back(streamer);
-    streamers_lock_.unlock();
-
-    // start streamer
-    FrameGrabbing::manager().add(streamer);
+    // start streaming
+    _startStream(conf);
 }
 
 void Streaming::_addStream(const std::string &sender, int reply_to,
-                          const std::string &clientname, NetworkToolkit::StreamProtocol protocol)
+                          const std::string &clientname, NetworkToolkit::StreamProtocol protocol,
+                          bool client_ring)
 {
     // get ip of client
     std::string sender_ip = sender.substr(0, sender.find_last_of(":"));
@@ -329,9 +323,9 @@ void Streaming::_addStream(const std::string &sender, int reply_to,
     if (protocol == NetworkToolkit::DEFAULT) {
         // without indication, the JPEG stream is default
         conf.protocol = NetworkToolkit::UDP_JPEG;
-        // on localhost sharing, use SHARED MEMORY RAW
+        // on localhost sharing, use SHARED MEMORY RING if client supports it, RAW otherwise
         if ( NetworkToolkit::is_host_ip(conf.client_address) )
-            conf.protocol = NetworkToolkit::SHM_RAW;
+            conf.protocol = client_ring && FrameRing::available() ? NetworkToolkit::SHM_RING : NetworkToolkit::SHM_RAW;
         // for non-localhost, if low bandwidth is requested, use H264 codec
         else if (Settings::application.stream_protocol > 0)
             conf.protocol = NetworkToolkit::UDP_H264;
@@ -357,9 +351,24 @@ void Streaming::_addStream(const std::string &sender, int reply_to,
     Log::Info("Starting streaming to %s:%d", sender_ip.c_str(), conf.port);
 #endif
 
+    // start streaming
+    _startStream(conf);
+}
+
+void Streaming::_startStream(const NetworkToolkit::StreamConfig &conf)
+{
+    streamers_lock_.lock();
+
+    // identical stream already encoded: just send it to this client too
+    for (auto sit = streamers_.begin(); sit != streamers_.end(); ++sit) {
+        if ( (*sit)->shareable(conf) && (*sit)->addClient(conf) ) {
+            streamers_lock_.unlock();
+            return;
+        }
+    }
+
     // create streamer & remember it
     VideoStreamer *streamer = new VideoStreamer(conf);
-    streamers_lock_.lock();
     streamers_.push_back(streamer);
     streamers_lock_.unlock();
 
@@ -368,9 +377,105 @@ void Streaming::_addStream(const std::string &sender, int reply_to,
 }
 
 
-VideoStreamer::VideoStreamer(const NetworkToolkit::StreamConfig &conf): FrameGrabber(), config_(conf), stopped_(false)
+VideoStreamer::VideoStreamer(const NetworkToolkit::StreamConfig &conf): FrameGrabber(), ring_(nullptr),
+    config_(conf), stopped_(false), sink_(nullptr)
 {
     frame_duration_ = gst_util_uint64_scale_int (1, GST_SECOND, STREAMING_FPS);  // fixed 30 FPS
+    clients_.push_back(conf);
+}
+
+VideoStreamer::~VideoStreamer()
+{
+    if (sink_)
+        gst_object_unref (sink_);
+    if (ring_)
+        delete ring_;
+}
+
+bool VideoStreamer::shareable(const NetworkToolkit::StreamConfig &conf) const
+{
+    // shared memory socket is specific to each client
+    if (conf.protocol == NetworkToolkit::SHM_RAW || conf.protocol == NetworkToolkit::SHM_RING ||
+        conf.protocol != config_.protocol)
+        return false;
+
+    return !finished_ && !endofstream_ && conf.width == config_.width && conf.height == config_.height;
+}
+
+bool VideoStreamer::addClient(const NetworkToolkit::StreamConfig &conf)
+{
+    std::lock_guard<std::mutex> lock(clients_lock_);
+
+    // already a client
+    for (auto c = clients_.begin(); c != clients_.end(); ++c) {
+        if (c->client_address.compare(conf.client_address) == 0 && c->port == conf.port)
+            return true;
+    }
+
+    clients_.push_back(conf);
+
+    // add destination to the running pipeline (otherwise set in init)
+    if (sink_) {
+        g_signal_emit_by_name (sink_, "add", conf.client_address.c_str(), conf.port, NULL);
+        // new client can decode H264 only from next key frame
+        if (config_.protocol == NetworkToolkit::UDP_H264)
+            gst_element_send_event (sink_, gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE, TRUE, 0));
+    }
+
+#ifdef STREAMER_DEBUG
+    Log::Info("Starting streaming to %s:%d (%ld clients)", conf.client_address.c_str(), conf.port, clients_.size());
+#endif
+    return true;
+}
+
+bool VideoStreamer::removeClient(const std::string &address, int port, NetworkToolkit::StreamConfig *removed)
+{
+    std::lock_guard<std::mutex> lock(clients_lock_);
+
+    for (auto c = clients_.begin(); c != clients_.end(); ++c) {
+        if (c->client_address.compare(address) == 0 && c->port == port) {
+#ifdef STREAMER_DEBUG
+            Log::Info("Ending streaming to %s:%d", c->client_address.c_str(), c->port);
+#endif
+            if (sink_ && config_.protocol != NetworkToolkit::SHM_RAW)
+                g_signal_emit_by_name (sink_, "remove", c->client_address.c_str(), c->port, NULL);
+            if (removed)
+                *removed = *c;
+            clients_.erase(c);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+size_t VideoStreamer::removeClients(const std::string &clientname)
+{
+    std::lock_guard<std::mutex> lock(clients_lock_);
+
+    size_t n = 0;
+    auto c = clients_.begin();
+    while ( c != clients_.end() ) {
+        if (c->client_name.compare(clientname) == 0) {
+#ifdef STREAMER_DEBUG
+            Log::Info("Ending streaming to %s:%d", c->client_address.c_str(), c->port);
+#endif
+            if (sink_ && config_.protocol != NetworkToolkit::SHM_RAW)
+                g_signal_emit_by_name (sink_, "remove", c->client_address.c_str(), c->port, NULL);
+            c = clients_.erase(c);
+            ++n;
+        }
+        else
+            ++c;
+    }
+
+    return n;
+}
+
+size_t VideoStreamer::numClients() const
+{
+    std::lock_guard<std::mutex> lock(clients_lock_);
+    return clients_.size();
 }
 
 std::string VideoStreamer::init(GstCaps *read_caps, GstCaps *write_caps)
@@ -465,10 +570,15 @@ std::string VideoStreamer::init(GstCaps *read_caps, GstCaps *write_caps)
                       "socket-path", path.c_str(),  NULL);
     }
     else {
-        g_object_set (G_OBJECT (gst_bin_get_by_name (GST_BIN (pipeline_), "sink")),
+        // one encoder sent to all clients (added or removed while streaming)
+        std::lock_guard<std::mutex> lock(clients_lock_);
+        std::string destinations;
+        for (auto c = clients_.begin(); c != clients_.end(); ++c)
+            destinations += (c == clients_.begin() ? "" : ",") + c->client_address + ":" + std::to_string(c->port);
+        sink_ = gst_bin_get_by_name (GST_BIN (pipeline_), "sink");
+        g_object_set (G_OBJECT (sink_),
                       "sync", FALSE,
-                      "host", config_.client_address.c_str(),
-                      "port", config_.port,  NULL);
+                      "clients", destinations.c_str(),  NULL);
     }
 
     // setup custom app source
@@ -512,7 +622,14 @@ std::string VideoStreamer::init(GstCaps *read_caps, GstCaps *write_caps)
 void VideoStreamer::terminate()
 {
     // send EOS
-    gst_app_src_end_of_stream (src_);
+    if (src_)
+        gst_app_src_end_of_stream (src_);
+
+    // release the shared memory ring (and its socket)
+    if (ring_) {
+        delete ring_;
+        ring_ = nullptr;
+    }
 
     // force finished
     endofstream_ = true;
@@ -531,10 +648,76 @@ void VideoStreamer::terminate()
 
 void VideoStreamer::stop ()
 {
+    // shared memory ring: no pipeline to end
+    // (ring is closed for the client on terminate)
+    if (config_.protocol == NetworkToolkit::SHM_RING) {
+        active_ = false;
+        finished_ = true;
+        return;
+    }
+
     // stop recording
     FrameGrabber::stop ();
 }
 
+void VideoStreamer::addFrame (const unsigned char *pixels, GstCaps *read_caps, GstCaps *)
+{
+    // ignore
+    if (pixels == nullptr || read_caps == nullptr || finished_)
+        return;
+
+    // first frame: create the ring of frames given to the client
+    if (ring_ == nullptr) {
+        gint w = 0, h = 0;
+        GstStructure *capstruct = gst_caps_get_structure (read_caps, 0);
+        gst_structure_get_int (capstruct, "width", &w);
+        gst_structure_get_int (capstruct, "height", &h);
+        const gchar *format = gst_structure_get_string (capstruct, "format");
+        if ( config_.width != w || config_.height != h) {
+            Log::Warning("Video Streamer cannot start: given frames (%d x %d) are incompatible with stream (%d x %d)",
+                         w, h, config_.width, config_.height);
+            finished_ = true;
+            return;
+        }
+
+        // RGBA frames are shared with their alpha channel
+        std::string path = SystemToolkit::full_filename(SystemToolkit::temp_path(), "shm");
+        path += std::to_string(config_.port);
+        ring_ = FrameRing::create(path, w, h, g_strcmp0(format, "RGBA") == 0 ? 4 : 3);
+        if (ring_ == nullptr) {
+            Log::Warning("Video Streamer : Could not create shared memory ring %s", path.c_str());
+            finished_ = true;
+            return;
+        }
+
+        read_caps_ = gst_caps_copy( read_caps );
+        timer_ = gst_system_clock_obtain ();
+        timer_firstframe_ = gst_clock_get_time(timer_);
+        initialized_ = true;
+        accept_buffer_ = true;
+        active_ = true;
+        Log::Info("Streaming to %s started.\n%s", config_.client_name.c_str(),
+                  NetworkToolkit::stream_protocol_label[config_.protocol]);
+    }
+    // stop if an incompatilble frame buffer given after initialization
+    else if ( !gst_caps_is_subset( read_caps_, read_caps ) ) {
+        stop();
+        Log::Warning("Frame capture interrupted because the resolution changed.");
+        return;
+    }
+
+    if (!active_ || pause_)
+        return;
+
+    // single copy from the mapped PBO into the slot read by the client
+    memcpy(ring_->next(), pixels, ring_->frameSize());
+    ring_->publish();
+
+    // count frames
+    frame_count_++;
+    duration_ = gst_clock_get_time(timer_) - timer_firstframe_;
+}
+
 std::string VideoStreamer::info(bool extended) const
 {
     std::ostringstream ret;
@@ -548,7 +731,9 @@ std::string VideoStreamer::info(bool extended) const
         else if (active_) {
             ret << NetworkToolkit::stream_protocol_label[config_.protocol];
             ret << " to ";
-            ret << config_.client_name;
+            std::lock_guard<std::mutex> lock(clients_lock_);
+            for (auto c = clients_.begin(); c != clients_.end(); ++c)
+                ret << (c == clients_.begin() ? "" : ", ") << c->client_name;
         }
         else
             ret <<  "Streaming terminated.";
@@ -556,3 +741,37 @@ std::string VideoStreamer::info(bool extended) const
 
     return ret.str();
 }
+
+std::vector<std::string> VideoStreamer::clients() const
+{
+    std::vector<std::string> ls;
+
+    std::lock_guard<std::mutex> lock(clients_lock_);
+    for (auto c = clients_.begin(); c != clients_.end(); ++c) {
+        std::ostringstream ret;
+        if (!initialized_)
+            ret << "Connecting " << c->client_name;
+        else {
+            ret << NetworkToolkit::stream_protocol_label[config_.protocol];
+            ret << " to " << c->client_name;
+            // statistics of sending to this client
+            GstStructure *stats = NULL;
+            if (sink_ && active_ && config_.protocol != NetworkToolkit::SHM_RAW)
+                g_signal_emit_by_name (sink_, "get-stats", c->client_address.c_str(), c->port, &stats);
+            if (stats) {
+                guint64 bytes = 0, since = 0;
+                gst_structure_get_uint64 (stats, "bytes-sent", &bytes);
+                gst_structure_get_uint64 (stats, "connect-time", &since);
+                gst_structure_free (stats);
+                ret << " (" << BaseToolkit::byte_to_string(bytes);
+                guint64 now = g_get_real_time() * GST_USECOND;
+                if (now > since + GST_SECOND)
+                    ret << ", " << (int) ( (double) bytes * 8.0 / ((double) (now - since) / GST_SECOND) / 1000.0) << " kbps";
+                ret << ")";
+            }
+        }
+        ls.push_back(ret.str());
+    }
+
+    return ls;
+}
@@ -3,6 +3,7 @@
 
 #include <mutex>
 #include <list>
+#include <vector>
 
 #include "osc/OscReceivedElements.h"
 #include "osc/OscPacketListener.h"
@@ -14,6 +15,7 @@
 #define STREAMING_FPS 30
 
 class VideoStreamer;
+class FrameRing;
 
 class Streaming
 {
@@ -51,8 +53,10 @@ protected:
                                      const IpEndpointName& remoteEndpoint );
     };
     void _addStream(const std::string &sender, int reply_to, const std::string &clientname,
-                   NetworkToolkit::StreamProtocol protocol = NetworkToolkit::DEFAULT);
+                   NetworkToolkit::StreamProtocol protocol = NetworkToolkit::DEFAULT,
+                   bool client_ring = false);
     void _refuseStream(const std::string &sender, int reply_to);
+    void _startStream(const NetworkToolkit::StreamConfig &conf);
 
 private:
 
@@ -74,18 +78,39 @@ class VideoStreamer : public FrameGrabber
     void terminate() override;
     void stop() override;
 
-    // connection information
+    // shared memory ring: frames written in place from the mapped pixels
+    using FrameGrabber::addFrame;
+    bool mapped() const override { return config_.protocol == NetworkToolkit::SHM_RING; }
+    void addFrame(const unsigned char *pixels, GstCaps *read_caps, GstCaps *write_caps) override;
+    FrameRing *ring_;
+
+    // connection information (of the first client)
     NetworkToolkit::StreamConfig config_;
     std::atomic<bool> stopped_;
 
+    // all clients receiving the stream (single encoder, fan-out in multiudpsink)
+    std::vector<NetworkToolkit::StreamConfig> clients_;
+    mutable std::mutex clients_lock_;
+    GstElement *sink_;
+
+    // true if the stream can be sent to this client too (same protocol and resolution)
+    bool shareable(const NetworkToolkit::StreamConfig &conf) const;
+    // add or remove destinations without interrupting the encoder
+    bool addClient(const NetworkToolkit::StreamConfig &conf);
+    bool removeClient(const std::string &address, int port, NetworkToolkit::StreamConfig *removed = nullptr);
+    size_t removeClients(const std::string &clientname);
+    size_t numClients() const;
+
 public:
 
     VideoStreamer(const NetworkToolkit::StreamConfig &conf);
-    virtual ~VideoStreamer() {}
+    virtual ~VideoStreamer();
 
     FrameGrabber::Type type () const override { return FrameGrabber::GRABBER_P2P; }
     std::string info(bool extended = false) const override;
 
+    // description of each client, with bytes sent and bitrate
+    std::vector<std::string> clients() const;
 };
 
 #endif // STREAMER_H
@@ -23,32 +23,76 @@
 #include "defines.h"
 #include "Timeline.h"
 
-float clamp(float x, float lowerlimit = 0.0f, float upperlimit = 1.0f) {
-    if (x < lowerlimit) return lowerlimit;
-    if (x > upperlimit) return upperlimit;
+// number of keyframes to sample a non-linear fading curve
+#define FADING_SAMPLES 16
+// maximum error when removing a keyframe from the fading curve
+#define FADING_TOLERANCE 0.001f
+
+float linestep(float x) {
     return x;
 }
 
-float smootherstep(size_t edge0, size_t edge1, size_t i) {
-    float x = clamp( static_cast<float>(i - edge0) / static_cast<float>(edge1 - edge0));
+float smootherstep(float x) {
     return x * x * x * (x * (6.0f * x - 15.0f) + 10.0f);
     // return x * x * (3.0f - 2.0f * x);
 }
 
-float linestep(size_t edge0, size_t edge1, size_t i) {
-    float x = clamp( static_cast<float>(i - edge0) / static_cast<float>(edge1 - edge0));
-    return x;
+float squarestep(float x) {
+    return x * x;
 }
 
-float sharpstep(size_t edge0, size_t edge1, size_t i) {
-    float x = clamp( static_cast<float>(i - edge0) / static_cast<float>(edge1 - edge0));
-    return fabs(x)<1.f ? 0.f : 1.f;
+float invsquarestep(float x) {
+    return 1.f - ((x - 1.f) * (x - 1.f));
 }
 
+// append keyframe at time t, keeping keys sorted
+void pushKey(FadingKeys &keys, GstClockTime t, float v)
+{
+    if (keys.empty() || t > keys.back().time)
+        keys.push_back( {t, v} );
+    else if (t == keys.back().time)
+        keys.back().value = v;
+}
 
+// append keyframes sampling the shape from value 'from' at time a to value 'to' at time b
+void appendFadingSamples(FadingKeys &keys, GstClockTime a, GstClockTime b, float from, float to,
+                         float (*shape)(float), size_t samples)
+{
+    if (b <= a) {
+        pushKey(keys, a, to);
+        return;
+    }
+    for (size_t i = 0; i <= samples; ++i) {
+        const double x = static_cast<double>(i) / static_cast<double>(samples);
+        const GstClockTime t = a + static_cast<GstClockTime>( x * static_cast<double>(b - a) );
+        pushKey(keys, t, from + shape( static_cast<float>(x) ) * (to - from));
+    }
+}
 
-static float empty_zeros[MAX_TIMELINE_ARRAY] = {};
-static float empty_ones[MAX_TIMELINE_ARRAY] = {};
+// append keyframes of a fading curve from value 'from' at time a to value 'to' at time b
+void appendFading(FadingKeys &keys, GstClockTime a, GstClockTime b, float from, float to,
+                  Timeline::FadingCurve curve)
+{
+    if (curve == Timeline::FADING_LINEAR)
+        appendFadingSamples(keys, a, b, from, to, linestep, 1);
+    else if (curve == Timeline::FADING_SMOOTH)
+        appendFadingSamples(keys, a, b, from, to, smootherstep, FADING_SAMPLES);
+    else {
+        // sharp: hold 'from' until b
+        pushKey(keys, a, from);
+        if (b > a)
+            pushKey(keys, b - 1, from);
+        pushKey(keys, b, to);
+    }
+}
+
+struct beforeKey
+{
+    inline bool operator()(const GstClockTime t, const FadingKey &k) const
+    {
+       return t < k.time;
+    }
+};
 
 struct includesTime
 {
@@ -63,11 +107,16 @@ private:
     GstClockTime _t;
 };
 
-Timeline::Timeline()
+Timeline::Timeline() : revision_(0)
 {
     reset();
 }
 
+Timeline::Timeline(const Timeline &b) : Timeline()
+{
+    *this = b;
+}
+
 Timeline::~Timeline()
 {
     reset();
@@ -76,6 +125,7 @@ Timeline::~Timeline()
 Timeline& Timeline::operator = (const Timeline& b)
 {
     if (this != &b) {
+        ++this->revision_;
         this->timing_ = b.timing_;
         if (b.step_ != GST_CLOCK_TIME_NONE)
             this->step_ = b.step_;
@@ -83,14 +133,13 @@ Timeline& Timeline::operator = (const Timeline& b)
             this->first_ = b.first_;
         if (b.last_ != GST_CLOCK_TIME_NONE)
             this->last_ = b.last_;
+        // arrays are not copied; they will be filled when requested
         this->gaps_ = b.gaps_;
-        this->gaps_array_need_update_ = b.gaps_array_need_update_;
-        memcpy( this->gapsArray_, b.gapsArray_, MAX_TIMELINE_ARRAY * sizeof(float));
-        memcpy( this->fadingArray_, b.fadingArray_, MAX_TIMELINE_ARRAY * sizeof(float));
-        this->fading_array_changed_ = true;
+        this->gaps_array_need_update_ = true;
+        this->fading_ = b.fading_;
+        this->fading_array_need_update_ = true;
         this->flags_ = b.flags_;
-        this->flags_array_need_update_ = b.flags_array_need_update_;
-        memcpy( this->flagsArray_, b.flagsArray_, MAX_TIMELINE_ARRAY * sizeof(float));
+        this->flags_array_need_update_ = true;
     }
     return *this;
 }
@@ -103,6 +152,7 @@ void Timeline::reset()
     first_ = GST_CLOCK_TIME_NONE;
     last_ = GST_CLOCK_TIME_NONE;
     step_ = GST_CLOCK_TIME_NONE;
+    ++revision_;
 
     clearGaps();
     clearFading();
@@ -116,24 +166,34 @@ bool Timeline::is_valid() const
 
 void Timeline::setFirst(GstClockTime first)
 {
-    if (first != GST_CLOCK_TIME_NONE && first > 0)
+    if (first != GST_CLOCK_TIME_NONE && first > 0 && first != first_) {
         first_ = first;
+        ++revision_;
+    }
 }
 
 void Timeline::setEnd(GstClockTime end)
 {
-    timing_.end = end;
+    if (end != timing_.end) {
+        timing_.end = end;
+        ++revision_;
+    }
 }
 
 void Timeline::setLast(GstClockTime last)
 {
-    if (last != GST_CLOCK_TIME_NONE && last > 0)
+    if (last != GST_CLOCK_TIME_NONE && last > 0 && last != last_) {
         last_ = last;
+        ++revision_;
+    }
 }
 
 void Timeline::setStep(GstClockTime dt)
 {
-    step_ = dt;
+    if (dt != step_) {
+        step_ = dt;
+        ++revision_;
+    }
 }
 
 void Timeline::setTiming(TimeInterval interval, GstClockTime step)
@@ -142,6 +202,7 @@ void Timeline::setTiming(TimeInterval interval, GstClockTime step)
     first_ = GST_CLOCK_TIME_NONE;
     if (step != GST_CLOCK_TIME_NONE)
         step_ = step;
+    ++revision_;
 }
 
 GstClockTime Timeline::next(GstClockTime time) const
@@ -171,25 +232,42 @@ GstClockTime Timeline::previous(GstClockTime time) const
     return prev_time;
 }
 
+GstClockTime Timeline::arrayTime(size_t i, size_t array_size) const
+{
+    if (timing_.end == GST_CLOCK_TIME_NONE || array_size < 1)
+        return 0;
+
+    return ( static_cast<GstClockTime>(i) * timing_.end ) / static_cast<GstClockTime>(array_size);
+}
+
 float *Timeline::gapsArray()
 {
-    if (gaps_array_need_update_) {
-        fillArrayFromGaps(gapsArray_, MAX_TIMELINE_ARRAY);
+    if (gaps_array_need_update_ || gapsArray_.empty()) {
+        fillArrayFromGaps();
     }
-    return gapsArray_;
+    return gapsArray_.data();
 }
 
 void Timeline::update()
 {
-    updateGapsFromArray(gapsArray_, MAX_TIMELINE_ARRAY);
-    gaps_array_need_update_ = false;
-    fading_array_changed_ = true;
+    // apply changes made in the gaps array
+    // (an outdated array is refilled when requested)
+    if (!gapsArray_.empty() && !gaps_array_need_update_) {
+        updateGapsFromArray(gapsArray_.data(), gapsArray_.size());
+        // gaps were set from the array, which is up to date
+        gaps_array_need_update_ = false;
+    }
+
+    // apply changes made in the fading array
+    if (!fadingArray_.empty() && !fading_array_need_update_)
+        updateFadingFromArray(fadingArray_.data(), fadingArray_.size());
 }
 
 void Timeline::refresh()
 {
-    fillArrayFromGaps(gapsArray_, MAX_TIMELINE_ARRAY);
-    fillArrayFromFlags(flagsArray_, MAX_TIMELINE_ARRAY);
+    fillArrayFromGaps();
+    fillArrayFromFading();
+    fillArrayFromFlags();
 }
 
 bool Timeline::gapAt(const GstClockTime t) const
@@ -221,6 +299,7 @@ bool Timeline::cut(GstClockTime t, bool left, bool join_extremity)
 
     if (timing_.includes(t))
     {
+        ++revision_;
         TimeIntervalSet::iterator gap = std::find_if(gaps_.begin(), gaps_.end(), includesTime(t));
 
         // cut left part
@@ -302,6 +381,7 @@ bool Timeline::addGap(TimeInterval s)
 {
     if ( s.is_valid() ) {
         gaps_array_need_update_ = true;
+        ++revision_;
         return gaps_.insert(s).second;
     }
 
@@ -312,6 +392,7 @@ void Timeline::setGaps(const TimeIntervalSet &g)
 {
     gaps_array_need_update_ = true;
     gaps_ = g;
+    ++revision_;
 }
 
 bool Timeline::removeGaptAt(GstClockTime t)
@@ -324,6 +405,7 @@ bool Timeline::removeGaptAt(GstClockTime t)
     if ( s != gaps_.end() ) {
         gaps_.erase(s);
         gaps_array_need_update_ = true;
+        ++revision_;
         return true;
     }
 
@@ -427,8 +509,8 @@ size_t Timeline::fillSectionsArrays( float* const gaps, float* const fading)
 {
     size_t arraysize = MAX_TIMELINE_ARRAY;
 
-    if (gaps_array_need_update_)
-        fillArrayFromGaps(gapsArray_, MAX_TIMELINE_ARRAY);
+    const float *gaps_array = gapsArray();
+    const float *fading_array = fadingArray();
 
     if (gaps_.size() > 0) {
         float* gapsptr = gaps;
@@ -456,8 +538,8 @@ size_t Timeline::fillSectionsArrays( float* const gaps, float* const fading)
             e = ( (*it).begin * MAX_TIMELINE_ARRAY ) / timing_.end;
 
             size_t n = e - s;
-            memcpy( gapsptr, gapsArray_ + s, n  * sizeof(float));
-            memcpy( fadingptr, fadingArray_ + s, n * sizeof(float));
+            memcpy( gapsptr, gaps_array + s, n  * sizeof(float));
+            memcpy( fadingptr, fading_array + s, n * sizeof(float));
 
             for (size_t i = -5; i > 0; ++i)
                 gapsptr[ MAX(n+i, 0) ] = 1.f;
@@ -477,18 +559,15 @@ size_t Timeline::fillSectionsArrays( float* const gaps, float* const fading)
             e = MAX_TIMELINE_ARRAY;
 
             size_t n = e - s;
-            memcpy( gapsptr, gapsArray_ + s, n * sizeof(float));
-            memcpy( fadingptr, fadingArray_ + s, n * sizeof(float));
+            memcpy( gapsptr, gaps_array + s, n * sizeof(float));
+            memcpy( fadingptr, fading_array + s, n * sizeof(float));
             arraysize += n;
         }
-
-        fading_array_changed_ = true;
     }
     else {
 
-        memcpy( gaps, gapsArray_, MAX_TIMELINE_ARRAY * sizeof(float));
-        memcpy( fading, fadingArray_, MAX_TIMELINE_ARRAY * sizeof(float));
-        fading_array_changed_ = true;
+        memcpy( gaps, gaps_array, MAX_TIMELINE_ARRAY * sizeof(float));
+        memcpy( fading, fading_array, MAX_TIMELINE_ARRAY * sizeof(float));
     }
 
     return arraysize;
@@ -525,23 +604,27 @@ TimeIntervalSet Timeline::sections() const
 void Timeline::clearGaps()
 {
     gaps_.clear();
-
-    memcpy(gapsArray_, empty_zeros, MAX_TIMELINE_ARRAY * sizeof(float));
-
     gaps_array_need_update_ = true;
+    ++revision_;
 }
 
 float Timeline::fadingAt(const GstClockTime t) const
 {
-    double true_index = (static_cast<double>(MAX_TIMELINE_ARRAY) * static_cast<double>(t)) / static_cast<double>(timing_.end);
-    double previous_index = floor(true_index);
-    float percent = static_cast<float>(true_index - previous_index);
-    size_t keyframe_index = MINI( static_cast<size_t>(previous_index), MAX_TIMELINE_ARRAY-1);
-    size_t keyframe_next_index = MINI( keyframe_index+1, MAX_TIMELINE_ARRAY-1);
-    float v = fadingArray_[keyframe_index];
-    v += percent * (fadingArray_[keyframe_next_index] - fadingArray_[keyframe_index]);
-
-    return v;
+    // no keyframe means no fading
+    if (fading_.empty())
+        return 1.f;
+
+    // find first keyframe after t
+    auto k = std::upper_bound(fading_.begin(), fading_.end(), t, beforeKey());
+    if (k == fading_.begin())
+        return k->value;
+    if (k == fading_.end())
+        return fading_.back().value;
+
+    // interpolate between previous and next keyframes
+    auto p = k - 1;
+    const double percent = static_cast<double>(t - p->time) / static_cast<double>(k->time - p->time);
+    return p->value + static_cast<float>(percent) * (k->value - p->value);
 }
 
 size_t Timeline::fadingIndexAt(const GstClockTime t) const
@@ -551,52 +634,169 @@ size_t Timeline::fadingIndexAt(const GstClockTime t) const
     return  MINI( static_cast<size_t>(previous_index), MAX_TIMELINE_ARRAY-1);
 }
 
+float *Timeline::fadingArray()
+{
+    if (fading_array_need_update_ || fadingArray_.empty()) {
+        fillArrayFromFading();
+    }
+    return fadingArray_.data();
+}
+
+void Timeline::setFadingKeys(const FadingKeys &keys)
+{
+    fading_.clear();
+    for (auto k = keys.begin(); k != keys.end(); ++k)
+        pushKey(fading_, k->time, CLAMP(k->value, 0.f, 1.f));
+
+    simplifyFading();
+    fading_array_need_update_ = true;
+}
+
+void Timeline::setFadingArray(const float *array, size_t array_size)
+{
+    clearFading();
+    updateFadingFromArray(array, array_size);
+}
+
 void Timeline::clearFading()
 {
-    // fill static with 1 (only once)
-    if (empty_ones[0] < 1.f){
-        for(int i=0;i<MAX_TIMELINE_ARRAY;++i)
-            empty_ones[i] = 1.f;
+    fading_.clear();
+    fading_array_need_update_ = true;
+}
+
+bool Timeline::fadingIsClear() const
+{
+    return fading_.empty();
+}
+
+void Timeline::replaceFading(GstClockTime a, GstClockTime b, const FadingKeys &keys)
+{
+    if (b < a)
+        return;
+
+    FadingKeys f;
+    f.reserve(fading_.size() + keys.size() + 2);
+
+    // keep keyframes before a
+    auto k = fading_.begin();
+    for (; k != fading_.end() && k->time < a; ++k)
+        f.push_back(*k);
+
+    // keep the previous curve unchanged just before a
+    if (a > 0 && (f.empty() || f.back().time < a - 1))
+        f.push_back( {a - 1, fadingAt(a - 1)} );
+
+    // insert new keyframes in [a b]
+    for (auto n = keys.begin(); n != keys.end(); ++n) {
+        if (n->time >= a && n->time <= b)
+            pushKey(f, n->time, n->value);
+    }
+
+    // skip keyframes in [a b]
+    for (; k != fading_.end() && k->time <= b; ++k);
+
+    // keep the previous curve unchanged just after b
+    if (k == fading_.end() || k->time > b + 1)
+        pushKey(f, b + 1, fadingAt(b + 1));
+
+    // keep keyframes after b
+    for (; k != fading_.end(); ++k)
+        pushKey(f, k->time, k->value);
+
+    fading_.swap(f);
+    simplifyFading();
+    fading_array_need_update_ = true;
+}
+
+void Timeline::simplifyFading()
+{
+    // remove keyframes that are (nearly) interpolated by their neighbors
+    if (fading_.size() > 2) {
+        FadingKeys f;
+        f.reserve(fading_.size());
+        f.push_back(fading_.front());
+        for (size_t i = 1; i < fading_.size() - 1; ++i) {
+            const FadingKey &p = f.back();
+            const FadingKey &n = fading_[i + 1];
+            const double percent = static_cast<double>(fading_[i].time - p.time) / static_cast<double>(n.time - p.time);
+            const float v = p.value + static_cast<float>(percent) * (n.value - p.value);
+            if (fabs(v - fading_[i].value) > FADING_TOLERANCE)
+                f.push_back(fading_[i]);
+        }
+        f.push_back(fading_.back());
+        fading_.swap(f);
     }
-    // clear with static array
-    memcpy(fadingArray_, empty_ones, MAX_TIMELINE_ARRAY * sizeof(float));
-    fading_array_allones_ = true;
+
+    // remove flat extremities
+    while (fading_.size() > 1 && fabs(fading_[0].value - fading_[1].value) < FADING_TOLERANCE)
+        fading_.erase(fading_.begin());
+    while (fading_.size() > 1 && fabs(fading_[fading_.size() - 2].value - fading_.back().value) < FADING_TOLERANCE)
+        fading_.pop_back();
+
+    // a constant curve at 1 is no fading
+    if (fading_.size() == 1 && fading_.front().value > 1.f - FADING_TOLERANCE)
+        fading_.clear();
 }
 
-bool Timeline::fadingIsClear()
+void Timeline::updateFadingFromArray(const float *array, size_t array_size)
 {
-    if (fading_array_changed_) {
-        int i = 0;
-        while (i < MAX_TIMELINE_ARRAY && fadingArray_[i] > 0.999f)
-            ++i;
-        fading_array_allones_ = i == MAX_TIMELINE_ARRAY;
-        fading_array_changed_ = false;
+    if (array == nullptr || array_size < 1 || !timing_.is_valid())
+        return;
+
+    // find the range of values that differ from the fading curve
+    size_t s = array_size;
+    size_t e = 0;
+    for (size_t i = 0; i < array_size; ++i) {
+        if ( fabs(array[i] - fadingAt(arrayTime(i, array_size))) > EPSILON ) {
+            s = MINI(s, i);
+            e = i;
+        }
     }
 
-    return fading_array_allones_;
+    // replace fading curve in that range by values of the array
+    if (s <= e) {
+        FadingKeys keys;
+        for (size_t i = s; i <= e; ++i)
+            pushKey(keys, arrayTime(i, array_size), CLAMP(array[i], 0.f, 1.f));
+        replaceFading(keys.front().time, keys.back().time, keys);
+    }
+}
+
+void Timeline::sampleFading(float *array, size_t array_size) const
+{
+    // sample the curve at each index of array
+    for (size_t i = 0; i < array_size; ++i)
+        array[i] = fadingAt( arrayTime(i, array_size) );
+}
+
+void Timeline::fillArrayFromFading()
+{
+    fadingArray_.resize(MAX_TIMELINE_ARRAY);
+    sampleFading(fadingArray_.data());
+
+    fading_array_need_update_ = false;
 }
 
 void Timeline::smoothFading(uint N, TimeInterval interval)
 {
     const float kernel[7] = { 2.f, 22.f, 97.f, 159.f, 97.f, 22.f, 2.f};
-    float tmparray[MAX_TIMELINE_ARRAY];
-
-    // default to cover entire array
-    long s = 0;
-    long e = MAX_TIMELINE_ARRAY;
 
     // if a valid interval is given in argument
     if (interval.is_valid()) {
 
         // get index of begining of interval
-        s = (interval.begin * MAX_TIMELINE_ARRAY) / timing_.end;
+        long s = (interval.begin * MAX_TIMELINE_ARRAY) / timing_.end;
         // get index of ending of interval
-        e = (interval.end * MAX_TIMELINE_ARRAY) / timing_.end;
+        long e = MINI( (long) ((interval.end * MAX_TIMELINE_ARRAY) / timing_.end), (long) MAX_TIMELINE_ARRAY);
+        if (s >= e)
+            return;
+
+        // filter the curve sampled at the resolution of the array
+        std::vector<float> values(fadingArray(), fadingArray() + MAX_TIMELINE_ARRAY);
+        std::vector<float> tmparray(values);
 
         // iterate a given amount of times
         for (uint n = 0; n < N; ++n) {
-            // copy to tmp array
-            memcpy(tmparray, fadingArray_, MAX_TIMELINE_ARRAY * sizeof(float));
             // apply gaussian filter on the interval
             for (long i = s; i < e; ++i) {
                 tmparray[i] = 0.f;
@@ -604,16 +804,21 @@ void Timeline::smoothFading(uint N, TimeInterval interval)
                 for (long j = 0; j < 7; ++j) {
                     long k = i - 3 + j;
                     if (k > -1 && k < MAX_TIMELINE_ARRAY - 1) {
-                        tmparray[i] += fadingArray_[k] * kernel[j];
+                        tmparray[i] += values[k] * kernel[j];
                         divider += kernel[j];
                     }
                 }
                 tmparray[i] *= 1.f / divider;
             }
-            // copy back to array
-            memcpy(fadingArray_, tmparray, MAX_TIMELINE_ARRAY * sizeof(float));
-            fading_array_changed_ = true;
+            // copy back to values
+            values = tmparray;
         }
+
+        // replace the curve in the interval by filtered values
+        FadingKeys keys;
+        for (long i = s; i < e; ++i)
+            pushKey(keys, arrayTime(i), values[i]);
+        replaceFading(keys.front().time, keys.back().time, keys);
     }
     // in absence of interval given, loop over all sections
     else {
@@ -627,12 +832,7 @@ void Timeline::smoothFading(uint N, TimeInterval interval)
 
 void Timeline::autoFading(const GstClockTime duration, FadingCurve curve)
 {
-    // mow many index values of timeline array for this duration?
-    size_t N = MAX_TIMELINE_ARRAY -1;
-    if ( duration < timing_.end )
-        N = duration / (timing_.end / MAX_TIMELINE_ARRAY);
-
-    // clear with static array
+    // clear fading curve
     clearFading();
 
     // get sections (inverse of gaps)
@@ -642,45 +842,34 @@ void Timeline::autoFading(const GstClockTime duration, FadingCurve curve)
     // NB : there is at least one
     for (auto it = sec.begin(); it != sec.end(); ++it)
     {
-        // get index of begining of section
-        const size_t s = ( (*it).begin * MAX_TIMELINE_ARRAY ) / timing_.end;
-
-        // get index of ending of section
-        const size_t e = ( ( (*it).end * MAX_TIMELINE_ARRAY ) / timing_.end ) -1;
-
-        // calculate size of the smooth transition in [s e] interval
-        const size_t n = MIN( (e-s)/2, N );
-
-        // linear fade in starting at s
-        size_t i = s;
-        for (; i < s+n; ++i){
-            const float x = static_cast<float>(i-s) / static_cast<float>(n);
-            if (curve==FADING_LINEAR)
-                fadingArray_[i] = x * x;
-            else if (curve==FADING_SMOOTH)
-                fadingArray_[i] = 1.f - ((x- 1.f) * (x - 1.f));
-            else
-                fadingArray_[i] = x;
+        // calculate size of the smooth transition in section
+        const GstClockTime n = MIN( (*it).duration() / 2, duration );
+        if (n < 1)
+            continue;
+
+        // fade in starting at beginning of section, fade out ending at end of section
+        FadingKeys keys;
+        if (curve==FADING_LINEAR) {
+            appendFadingSamples(keys, (*it).begin, (*it).begin + n, 0.f, 1.f, squarestep, FADING_SAMPLES);
+            appendFadingSamples(keys, (*it).end - n, (*it).end, 1.f, 0.f, invsquarestep, FADING_SAMPLES);
         }
-        // plateau
-        for (; i < e-n; ++i)
-            fadingArray_[i] = 1.f;
-        // linear fade out ending at e
-        for (; i < e; ++i) {
-            const float x = static_cast<float>(e-i) / static_cast<float>(n);
-            if (curve==FADING_LINEAR)
-                fadingArray_[i] = x * x;
-            else if (curve==FADING_SMOOTH)
-                fadingArray_[i] = 1.f - ((x- 1.f) * (x - 1.f));
-            else
-                fadingArray_[i] = x;
+        else if (curve==FADING_SMOOTH) {
+            appendFadingSamples(keys, (*it).begin, (*it).begin + n, 0.f, 1.f, invsquarestep, FADING_SAMPLES);
+            appendFadingSamples(keys, (*it).end - n, (*it).end, 1.f, 0.f, squarestep, FADING_SAMPLES);
+        }
+        else {
+            appendFadingSamples(keys, (*it).begin, (*it).begin + n, 0.f, 1.f, linestep, 1);
+            appendFadingSamples(keys, (*it).end - n, (*it).end, 1.f, 0.f, linestep, 1);
         }
-        fading_array_changed_ = true;
+        replaceFading((*it).begin, (*it).end, keys);
     }
 }
 
 void Timeline::fadeOut(const GstClockTime from, const GstClockTime duration, FadingCurve curve)
 {
+    if (!is_valid())
+        return;
+
     GstClockTime to = from + duration;
 
     if (duration > timing_.end) {
@@ -694,90 +883,61 @@ void Timeline::fadeOut(const GstClockTime from, const GstClockTime duration, Fad
         }
     }
 
-    // get index of begining of fading curve
-    const size_t s = ( from * MAX_TIMELINE_ARRAY ) / timing_.end;
-
-    // get index of ending of fading curve
-    const size_t e = ( to * MAX_TIMELINE_ARRAY ) / timing_.end;
-
-    // how many index values of timeline array for this duration?
-    size_t N = MAX_TIMELINE_ARRAY - 1;
-    N = MIN( ( MIN( duration, timing_.end - from ) * MAX_TIMELINE_ARRAY )/ timing_.end, N );
-
-    // calculate size of the smooth transition in [s e] interval
-    const size_t n = MIN( e-s, N );
+    // fading curve cannot go beyond the end
+    to = MIN(to, timing_.end);
+    if (to <= from)
+        return;
 
     // if transition too short for a linear or smooth
-    if (N < 3) {
+    if (to - from < 2 * step_)
         curve = FADING_SHARP;
-        N = 2;
-    }
 
-    // fade out starts at s
-    size_t i = s;
-    // float val = fadingArray_[s];
-    for (; i <= s+n; ++i) {
-        if (curve==FADING_LINEAR)
-            fadingArray_[i] = 1.f - linestep(s, s+n, i);
-        else if (curve==FADING_SMOOTH)
-            fadingArray_[i] = 1.f - smootherstep(s, s+n, i);
-        else
-            fadingArray_[i] = sharpstep(s, s+n, i);
-        // fadingArray_[i] *= val;
-    }
-    fading_array_changed_ = true;
+    // fade out starts at from
+    FadingKeys keys;
+    if (curve == FADING_SHARP)
+        appendFading(keys, from, to, 0.f, 1.f, curve);
+    else
+        appendFading(keys, from, to, 1.f, 0.f, curve);
+    replaceFading(from, to, keys);
 }
 
 void Timeline::fadeIn(const GstClockTime to, const GstClockTime duration, FadingCurve curve)
 {
-    GstClockTime from = to - duration;
+    if (!is_valid())
+        return;
+
+    GstClockTime from = duration < to - timing_.begin ? to - duration : timing_.begin;
 
     if (duration > timing_.end) {
         for (auto g = gaps_.begin(); g != gaps_.end(); ++g) {
             // gap before target?
             if ( g->end < to )
-                from = g->end;
+                from = MAX(from, g->end);
             else
                 break;
         }
     }
 
-    // get index of begining of fading curve
-    const size_t s = ( from * MAX_TIMELINE_ARRAY ) / timing_.end;
-
-    // get index of ending of fading curve
-    const size_t e = ( to * MAX_TIMELINE_ARRAY ) / timing_.end;
-
-    // how many index values of timeline array for this duration?
-    size_t N = MAX_TIMELINE_ARRAY - 1;
-    N = MIN( ( MIN( duration, to - timing_.begin ) * MAX_TIMELINE_ARRAY )/ timing_.end, N );
+    // fading curve cannot go beyond the end
+    const GstClockTime end = MIN(to, timing_.end);
+    if (end <= from)
+        return;
 
     // if transition too short for a linear or smooth
-    if (N < 3) {
+    if (end - from < 2 * step_)
         curve = FADING_SHARP;
-        N = 2;
-    }
 
-    // calculate size of the smooth transition in [s e] interval
-    const size_t n = MIN( e-s, N );
-
-    // fade in ends at e
-    size_t i = e-n;
-    // float val = fadingArray_[e];
-    for (; i < e; ++i) {
-        if (curve==FADING_LINEAR)
-            fadingArray_[i] = linestep(e-n, e, i);
-        else if (curve==FADING_SMOOTH)
-            fadingArray_[i] = smootherstep(e-n, e, i);
-        else
-            fadingArray_[i] = sharpstep(e-n, e, i);
-        // fadingArray_[i] *= val;
-    }
-    fading_array_changed_ = true;
+    // fade in ends at end
+    FadingKeys keys;
+    appendFading(keys, from, end, 0.f, 1.f, curve);
+    replaceFading(from, end, keys);
 }
 
 void Timeline::fadeInOutRange(const GstClockTime t, const GstClockTime duration, bool in_and_out, FadingCurve curve)
 {
+    if (!is_valid())
+        return;
+
     // init range to whole timeline
     TimeInterval range = timing_;
 
@@ -795,15 +955,9 @@ void Timeline::fadeInOutRange(const GstClockTime t, const GstClockTime duration,
         }
     }
 
-    // get index of begining of section
-    const size_t s = (range.begin * MAX_TIMELINE_ARRAY) / timing_.end;
-
-    // get index of ending of section
-    const size_t e = (range.end * MAX_TIMELINE_ARRAY) / timing_.end;
-
-    // get index of time in section
-    size_t l = ( MIN(t, range.begin + duration) * MAX_TIMELINE_ARRAY) / timing_.end;
-    size_t r = ( MAX(t, range.end   - duration) * MAX_TIMELINE_ARRAY) / timing_.end;
+    // get time of fading in section
+    GstClockTime l = MIN(t, range.begin + duration);
+    GstClockTime r = duration < range.end ? MAX(t, range.end - duration) : t;
 
     // if duration too short for a linear or smooth
     if (duration < 2 * step_) {
@@ -811,82 +965,103 @@ void Timeline::fadeInOutRange(const GstClockTime t, const GstClockTime duration,
     }
     else if (duration > range.duration()) {
         if (curve == FADING_SHARP) {
-            l = s+1;
-            r = e-1;
+            l = range.begin + step_;
+            r = range.end - step_;
         }
         else
-            l = r = (t * MAX_TIMELINE_ARRAY) / timing_.end;
+            l = r = t;
     }
 
-    // fill values inside range
-    for (size_t k = s; k <= e; ++k) {
-
-        if (curve == FADING_LINEAR){
-            if (k<l)
-                fadingArray_[k] = in_and_out ? linestep(s, l, k) : 1.f - linestep(s, l, k);
-            else if (k<r)
-                fadingArray_[k] = in_and_out ? 1.f : 0.f;
-            else
-                fadingArray_[k] = in_and_out ? 1.f - linestep(r, e, k) : linestep(r, e, k);
-        }
-        else if (curve == FADING_SMOOTH) {
-            if (k<l)
-                fadingArray_[k] = in_and_out ? smootherstep(s, l, k) : 1.f - smootherstep(s, l, k);
-            else if (k<r)
-                fadingArray_[k] = in_and_out ? 1.f : 0.f;
-            else
-                fadingArray_[k] = in_and_out ? 1.f - smootherstep(r, e, k) : smootherstep(r, e, k);
-        }
-        else // curve == FADING_SHARP
-        {
-            if (k<l)
-                fadingArray_[k] = in_and_out ? 0.f : 1.f ;
-            else if (k<r)
-                fadingArray_[k] = in_and_out ? 1.f : 0.f;
-            else
-                fadingArray_[k] = in_and_out ? 0.f : 1.f ;
-       }
-    }    
-    fading_array_changed_ = true;
+    // values at the edges and in the middle of range
+    const float edge = in_and_out ? 0.f : 1.f;
+    const float plateau = in_and_out ? 1.f : 0.f;
+
+    FadingKeys keys;
+    if (curve == FADING_SHARP) {
+        pushKey(keys, range.begin, edge);
+        if (l > range.begin)
+            pushKey(keys, l - 1, edge);
+        pushKey(keys, l, plateau);
+        if (r > l)
+            pushKey(keys, r - 1, plateau);
+        pushKey(keys, r, edge);
+        pushKey(keys, range.end, edge);
+    }
+    else {
+        appendFading(keys, range.begin, l, edge, plateau, curve);
+        appendFading(keys, r, range.end, plateau, edge, curve);
+    }
+    replaceFading(range.begin, range.end, keys);
 }
 
 
 bool Timeline::autoGapInFade()
 {
     bool changed = false;
-    for (long i = 0; i < MAX_TIMELINE_ARRAY; ++i) {
-        if (fadingArray_[i] < EPSILON) {
-            if (gapsArray_[i] != 1.f)
-                changed = true;
-            gapsArray_[i] = 1.f;
+
+    if (fading_.empty() || !timing_.is_valid())
+        return changed;
+
+    // loop over keyframes to detect intervals where fading is zero
+    for (size_t i = 0; i < fading_.size(); ++i) {
+        if (fading_[i].value < EPSILON) {
+            // find last keyframe at zero
+            size_t j = i;
+            while (j + 1 < fading_.size() && fading_[j + 1].value < EPSILON)
+                ++j;
+            // the curve is zero before first and after last keyframes
+            TimeInterval zero( i > 0 ? fading_[i].time : timing_.begin,
+                               j < fading_.size() - 1 ? fading_[j].time : timing_.end );
+            i = j;
+
+            if (!zero.is_valid() || zero.duration() <= step_)
+                continue;
+
+            // merge with gaps overlapping this interval
+            bool included = false;
+            for (auto g = gaps_.begin(); g != gaps_.end(); ) {
+                if (g->includes(zero)) {
+                    included = true;
+                    break;
+                }
+                if ( !(g->end < zero.begin) && !(g->begin > zero.end) ) {
+                    zero = TimeInterval( MIN(g->begin, zero.begin), MAX(g->end, zero.end) );
+                    g = gaps_.erase(g);
+                    ++revision_;
+                }
+                else
+                    ++g;
+            }
+
+            if (!included)
+                changed |= addGap(zero);
         }
     }
 
-    updateGapsFromArray(gapsArray_, MAX_TIMELINE_ARRAY);
-    gaps_array_need_update_ = false;
-
     return changed;
 }
 
 void Timeline::autoFadeInGaps()
 {
-    for (auto it = gaps_.begin(); it != gaps_.end(); ++it)
+    TimeIntervalSet g = gaps_;
+    for (auto it = g.begin(); it != g.end(); ++it)
     {
-        GstClockTime d = timing_.duration();
-        size_t s = ( (*it).begin * MAX_TIMELINE_ARRAY ) / d;
-        size_t e = ( (*it).end * MAX_TIMELINE_ARRAY ) / d;
+        // keep the value before the gap
+        const float v = (*it).begin > timing_.begin ? fadingAt( (*it).begin - 1 ) : 0.f;
 
-        // fill with 1 where there is a gap
-        for (size_t i = s; i < e + 1 ; ++i) {
-            fadingArray_[i] = i > 0 ? fadingArray_[i-1] : 0;
-        }
+        FadingKeys keys;
+        pushKey(keys, (*it).begin, v);
+        pushKey(keys, (*it).end, v);
+        replaceFading((*it).begin, (*it).end, keys);
     }
 }
 
-void Timeline::updateGapsFromArray(float *array, size_t array_size)
+void Timeline::updateGapsFromArray(const float *array, size_t array_size)
 {
-    // reset gaps
-    gaps_.clear();
+    // reset gaps, keeping previous ones to compare
+    const uint64_t revision = revision_;
+    TimeIntervalSet previous;
+    previous.swap(gaps_);
 
     // fill the gaps from array
     if (array != nullptr && array_size > 0 && timing_.is_valid()) {
@@ -923,22 +1098,27 @@ void Timeline::updateGapsFromArray(float *array, size_t array_size)
 
     }
 
+    // unchanged gaps do not count as a new revision
+    if (gaps_ == previous)
+        revision_ = revision;
 }
 
-void Timeline::fillArrayFromGaps(float *array, size_t array_size)
+void Timeline::fillArrayFromGaps()
 {
-    // fill the array from gaps
-    if (array != nullptr && array_size > 0 && timing_.is_valid()) {
+    const size_t array_size = MAX_TIMELINE_ARRAY;
+
+    // clear array
+    gapsArray_.assign(array_size, 0.f);
 
-        // clear with static array
-        memcpy(gapsArray_, empty_zeros, MAX_TIMELINE_ARRAY * sizeof(float));
+    // fill the array from gaps
+    if (timing_.is_valid()) {
 
         // for each gap
         GstClockTime d = timing_.duration();
         for (auto it = gaps_.begin(); it != gaps_.end(); ++it)
         {
             size_t s = ( (*it).begin * array_size ) / d;
-            size_t e = ( (*it).end * array_size ) / d;
+            size_t e = MINI( ( (*it).end * array_size ) / d, array_size );
 
             // fill with 1 where there is a gap
             for (size_t i = s; i < e; ++i) {
@@ -961,10 +1141,10 @@ void Timeline::fillArrayFromGaps(float *array, size_t array_size)
 
 float *Timeline::flagsArray()
 {
-    if (flags_array_need_update_) {
-        fillArrayFromFlags(flagsArray_, MAX_TIMELINE_ARRAY);
+    if (flags_array_need_update_ || flagsArray_.empty()) {
+        fillArrayFromFlags();
     }
-    return flagsArray_;
+    return flagsArray_.data();
 }
 
 bool Timeline::addFlagAt(GstClockTime t, int type)
@@ -1112,24 +1292,26 @@ TimeInterval Timeline::getPreviousFlag(GstClockTime t) const
 void Timeline::clearFlags()
 {
     flags_.clear();
-    memcpy(flagsArray_, empty_zeros, MAX_TIMELINE_ARRAY * sizeof(float));
-
     flags_array_need_update_ = true;
 }
 
-void Timeline::fillArrayFromFlags(float *array, size_t array_size)
+void Timeline::fillArrayFromFlags()
 {
-    // fill the array from flags list
-    if (array != nullptr && array_size > 0 && timing_.is_valid()) {
+    const size_t array_size = MAX_TIMELINE_ARRAY;
 
-        // clear with static array
-        memcpy(flagsArray_, empty_zeros, MAX_TIMELINE_ARRAY * sizeof(float));
+    // clear array
+    flagsArray_.assign(array_size, 0.f);
+
+    // fill the array from flags list
+    if (timing_.is_valid()) {
 
         // for each flag
         GstClockTime d = timing_.duration();
         for (auto it = flags_.begin(); it != flags_.end(); ++it)
         {
             size_t e = ( ( (*it).begin + step_ + FLAG_MARGIN ) * array_size ) / d ;
+            if (e < 1 || e > array_size - 2)
+                continue;
 
             // fill with 1 where there is a flag
             if (e >= 2)
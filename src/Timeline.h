@@ -5,6 +5,7 @@
 #include <sstream>
 #include <set>
 #include <list>
+#include <vector>
 
 #include <gst/pbutils/pbutils.h>
 
@@ -102,17 +103,28 @@ struct order_comparator
 
 typedef std::set<TimeInterval, order_comparator> TimeIntervalSet;
 
+struct FadingKey
+{
+    GstClockTime time;
+    float value;
+};
+
+typedef std::vector<FadingKey> FadingKeys;
+
 
 class Timeline
 {
 public:
     Timeline();
+    Timeline(const Timeline &b);
     ~Timeline();
     Timeline& operator = (const Timeline& b);
 
     bool is_valid() const;
     void update();
     void refresh();
+    // incremented on every change of timing or gaps
+    inline uint64_t revision() const { return revision_; }
 
     // global properties of the timeline
     void setEnd(GstClockTime end);
@@ -173,9 +185,13 @@ public:
     // Manipulation of Fading
     float fadingAt(const GstClockTime t) const;
     size_t fadingIndexAt(const GstClockTime t) const;
-    inline float *fadingArray() { return fadingArray_; }
+    float *fadingArray();
+    void sampleFading(float *array, size_t array_size = MAX_TIMELINE_ARRAY) const;
+    inline const FadingKeys &fadingKeys() const { return fading_; }
+    void setFadingKeys(const FadingKeys &keys);
+    void setFadingArray(const float *array, size_t array_size);
     void clearFading();
-    bool fadingIsClear();
+    bool fadingIsClear() const;
 
     // Edit
     typedef enum {
@@ -206,23 +222,35 @@ private:
     GstClockTime first_;
     GstClockTime last_;
     GstClockTime step_;
+    uint64_t revision_;
 
     // main data structure containing list of gaps in the timeline
     TimeIntervalSet gaps_;    
-    float gapsArray_[MAX_TIMELINE_ARRAY];
+    // arrays for display are only allocated when requested
+    std::vector<float> gapsArray_;
     bool gaps_array_need_update_;
     // synchronize data structures
-    void updateGapsFromArray(float *array, size_t array_size);
-    void fillArrayFromGaps(float *array, size_t array_size);
+    void updateGapsFromArray(const float *array, size_t array_size);
+    void fillArrayFromGaps();
 
-    float fadingArray_[MAX_TIMELINE_ARRAY];
-    bool fading_array_changed_, fading_array_allones_;
+    // fading curve is a sorted list of keyframes, linearly interpolated
+    FadingKeys fading_;
+    std::vector<float> fadingArray_;
+    bool fading_array_need_update_;
+    // synchronize data structures
+    void replaceFading(GstClockTime a, GstClockTime b, const FadingKeys &keys);
+    void simplifyFading();
+    void updateFadingFromArray(const float *array, size_t array_size);
+    void fillArrayFromFading();
 
     TimeIntervalSet flags_;
-    float flagsArray_[MAX_TIMELINE_ARRAY];
+    std::vector<float> flagsArray_;
     bool flags_array_need_update_;
     // synchronize data structures
-    void fillArrayFromFlags(float *array, size_t array_size);
+    void fillArrayFromFlags();
+
+    // time of index i in an array covering the timeline
+    GstClockTime arrayTime(size_t i, size_t array_size = MAX_TIMELINE_ARRAY) const;
 };
 
 #endif // TIMELINE_H
@@ -12,6 +12,17 @@ namespace BaseToolkit
 // get integer with unique id
 uint64_t uniqueId();
 
+// combine the bytes of a value in a hash (FNV-1a), e.g. to detect change of state
+// start with h = BASETOOLKIT_HASH_SEED
+#define BASETOOLKIT_HASH_SEED 14695981039346656037ULL
+template<typename T>
+void hash(uint64_t &h, const T &value)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char *>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i)
+        h = (h ^ p[i]) * 1099511628211ULL;
+}
+
 // proposes a name that is not already in the list
 std::string uniqueName(const std::string &basename, std::list<std::string> existingnames);
 
@@ -24,7 +24,8 @@ typedef enum {
     UDP_JPEG = 1,
     UDP_H264 = 2,
     SHM_RAW  = 3,
-    DEFAULT  = 4
+    SHM_RING = 4,
+    DEFAULT  = 5
 } StreamProtocol;
 
 extern const char* stream_protocol_label[DEFAULT];
@@ -25,8 +25,9 @@
 #include <glib.h>
 #include <gst/transcoder/gsttranscoder.h>
 
-Transcoder::Transcoder(const std::string& input_filename)
+Transcoder::Transcoder(const std::string& input_filename, const std::string& output_filename)
     : input_filename_(input_filename)
+    , output_filename_(output_filename)
     , transcoder_(nullptr)
     , started_(false)
     , finished_(false)
@@ -34,7 +35,7 @@ Transcoder::Transcoder(const std::string& input_filename)
     , duration_(-1)
     , position_(0)
 {
-    // Output filename will be generated in start() based on options
+    // Output filename will be generated in start() based on options, if not given
 }
 
 Transcoder::~Transcoder()
@@ -121,8 +122,9 @@ bool Transcoder::start(const TranscoderOptions& options)
         return false;
     }
 
-    // Generate output filename based on options
-    output_filename_ = generateOutputFilename(input_filename_, options);
+    // Generate output filename based on options, if not given
+    if (output_filename_.empty())
+        output_filename_ = generateOutputFilename(input_filename_, options);
 
     // Check if input file exists
     struct stat buffer;
@@ -165,7 +167,9 @@ bool Transcoder::start(const TranscoderOptions& options)
     bool has_audio = false;
     bool source_interlaced = false;
     GstClockTime duration = GST_CLOCK_TIME_NONE;
+    guint frame_width = 0;
     guint frame_height = 0;
+    guint par_n = 1, par_d = 1;
 
     if (disc_info) {
         GstDiscovererResult result = gst_discoverer_info_get_result(disc_info);
@@ -192,7 +196,10 @@ bool Transcoder::start(const TranscoderOptions& options)
             if (source_video_bitrate == 0) {
                 source_video_bitrate = gst_discoverer_video_info_get_max_bitrate(vinfo);
             }
+            frame_width = gst_discoverer_video_info_get_width(vinfo);
             frame_height = gst_discoverer_video_info_get_height(vinfo);
+            par_n = gst_discoverer_video_info_get_par_num(vinfo);
+            par_d = gst_discoverer_video_info_get_par_denom(vinfo);
             source_interlaced = gst_discoverer_video_info_is_interlaced(vinfo);
             if (source_interlaced)
                 Log::Info("Transcoder: Source video is interlaced, deinterlacing will be applied");
@@ -243,6 +250,18 @@ bool Transcoder::start(const TranscoderOptions& options)
     // Apply a quality factor (1.05 = 5% higher to ensure no quality loss)
     const float quality_factor = 1.05f;
     target_video_bitrate = (guint)(target_video_bitrate * quality_factor / 1000); // convert to kbps
+
+    // Scaled output (only downscaling): compute even dimensions with square pixels
+    // and reduce bitrate in proportion of the number of pixels
+    guint scaled_width = 0, scaled_height = 0;
+    if (options.height > 0 && frame_height > (guint) options.height && frame_width > 0) {
+        double ratio = (double) options.height / (double) frame_height;
+        double par = par_d > 0 ? (double) par_n / (double) par_d : 1.0;
+        scaled_height = (guint) options.height & ~1u;
+        scaled_width = ((guint) (frame_width * par * ratio + 0.5)) & ~1u;
+        target_video_bitrate = MAX((guint)(target_video_bitrate * ratio * ratio), 500u);
+        Log::Info("Transcoder: Scaling video to %u x %u", scaled_width, scaled_height);
+    }
     Log::Info("Transcoder: Target video bitrate: %u kbps", target_video_bitrate);
 
     // Create encoding profile for H.264/AAC in MP4 container
@@ -296,8 +315,15 @@ bool Transcoder::start(const TranscoderOptions& options)
         g_object_set(x264_preset, "psy-tune", static_cast<int>(options.psy_tune), NULL);
     }
 
+    // Scaled output is meant for light decoding
+    if (scaled_height > 0) {
+        g_object_set(x264_preset, "speed-preset", 3, NULL);  // veryfast
+        g_object_set(x264_preset, "tune", 0x00000002, NULL);  // fastdecode
+    }
+
     // Save the preset to filesystem
-    const gchar *preset_name = "vimix_x264_transcoding";
+    // (distinct name for scaled output, which can run concurrently)
+    const gchar *preset_name = scaled_height > 0 ? "vimix_x264_scaling" : "vimix_x264_transcoding";
     
     if (!gst_preset_save_preset(GST_PRESET(x264_preset), preset_name)) {
         error_message_ = "Failed to save x264enc preset";
@@ -315,6 +341,16 @@ bool Transcoder::start(const TranscoderOptions& options)
     // Set video profile presence to always encode
     gst_encoding_profile_set_presence(GST_ENCODING_PROFILE(video_profile), 1);
 
+    // Restrict raw video to the scaled dimensions (takes ownership of caps)
+    if (scaled_height > 0) {
+        GstCaps *restriction = gst_caps_new_simple("video/x-raw",
+                                                   "width", G_TYPE_INT, (gint) scaled_width,
+                                                   "height", G_TYPE_INT, (gint) scaled_height,
+                                                   "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+                                                   NULL);
+        gst_encoding_profile_set_restriction(GST_ENCODING_PROFILE(video_profile), restriction);
+    }
+
     // Add video profiles to container
     gst_encoding_container_profile_add_profile(container_profile,
                                                GST_ENCODING_PROFILE(video_profile));
@@ -383,7 +419,8 @@ bool Transcoder::start(const TranscoderOptions& options)
     transcoder_ = G_OBJECT(transcoder);
 
     // transcoder should try to avoid reencoding streams where reencoding is not strictly needed
-    gst_transcoder_set_avoid_reencoding(transcoder, true);
+    // (not when scaling, which always requires reencoding video)
+    gst_transcoder_set_avoid_reencoding(transcoder, scaled_height == 0);
 
     // If the source is interlaced, request deinterlacing. 
     // set 'video-filter' property of transcoder to a deinterlace element via
@@ -24,6 +24,7 @@ struct TranscoderOptions {
     PsyTuning psy_tune;      ///< Psycho-visual tuning preset
     int crf;                 ///< Constant Rate Factor (0-51, 0=lossless, 23=default, -1=use bitrate mode)
     bool force_no_audio;     ///< Force removal of audio stream (create video-only output)
+    int height;              ///< Scale video to this height (0=keep source resolution), e.g. for proxies
 
     /**
      * @brief Default constructor with sensible defaults
@@ -31,11 +32,13 @@ struct TranscoderOptions {
     TranscoderOptions(bool force_keyframes = true
                     , PsyTuning psy_tune = PsyTuning::NONE
                     , int crf = -1
-                    , bool force_no_audio = false)
+                    , bool force_no_audio = false
+                    , int height = 0)
         : force_keyframes(force_keyframes)
         , psy_tune(psy_tune)
         , crf(crf)  // -1 = use bitrate mode (default)
         , force_no_audio(force_no_audio)
+        , height(height)  // 0 = no scaling (default)
     {}
 };
 
@@ -51,11 +54,13 @@ public:
     /**
      * @brief Construct a new Transcoder
      * @param input_filename Path to the input video file
+     * @param output_filename Path to the output video file (optional)
      *
-     * The output filename will be automatically generated in the same folder
-     * with "_transcoded.mp4" suffix, ensuring it doesn't overwrite existing files.
+     * If no output filename is given, it will be automatically generated in the
+     * same folder with "_transcoded.mp4" suffix, ensuring it doesn't overwrite
+     * existing files.
      */
-    Transcoder(const std::string& input_filename);
+    Transcoder(const std::string& input_filename, const std::string& output_filename = "");
 
     /**
      * @brief Destroy the Transcoder and clean up resources
@@ -83,6 +83,7 @@
 #include "Playlist.h"
 #include "FrameGrabbing.h"
 #include "Canvas.h"
+#include "Profiler.h"
 
 #include "UserInterfaceManager.h"
 
@@ -978,6 +979,8 @@ void UserInterface::NewFrame()
 
 void UserInterface::Render()
 {
+    ProfileZone zone("GUI");
+
     // navigator bar first
     navigator.Render();
 
@@ -1291,6 +1294,9 @@ void UserInterface::showMenuFile()
     const bool currentfileopen = !currentfilename.empty();
 
     ImGui::MenuItem( MENU_OPEN_ON_START, nullptr, &Settings::application.recentSessions.load_at_start);
+    ImGui::MenuItem( MENU_JOURNAL, nullptr, &Settings::application.session_journal);
+    if (ImGui::IsItemHovered())
+        ImGuiToolkit::ToolTip("Keep a journal of changes to recover the session if vimix is interrupted.");
 
     if (ImGui::MenuItem( MENU_OPEN_FILE, SHORTCUT_OPEN_FILE))
         selectOpenFilename();
@@ -1671,7 +1677,8 @@ enum MetricsFlags_
     Metrics_gpu        = 4,
     Metrics_session    = 8,
     Metrics_runtime    = 16,
-    Metrics_lifetime   = 32
+    Metrics_lifetime   = 32,
+    Metrics_drawcalls  = 64
 };
 
 void UserInterface::RenderMetrics(bool *p_open, int* p_corner, int *p_mode)
@@ -1803,8 +1810,40 @@ void UserInterface::RenderMetrics(bool *p_open, int* p_corner, int *p_mode)
             ImGuiToolkit::ToolTip("Accumulated runtime of vimix\nsince its installation");
     }
 
+    if (*p_mode & Metrics_drawcalls) {
+        ImGuiToolkit::PushFont(ImGuiToolkit::FONT_BOLD);
+        snprintf(dummy_str, 256, "%u", Mixer::manager().drawCalls());
+        ImGui::SetNextItemWidth(_width);
+        ImGui::InputText("##dummy4", dummy_str, IM_ARRAYSIZE(dummy_str), ImGuiInputTextFlags_ReadOnly);
+        ImGui::PopFont();
+        ImGui::SameLine(0, IMGUI_SAME_LINE);
+        ImGui::Text("Draws");
+        if (ImGui::IsItemHovered())
+            ImGuiToolkit::ToolTip("Number of draw calls\nto render the current view");
+    }
+
     ImGui::PopStyleVar();
 
+    // CPU and GPU time of stages of the rendering loop
+    if (Profiler::manager().enabled()) {
+        ImGui::Separator();
+        std::vector<Profiler::Statistics> stats = Profiler::manager().statistics();
+        ImGuiToolkit::PushFont(ImGuiToolkit::FONT_MONO);
+        ImGui::TextDisabled("%-24s %7s %7s", "Profiler (ms)", "CPU", "GPU");
+        for (auto s = stats.begin(); s != stats.end(); ++s) {
+            std::string label = std::string(2 * s->depth, ' ') + s->name;
+            if (!s->label.empty())
+                label += " " + s->label;
+            if (label.size() > 24)
+                label = label.substr(0, 23) + "~";
+            if (s->gpu < 0.0)
+                ImGui::Text("%-24s %7.2f %7s", label.c_str(), s->cpu, "-");
+            else
+                ImGui::Text("%-24s %7.2f %7.2f", label.c_str(), s->cpu, s->gpu);
+        }
+        ImGui::PopFont();
+    }
+
     if (ImGui::BeginPopup("metrics_menu"))
     {
         if (ImGui::MenuItem( "Framerate", NULL, *p_mode & Metrics_framerate))
@@ -1821,6 +1860,15 @@ void UserInterface::RenderMetrics(bool *p_open, int* p_corner, int *p_mode)
             *p_mode ^= Metrics_runtime;
         if (ImGui::MenuItem( "Lifetime", NULL, *p_mode & Metrics_lifetime))
             *p_mode ^= Metrics_lifetime;
+        if (ImGui::MenuItem( "Draw calls", NULL, *p_mode & Metrics_drawcalls))
+            *p_mode ^= Metrics_drawcalls;
+
+        ImGui::Separator();
+
+        if (ImGui::MenuItem( ICON_FA_STOPWATCH "  Profiler", NULL, Profiler::manager().enabled()))
+            Profiler::manager().setEnabled( !Profiler::manager().enabled() );
+        if (ImGui::MenuItem( ICON_FA_FILE_EXPORT "  Export trace", NULL, false, Profiler::manager().enabled()))
+            Profiler::manager().requestExport();
 
         ImGui::Separator();
 
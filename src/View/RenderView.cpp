@@ -29,6 +29,7 @@
 #include "defines.h"
 #include "Settings.h"
 #include "Scene/Primitives.h"
+#include "Visitor/CompositingVisitor.h"
 
 #include "RenderView.h"
 
@@ -85,7 +86,8 @@ glm::ivec2 RenderView::presetFromResolution(glm::vec3 resolution)
     return ret;
 }
 
-RenderView::RenderView() : View(RENDERING), frame_buffer_(nullptr), fading_overlay_(nullptr), frame_thumbnail_(nullptr)
+RenderView::RenderView() : View(RENDERING), frame_buffer_(nullptr), fading_overlay_(nullptr),
+    passes_saved_(0), frame_thumbnail_(nullptr)
 {
 }
 
@@ -155,7 +157,16 @@ void RenderView::draw()
 
         // render the scene normally (pre-multiplied alpha in RGB)
         frame_buffer_->begin();
-        scene.root()->draw(glm::identity<glm::mat4>(), P);
+        if (Settings::application.render.batch_compositing) {
+            // composite consecutive layers in single passes
+            CompositingVisitor compositor(P);
+            scene.accept(compositor);
+            passes_saved_ = compositor.numLayers() - compositor.numPasses();
+        }
+        else {
+            scene.root()->draw(glm::identity<glm::mat4>(), P);
+            passes_saved_ = 0;
+        }
         fading_overlay_->draw(glm::identity<glm::mat4>(), projection);
         frame_buffer_->end();
     }
@@ -14,6 +14,7 @@ class RenderView : public View
     // rendering FBO
     FrameBuffer *frame_buffer_;
     Surface *fading_overlay_;
+    uint passes_saved_;
 
     // promises of returning thumbnails after an update
     std::vector< std::promise<FrameBufferImage *> > thumbnailer_;
@@ -32,6 +33,9 @@ public:
     // current frame
     inline FrameBuffer *frame () const { return frame_buffer_; }
 
+    // number of blending passes saved by batch compositing in last frame
+    inline uint passesSaved () const { return passes_saved_; }
+
     // size descriptions
     enum AspectRatio {
         AspectRatio_4_3 = 0,
@@ -0,0 +1,295 @@
+/*
+ * This file is part of vimix - video live mixer
+ *
+ * **Copyright** (C) 2019-2024 Bruno Herbelin <bruno.herbelin@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program. If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include <string>
+
+#include <glad/glad.h>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include "defines.h"
+#include "Resource.h"
+#include "FrameBuffer.h"
+#include "ImageShader.h"
+#include "Scene/Scene.h"
+#include "Scene/Primitives.h"
+#include "Scene/Decorations.h"
+
+#include "CompositingVisitor.h"
+
+ShadingProgram compositingShadingProgram("shaders/simple.vs", "shaders/compositing.fs");
+
+///
+/// \brief The CompositingShader draws a full viewport surface
+/// with the layers to composite
+///
+class CompositingShader : public Shader
+{
+public:
+    CompositingShader() : Shader(), program_id_(0) {
+        program_ = &compositingShadingProgram;
+        Shader::reset();
+    }
+
+    void use() override;
+
+    struct Layer {
+        uint texture;
+        uint mask;
+        glm::mat4 inverse;
+        glm::mat4 transform;
+        glm::vec4 color;
+        float premultiply;
+    };
+    std::vector<Layer> layers;
+
+private:
+    // uniform locations, looked up once for the program
+    uint program_id_;
+    int iLayers_, iInverse_, iTexture_, iColor_, iPremultiply_;
+};
+
+void CompositingShader::use()
+{
+    // draw with identity projection and modelview, blending opacity
+    Shader::use();
+
+    // first use of the (compiled) program
+    if ( program_id_ != program_->id() ) {
+        program_id_ = program_->id();
+        iLayers_ = program_->location("iLayers");
+        iInverse_ = program_->location("iInverse");
+        iTexture_ = program_->location("iTexture");
+        iColor_ = program_->location("iColor");
+        iPremultiply_ = program_->location("iPremultiply");
+
+        // textures in units [0 7] and masks in units [8 15]
+        for (int i = 0; i < COMPOSITING_MAX_LAYERS; ++i) {
+            program_->setUniform("iChannel" + std::to_string(i), i);
+            program_->setUniform("iMask" + std::to_string(i), i + COMPOSITING_MAX_LAYERS);
+        }
+    }
+
+    // uniform arrays of the layers
+    const GLsizei n = (GLsizei) MINI(layers.size(), (size_t) COMPOSITING_MAX_LAYERS);
+    glm::mat4 inverse[COMPOSITING_MAX_LAYERS];
+    glm::mat4 transform[COMPOSITING_MAX_LAYERS];
+    glm::vec4 color[COMPOSITING_MAX_LAYERS];
+    float premultiply[COMPOSITING_MAX_LAYERS];
+
+    for (GLsizei i = 0; i < n; ++i) {
+        inverse[i] = layers[i].inverse;
+        transform[i] = layers[i].transform;
+        color[i] = layers[i].color;
+        premultiply[i] = layers[i].premultiply;
+
+        // NB: frame buffer and mask textures are created with clamp to edge wrapping
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, layers[i].texture);
+        glActiveTexture(GL_TEXTURE0 + i + COMPOSITING_MAX_LAYERS);
+        glBindTexture(GL_TEXTURE_2D, layers[i].mask);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    glUniform1i(iLayers_, n);
+    glUniformMatrix4fv(iInverse_, n, GL_FALSE, glm::value_ptr(inverse[0]));
+    glUniformMatrix4fv(iTexture_, n, GL_FALSE, glm::value_ptr(transform[0]));
+    glUniform4fv(iColor_, n, glm::value_ptr(color[0]));
+    glUniform1fv(iPremultiply_, n, premultiply);
+}
+
+
+CompositingVisitor::CompositingVisitor(glm::mat4 projection):
+    modelview_(glm::identity<glm::mat4>()), projection_(projection), num_passes_(0), num_layers_(0)
+{
+
+}
+
+bool CompositingVisitor::batch(FrameBufferMeshSurface *surface)
+{
+    if ( !surface->initialized() || surface->frameBuffer() == nullptr )
+        return false;
+
+    // only the normal blending of the image shader, without stippling or distortion
+    ImageShader *shader = dynamic_cast<ImageShader *>(surface->shader());
+    if ( shader == nullptr || shader->stipple > 0.f || shader->iNodes != glm::zero<glm::mat4>() )
+        return false;
+    if ( shader->blending != Shader::BLEND_OPACITY && !Shader::force_blending_opacity )
+        return false;
+
+    // orthographic projection of the surface in the viewport
+    glm::mat4 layer = modelview_ * surface->transform_;
+    glm::mat4 M = projection_ * layer;
+
+    // surface would be clipped by the depth range
+    if ( ABS(M[3].z) > 1.f )
+        return false;
+
+    // inverse of the 2D affine transform from surface to viewport
+    if ( ABS(M[0].x * M[1].y - M[1].x * M[0].y) < EPSILON )
+        return false;
+    glm::mat4 A = glm::identity<glm::mat4>();
+    A[0] = glm::vec4(M[0].x, M[0].y, 0.f, 0.f);
+    A[1] = glm::vec4(M[1].x, M[1].y, 0.f, 0.f);
+    A[3] = glm::vec4(M[3].x, M[3].y, 0.f, 1.f);
+
+    layers_.push_back( { surface, modelview_, glm::inverse(A) } );
+
+    if ( layers_.size() >= COMPOSITING_MAX_LAYERS )
+        flush();
+
+    return true;
+}
+
+void CompositingVisitor::flush()
+{
+    if ( layers_.empty() )
+        return;
+
+    num_layers_ += layers_.size();
+    num_passes_ += 1;
+
+    // a single layer is drawn normally
+    if ( layers_.size() == 1 ) {
+        layers_.front().surface->draw(layers_.front().modelview, projection_);
+        layers_.clear();
+        return;
+    }
+
+    // surface covering the viewport, created in OpenGL context
+    static CompositingShader *compositing = nullptr;
+    static Surface *viewport = nullptr;
+    if ( viewport == nullptr ) {
+        compositing = new CompositingShader;
+        viewport = new Surface(compositing);
+    }
+
+    compositing->layers.clear();
+    for (auto l = layers_.begin(); l != layers_.end(); ++l) {
+        ImageShader *shader = static_cast<ImageShader *>(l->surface->shader());
+        // without mask, use white (the shader of the source is left unchanged)
+        uint mask = shader->secondary_texture ? shader->secondary_texture : Resource::getTextureWhite();
+        compositing->layers.push_back( { l->surface->frameBuffer()->texture(), mask,
+                                         l->inverse, shader->iTransform, shader->color, shader->premultiply } );
+    }
+
+    viewport->draw(glm::identity<glm::mat4>(), glm::identity<glm::mat4>());
+
+    // unbind textures
+    for (size_t i = 0; i < compositing->layers.size(); ++i) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glActiveTexture(GL_TEXTURE0 + i + COMPOSITING_MAX_LAYERS);
+        glBindTexture(GL_TEXTURE_2D, 0);
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    layers_.clear();
+}
+
+void CompositingVisitor::visit(Scene &n)
+{
+    modelview_ = glm::identity<glm::mat4>();
+    num_passes_ = 0;
+    num_layers_ = 0;
+
+    n.root()->accept(*this);
+
+    // draw remaining layers
+    flush();
+}
+
+void CompositingVisitor::visit(Group &n)
+{
+    if ( !n.initialized() )
+        n.init();
+
+    if ( !n.visible_ )
+        return;
+
+    // traverse children with the ctm of the group
+    glm::mat4 mv = modelview_;
+    for (NodeSet::iterator node = n.begin(); node != n.end(); ++node) {
+        modelview_ = mv * n.transform_;
+        (*node)->accept(*this);
+    }
+    modelview_ = mv;
+}
+
+void CompositingVisitor::visit(Switch &n)
+{
+    if ( !n.initialized() )
+        n.init();
+
+    if ( !n.visible_ || n.numChildren() < 1 )
+        return;
+
+    // traverse active child
+    glm::mat4 mv = modelview_;
+    modelview_ = mv * n.transform_;
+    n.activeChild()->accept(*this);
+    modelview_ = mv;
+}
+
+void CompositingVisitor::visit(Primitive &n)
+{
+    if ( !n.visible_ )
+        return;
+
+    // add the surface of a frame buffer to the layers to composite
+    FrameBufferMeshSurface *surface = dynamic_cast<FrameBufferMeshSurface *>(&n);
+    if ( surface != nullptr && batch(surface) )
+        return;
+
+    // otherwise draw after previous layers
+    flush();
+    n.draw(modelview_, projection_);
+    num_layers_ += 1;
+    num_passes_ += 1;
+}
+
+void CompositingVisitor::visit(Frame &n)
+{
+    flush();
+    n.draw(modelview_, projection_);
+}
+
+void CompositingVisitor::visit(Handles &n)
+{
+    flush();
+    n.draw(modelview_, projection_);
+}
+
+void CompositingVisitor::visit(Symbol &n)
+{
+    flush();
+    n.draw(modelview_, projection_);
+}
+
+void CompositingVisitor::visit(Disk &n)
+{
+    flush();
+    n.draw(modelview_, projection_);
+}
+
+void CompositingVisitor::visit(Character &n)
+{
+    flush();
+    n.draw(modelview_, projection_);
+}
@@ -0,0 +1,59 @@
+#ifndef COMPOSITINGVISITOR_H
+#define COMPOSITINGVISITOR_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Visitor.h"
+
+#define COMPOSITING_MAX_LAYERS 8
+
+class FrameBufferMeshSurface;
+
+///
+/// \brief The CompositingVisitor draws a scene like Group::draw, but
+/// consecutive surfaces of frame buffers blended normally (e.g. sources
+/// in the RenderView) are composited together in a single pass of a shader
+/// sampling up to COMPOSITING_MAX_LAYERS textures.
+///
+/// Other nodes (other blending modes, stippling, distortion of shape)
+/// are drawn individually, in order.
+///
+class CompositingVisitor : public Visitor
+{
+    glm::mat4 modelview_;
+    glm::mat4 projection_;
+
+    struct Layer {
+        FrameBufferMeshSurface *surface;
+        glm::mat4 modelview;
+        glm::mat4 inverse;
+    };
+    std::vector<Layer> layers_;
+    uint num_passes_;
+    uint num_layers_;
+
+    bool batch(FrameBufferMeshSurface *surface);
+    void flush();
+
+public:
+    CompositingVisitor(glm::mat4 projection);
+
+    // number of surfaces drawn and number of passes to draw them
+    inline uint numLayers () const { return num_layers_; }
+    inline uint numPasses () const { return num_passes_; }
+
+    void visit(Scene& n) override;
+    void visit(Node& ) override {}
+    void visit(Group& n) override;
+    void visit(Switch& n) override;
+    void visit(Primitive& n) override;
+
+    // decorations are drawn individually
+    void visit(Frame& n) override;
+    void visit(Handles& n) override;
+    void visit(Symbol& n) override;
+    void visit(Disk& n) override;
+    void visit(Character& n) override;
+};
+
+#endif // COMPOSITINGVISITOR_H
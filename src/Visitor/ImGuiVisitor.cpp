@@ -734,6 +734,12 @@ void ImGuiVisitor::renderAudioPanel(MediaSource &s)
                 ImGui::EndPopup();
             }
         }
+
+        // level meter of the source in the audio mixing bus
+        if (audio_is_on && s.mediaplayer()->audioMixing()) {
+            ImGui::ProgressBar(s.mediaplayer()->audioLevel(),
+                               ImVec2(ImGui::GetContentRegionAvail().x IMGUI_RIGHT_ALIGN, 0.25f * ImGui::GetFrameHeight()), "");
+        }
     }
     
 }
@@ -964,6 +970,17 @@ void ImGuiVisitor::visit (SessionFileSource& s)
             botom = ImGui::GetCursorPos();
         }
 
+        // share session with other sources of the same file
+        ImGui::SetCursorPos(botom);
+        bool _shared = s.shared();
+        if (ImGuiToolkit::ButtonSwitch("Shared", &_shared,
+                                       "Load and render the session once\nfor all sources of the same file")) {
+            s.setShared(_shared);
+            oss << (s.shared() ? "Shared session" : "Unshared session");
+            Action::manager().store(oss.str());
+        }
+        botom = ImGui::GetCursorPos();
+
         ImGui::SetCursorPos(top);
         if (ImGuiToolkit::IconButton(3, 5, "Show in finder"))
             SystemToolkit::open(SystemToolkit::path_filename(s.path()));
@@ -1995,6 +2012,15 @@ void ImGuiVisitor::visit (MultiFileSource& s)
             _fps = -1;
         }
 
+        // keep all images of the range decoded in memory
+        bool _cache = s.memoryCache();
+        if (ImGuiToolkit::ButtonSwitch("Cache in memory", &_cache,
+                                       "Decode all images of the range\nin memory for instant access")) {
+            s.setMemoryCache(_cache);
+            oss << (s.memoryCache() ? "Cache in memory" : "No cache in memory");
+            Action::manager().store(oss.str());
+        }
+
         botom = ImGui::GetCursorPos();
 
         // icon (>) to open player
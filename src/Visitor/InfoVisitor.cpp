@@ -110,6 +110,8 @@ void InfoVisitor::visit(MediaPlayer &mp)
                             oss << " (1 every " << mp.evaluation().gop_size_max << " frames, ";
                         if (mp.evaluation().gop_size_max < 1 )
                             oss << "cannot play backward)";
+                        else if (mp.reverseCacheAvailable())
+                            oss << "can play backward from cache)";
                         else if (mp.evaluation().gop_size_max * mp.height() > 35000 || mp.evaluation().has_bframes)
                             oss << "hard to play backward)";
                         else
@@ -187,6 +189,8 @@ void InfoVisitor::visit (SessionFileSource& s)
             oss << s.path() << std::endl;
             oss << "Child session (" << numsource << "), RGB" << std::endl;
             oss << s.session()->frame()->width() << " x " << s.session()->frame()->height();
+            if (s.shared())
+                oss << std::endl << "Shared by " << s.sharedCount() << " sources";
         }
 
         current_id_ = s.id();
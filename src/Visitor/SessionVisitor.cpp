@@ -447,6 +447,7 @@ void SessionVisitor::visit(MediaPlayer &n)
         newelement->SetAttribute("speed", n.playSpeed());
         newelement->SetAttribute("video_effect", n.videoEffect().c_str());
         newelement->SetAttribute("software_decoding", n.softwareDecodingForced());
+        newelement->SetAttribute("clip_cache", n.clipCache());
         newelement->SetAttribute("sync_to_metronome", (int) n.syncToMetronome());
 
         // timeline
@@ -468,7 +469,17 @@ void SessionVisitor::visit(MediaPlayer &n)
 
         // fading in timeline
         XMLElement *fadingelement = xmlDoc_->NewElement("Fading");
-        XMLElement *array = XMLElementEncodeArray(xmlDoc_, n.timeline()->fadingArray(), MAX_TIMELINE_ARRAY * sizeof(float));
+        const FadingKeys &keys = n.timeline()->fadingKeys();
+        for( auto it = keys.begin(); it!= keys.end(); ++it) {
+            XMLElement *k = xmlDoc_->NewElement("Key");
+            k->SetAttribute("time", (uint64_t) (*it).time);
+            k->SetAttribute("value", (*it).value);
+            fadingelement->InsertEndChild(k);
+        }
+        // sampled array, read by older versions
+        float fading[MAX_TIMELINE_ARRAY];
+        n.timeline()->sampleFading(fading);
+        XMLElement *array = XMLElementEncodeArray(xmlDoc_, fading, MAX_TIMELINE_ARRAY * sizeof(float));
         fadingelement->InsertEndChild(array);
         timelineelement->InsertEndChild(fadingelement);
 
@@ -712,6 +723,7 @@ void SessionVisitor::visit (SessionFileSource& s)
     xmlCurrent_->SetAttribute("type", "SessionSource");
     if (s.session() != nullptr)
         xmlCurrent_->SetAttribute("fading", s.session()->fading());
+    xmlCurrent_->SetAttribute("shared", s.shared());
 
     XMLElement *path = xmlDoc_->NewElement("path");
     xmlCurrent_->InsertEndChild(path);
@@ -725,7 +737,9 @@ void SessionVisitor::visit (SessionFileSource& s)
 void SessionVisitor::visit (SessionGroupSource& s)
 {
     xmlCurrent_->SetAttribute("type", "GroupSource");
-    xmlCurrent_->SetAttribute("height", (float) s.frame()->height());
+    // height of the frame at full level of detail
+    float height = s.nativeResolution().y > 0.f ? s.nativeResolution().y : (float) s.frame()->height();
+    xmlCurrent_->SetAttribute("height", height);
 
     XMLElement *center = xmlDoc_->NewElement("center");
     center->InsertEndChild( XMLElementFromGLM(xmlDoc_, s.center()) );
@@ -1001,6 +1015,7 @@ void SessionVisitor::visit (MultiFileSource& s)
     sequence->SetAttribute("begin", s.begin());
     sequence->SetAttribute("end", s.end());
     sequence->SetAttribute("loop", s.loop());
+    sequence->SetAttribute("memory_cache", s.memoryCache());
     // file sequence description
     sequence->SetAttribute("min", s.sequence().min);
     sequence->SetAttribute("max", s.sequence().max);
@@ -2525,6 +2525,10 @@ void SourceControlWindow::RenderMediaPlayer(MediaSource *ms)
             ms->setReplayOnDeactivate(option);
         }
 
+        option = mediaplayer_active_->clipCache();
+        if (ImGui::MenuItem(ICON_FA_MEMORY "  Cache in memory", NULL, &option ))
+            mediaplayer_active_->setClipCache(option);
+
         if (ImGui::IsWindowHovered())
             counter_menu_timeout=0;
         else if (++counter_menu_timeout > 10)
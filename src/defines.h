@@ -188,6 +188,7 @@
 #define MENU_SAVEAS_FILE      ICON_FA_FILE_DOWNLOAD "  Save as"
 #define MENU_SAVE_ON_EXIT     ICON_FA_LEVEL_DOWN_ALT "  Save on exit"
 #define MENU_OPEN_ON_START    ICON_FA_LEVEL_UP_ALT "  Restore on start"
+#define MENU_JOURNAL          ICON_FA_HISTORY "  Autosave journal"
 #define SHORTCUT_SAVEAS_FILE  CTRL_MOD "Shift+S"
 #define MENU_EXPORT_SETTINGS  ICON_FA_FILE_EXCEL "  Export settings"
 #define MENU_QUIT             ICON_FA_POWER_OFF "  Quit"
@@ -35,6 +35,7 @@
 #include "Audio.h"
 #include "VideoBroadcast.h"
 #include "FrameGrabbing.h"
+#include "Benchmark.h"
 
 #if defined(APPLE)
 extern "C"{
@@ -76,6 +77,8 @@ int main(int argc, char *argv[])
     int helpRequested = 0;
     int fontsizeRequested = 0;
     int broadcastRequested = 0;
+    int benchmarkRequested = 0;
+    std::vector<Benchmark::Configuration> benchmarkConfigurations;
     std::string settingsRequested;
     int ret = -1;
 
@@ -84,6 +87,16 @@ int main(int argc, char *argv[])
             versionRequested = 1;
         } else if (strcmp(argv[i], "--test") == 0 || strcmp(argv[i], "-T") == 0) {
             testRequested = 1;
+        } else if (strcmp(argv[i], "--benchmark") == 0 || strcmp(argv[i], "-K") == 0) {
+            benchmarkRequested = 1;
+            // optional configurations argument
+            if (i + 1 < argc && argv[i + 1][0] != '-' && strchr(argv[i + 1], ':') != nullptr) {
+                if (!Benchmark::parse(argv[i + 1], benchmarkConfigurations)) {
+                    fprintf(stderr, "Error: Invalid benchmark configuration '%s'\n", argv[i + 1]);
+                    helpRequested = 1;
+                }
+                i++; // Skip the next argument since it's already processed
+            }
         } else if (strcmp(argv[i], "--clean") == 0 || strcmp(argv[i], "-C") == 0) {
             cleanRequested = 1;
         } else if (strcmp(argv[i], "--headless") == 0 || strcmp(argv[i], "-L") == 0) {
@@ -153,6 +166,19 @@ int main(int argc, char *argv[])
         }
     }
 
+    if (benchmarkRequested && !helpRequested) {
+        if (!Rendering::manager().init()) {
+            fprintf(stderr, "%s: benchmark Failed\n", argv[0]);
+            ret = 1;
+        }
+        else {
+            if (benchmarkConfigurations.empty())
+                benchmarkConfigurations = Benchmark::suite();
+            printf("%s", Benchmark::run(benchmarkConfigurations).c_str());
+            ret = 0;
+        }
+    }
+
     if (cleanRequested) {
         // clean settings : save settings before loading
         Settings::terminate();
@@ -162,7 +188,7 @@ int main(int argc, char *argv[])
 
     if (helpRequested) {
         printf("Usage: %s [-H, --help] [-V, --version] [-F, --fontsize] [-L, --headless] [-B, --broadcast]\n"
-               "               [-S, --settings] [-T, --test] [-C, --clean] [filename]\n",
+               "               [-S, --settings] [-T, --test] [-K, --benchmark] [-C, --clean] [filename]\n",
                argv[0]);
         printf("Options:\n");
         printf("  --help       : Display usage information\n");
@@ -172,6 +198,10 @@ int main(int argc, char *argv[])
         printf("  --headless   : Run without GUI (only if output windows configured)\n");
         printf("  --broadcast  : Starts network broadcasting on given port, e.g., '-B 7070'\n");
         printf("  --test       : Run rendering test and return\n");
+        printf("  --benchmark  : Run rendering benchmark, print JSON report and return\n"
+               "                 optional list of 'N:WxH[:frames]' with N sources of each kind\n"
+               "                 (pattern, shader, clone, filter), e.g., '-K 8:1920x1080,4:3840x2160:120'\n"
+               "                 (use LIBGL_ALWAYS_SOFTWARE=1 for software rendering)\n");
         printf("  --clean      : Reset user settings\n");
         printf("Filename:\n");
         printf("  vimix session file (.mix extension)\n");
@@ -277,6 +307,11 @@ int main(int argc, char *argv[])
     Mixer::manager().terminate();
     Canvas::manager().terminate();
 
+    ///
+    /// AUDIO TERMINATE
+    ///
+    Audio::manager().terminate();
+
     ///
     /// RENDERING TERMINATE
     ///